@@ -0,0 +1,57 @@
+#include "benchmark_util.h"
+#include "common/logger.h"
+#include <cstddef>
+
+// Counts every heap allocation so each benchmark can report allocs/op.
+// malloc itself is replaced, not just operator new, so allocations inside
+// C libraries (OpenSSL, hiredis) are counted too; operator new reaches
+// malloc as well. The replacements forward to glibc's own entry points.
+// Per thread, so threads of a multi-threaded benchmark (and background
+// threads) do not add to each other's counts.
+static thread_local uint64_t t_allocations = 0;
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+void* malloc(size_t size) noexcept {
+    t_allocations++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    t_allocations++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) noexcept {
+    t_allocations++;
+    return __libc_realloc(p, size);
+}
+
+} // extern "C"
+
+namespace ourchat {
+namespace bench {
+
+uint64_t AllocationCount() {
+    return t_allocations;
+}
+
+} // namespace bench
+} // namespace ourchat
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    // Code under test logs through the global logger; keep it out of the
+    // report.
+    ourchat::Logger::GetInstance()->SetLogLevel(ourchat::LogLevel::WARN);
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
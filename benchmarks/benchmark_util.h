@@ -0,0 +1,26 @@
+#ifndef OURCHAT_BENCHMARK_UTIL_H
+#define OURCHAT_BENCHMARK_UTIL_H
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+namespace ourchat {
+namespace bench {
+
+// Allocations made by the calling thread so far; benchmark_main.cpp
+// replaces malloc, calloc and realloc to count them.
+uint64_t AllocationCount();
+
+// Reports the calling thread's allocations per iteration since `before` as
+// allocs_per_op, averaged over the benchmark's threads.
+inline void ReportAllocations(benchmark::State& state, uint64_t before) {
+    if (state.iterations() == 0) return;
+    state.counters["allocs_per_op"] = benchmark::Counter(
+        static_cast<double>(AllocationCount() - before) / state.iterations(),
+        benchmark::Counter::kAvgThreads);
+}
+
+} // namespace bench
+} // namespace ourchat
+
+#endif // OURCHAT_BENCHMARK_UTIL_H
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Compare two Google Benchmark JSON reports.
+
+    microbenchmarks --benchmark_repetitions=5 \
+        --benchmark_report_aggregates_only=true \
+        --benchmark_out=current.json --benchmark_out_format=json
+    benchmarks/compare.py benchmarks/baseline.json current.json
+
+Medians are compared when the reports have repetitions, otherwise the
+single run. A benchmark regresses when its time grows by more than
+--threshold percent or when it allocates more per operation. Exits 1 if
+anything regressed, so it can gate CI on a quiet machine.
+
+Runs with more threads than the report's machine has CPUs measure the
+scheduler rather than the code, so they are listed but never compared.
+Record the baseline on a quiet multi-core host with a release build.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+UNIT_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+
+    cpus = report.get("context", {}).get("num_cpus") or 0
+    runs = {}
+    oversubscribed = set()
+    for entry in report.get("benchmarks", []):
+        if entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        if cpus and entry.get("threads", 1) > cpus:
+            oversubscribed.add(name)
+            continue
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") != "median":
+                continue
+        elif name in runs:
+            # Repetitions without aggregates: keep the first.
+            continue
+        scale = UNIT_NS[entry.get("time_unit", "ns")]
+        runs[name] = {
+            "real_time": entry["real_time"] * scale,
+            "cpu_time": entry["cpu_time"] * scale,
+            "allocs_per_op": entry.get("allocs_per_op"),
+        }
+    return report.get("context", {}), runs, oversubscribed
+
+
+def format_ns(value):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if value >= scale:
+            return "%.2f %s" % (value / scale, unit)
+    return "%.1f ns" % value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed slowdown in percent (default 10)")
+    parser.add_argument("--metric", choices=("real_time", "cpu_time"), default="real_time",
+                        help="time to compare; multi-threaded benchmarks use real time")
+    parser.add_argument("--filter", default="", help="only compare names matching this regex")
+    args = parser.parse_args()
+
+    base_context, baseline, base_skipped = load(args.baseline)
+    context, current, skipped = load(args.current)
+    name_filter = re.compile(args.filter)
+
+    for key in ("num_cpus", "mhz_per_cpu", "library_build_type"):
+        if base_context.get(key) != context.get(key):
+            print("warning: %s differs (%s vs %s); timings may not be comparable"
+                  % (key, base_context.get(key), context.get(key)))
+
+    for label, ctx in (("baseline", base_context), ("current", context)):
+        load_avg = ctx.get("load_avg") or [0]
+        if ctx.get("num_cpus") and load_avg[0] >= ctx["num_cpus"]:
+            print("warning: %s was recorded at load %.2f on %d CPUs; timings are noisy"
+                  % (label, load_avg[0], ctx["num_cpus"]))
+
+    names = [n for n in baseline if n in current and name_filter.search(n)]
+    width = max([len(n) for n in names] + [9])
+    print("%-*s %12s %12s %9s  %s" % (width, "benchmark", "baseline", "current", "change", "allocs/op"))
+
+    regressions = 0
+    for name in names:
+        before = baseline[name][args.metric]
+        after = current[name][args.metric]
+        change = (after - before) / before * 100.0 if before else 0.0
+
+        allocs_before = baseline[name]["allocs_per_op"]
+        allocs_after = current[name]["allocs_per_op"]
+        allocs = ""
+        more_allocs = False
+        if allocs_before is not None and allocs_after is not None:
+            allocs = "%g -> %g" % (round(allocs_before, 2), round(allocs_after, 2))
+            more_allocs = allocs_after > allocs_before + 0.5
+
+        verdict = ""
+        if change > args.threshold or more_allocs:
+            verdict = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            verdict = "  improved"
+
+        print("%-*s %12s %12s %+8.1f%%  %s%s" % (width, name, format_ns(before), format_ns(after),
+                                                 change, allocs, verdict))
+
+    for name in sorted(base_skipped | skipped):
+        if name_filter.search(name):
+            print("not compared, more threads than CPUs: %s" % name)
+    for name in sorted(set(baseline) - set(current) - skipped):
+        if name_filter.search(name):
+            print("only in baseline: %s" % name)
+    for name in sorted(set(current) - set(baseline) - base_skipped):
+        if name_filter.search(name):
+            print("only in current: %s" % name)
+
+    print("\n%d of %d benchmarks regressed (threshold %.0f%%, %s)"
+          % (regressions, len(names), args.threshold, args.metric))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,87 @@
+#include "benchmark_util.h"
+#include "common/jwt_keyring.h"
+#include "common/jwt_util.h"
+#include <string>
+
+namespace {
+
+using ourchat::bench::AllocationCount;
+using ourchat::bench::ReportAllocations;
+
+const std::string kSecret = "benchmark_secret_key_that_is_long_enough_to_be_realistic";
+
+void BM_JWTVerify(benchmark::State& state) {
+    std::string token = ourchat::JWTUtil::GenerateToken(123456789, kSecret, 3600);
+    ourchat::JWTClaims claims;
+    // Warm the per-thread HMAC key outside the measured loop.
+    ourchat::JWTUtil::Verify(token, kSecret, &claims);
+
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        bool ok = ourchat::JWTUtil::Verify(token, kSecret, &claims);
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(claims);
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_JWTVerify);
+
+void BM_JWTValidateToken(benchmark::State& state) {
+    std::string token = ourchat::JWTUtil::GenerateToken(123456789, kSecret, 3600);
+    int64_t user_id = 0;
+    ourchat::JWTUtil::ValidateToken(token, user_id, kSecret);
+
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        bool ok = ourchat::JWTUtil::ValidateToken(token, user_id, kSecret);
+        benchmark::DoNotOptimize(ok);
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_JWTValidateToken);
+
+void BM_JWTVerifyBadSignature(benchmark::State& state) {
+    std::string token = ourchat::JWTUtil::GenerateToken(123456789, kSecret, 3600);
+    token[token.size() - 2] = token[token.size() - 2] == 'A' ? 'B' : 'A';
+    ourchat::JWTClaims claims;
+
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        bool ok = ourchat::JWTUtil::Verify(token, kSecret, &claims);
+        benchmark::DoNotOptimize(ok);
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_JWTVerifyBadSignature);
+
+void BM_JWTKeyringVerify(benchmark::State& state) {
+    ourchat::JWTConfig config;
+    config.secret = kSecret;
+    config.keys = {{"2026-09", kSecret + "-old"}, {"2026-10", kSecret + "-new"}};
+    config.active_kid = "2026-10";
+    auto keyring = ourchat::JWTKeyring::Instance();
+    keyring->Load(config);
+
+    std::string token = keyring->Sign(123456789, 3600);
+    ourchat::JWTClaims claims;
+
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        bool ok = keyring->Verify(token, &claims);
+        benchmark::DoNotOptimize(ok);
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_JWTKeyringVerify);
+
+void BM_JWTGenerate(benchmark::State& state) {
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        std::string token = ourchat::JWTUtil::GenerateToken(123456789, kSecret, 3600);
+        benchmark::DoNotOptimize(token);
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_JWTGenerate);
+
+} // namespace
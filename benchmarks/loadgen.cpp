@@ -0,0 +1,600 @@
+// Open-loop load generator for the OurChat gRPC API.
+//
+// Requests are issued on a fixed schedule (or Poisson arrivals) regardless
+// of how fast the server answers, and each latency is measured from the
+// time the request was due, not the time it was sent, so a stalled server
+// shows up in the percentiles instead of silently lowering the load.
+//
+//   loadgen --target=localhost:50051 --rps=2000 --duration=30 --users=500
+//           --mix=login:2,send:55,get:43
+//
+// Each simulated user is registered (if needed) and logged in before the
+// run; the Login share of the mix re-logs random users in. Keep the
+// server's rate_limit section disabled or generous for a load test, since
+// every simulated user shares the generator's IP. Point it at a server with
+// storage.backend: memory (optionally with latency_us) to measure server
+// overhead without MySQL and Redis.
+//
+// Messages are encoded directly in protobuf wire format and sent through
+// grpc::GenericStub, so the tool only needs grpc++.
+
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/generic/generic_stub.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// --- protobuf wire format -------------------------------------------------
+
+class ProtoWriter {
+public:
+    void Int64(int field, int64_t value) {
+        if (value == 0) return;
+        Varint(static_cast<uint64_t>(field) << 3);
+        Varint(static_cast<uint64_t>(value));
+    }
+
+    void String(int field, std::string_view value) {
+        if (value.empty()) return;
+        Varint((static_cast<uint64_t>(field) << 3) | 2);
+        Varint(value.size());
+        data_.append(value.data(), value.size());
+    }
+
+    const std::string& data() const { return data_; }
+
+private:
+    void Varint(uint64_t value) {
+        while (value >= 0x80) {
+            data_.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        data_.push_back(static_cast<char>(value));
+    }
+
+    std::string data_;
+};
+
+// Walks the top-level fields of a message; enough to pick scalars and
+// strings out of a response.
+class ProtoReader {
+public:
+    explicit ProtoReader(std::string_view data) : data_(data) {}
+
+    bool Next(int* field, uint64_t* varint, std::string_view* bytes) {
+        uint64_t key = 0;
+        if (!Varint(&key)) return false;
+        *field = static_cast<int>(key >> 3);
+        switch (key & 7) {
+        case 0:
+            return Varint(varint);
+        case 1:
+            return Skip(8);
+        case 2: {
+            uint64_t size = 0;
+            if (!Varint(&size) || size > data_.size() - pos_) return false;
+            *bytes = data_.substr(pos_, size);
+            pos_ += size;
+            return true;
+        }
+        case 5:
+            return Skip(4);
+        default:
+            return false;
+        }
+    }
+
+private:
+    bool Varint(uint64_t* value) {
+        *value = 0;
+        for (int shift = 0; shift < 64 && pos_ < data_.size(); shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+            *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool Skip(size_t size) {
+        if (size > data_.size() - pos_) return false;
+        pos_ += size;
+        return true;
+    }
+
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+grpc::ByteBuffer ToByteBuffer(const std::string& data) {
+    grpc::Slice slice(data);
+    return grpc::ByteBuffer(&slice, 1);
+}
+
+std::string FromByteBuffer(const grpc::ByteBuffer& buffer) {
+    std::vector<grpc::Slice> slices;
+    std::string data;
+    if (!buffer.Dump(&slices).ok()) return data;
+    for (const auto& slice : slices) {
+        data.append(reinterpret_cast<const char*>(slice.begin()), slice.size());
+    }
+    return data;
+}
+
+// --- latency histogram ----------------------------------------------------
+
+// Log-linear buckets in microseconds, HdrHistogram style: values below 128
+// are exact, above that each power of two is split into 64 buckets, so any
+// reported percentile is within 1.6% of the true value. Recording is one
+// relaxed atomic increment.
+class LatencyHistogram {
+public:
+    void Record(uint64_t micros) {
+        counts_[Index(micros)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (micros > max && !max_.compare_exchange_weak(max, micros, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t Count() const { return count_.load(); }
+    uint64_t Max() const { return max_.load(); }
+
+    uint64_t Percentile(double percentile) const {
+        uint64_t total = Count();
+        if (total == 0) return 0;
+
+        uint64_t target = static_cast<uint64_t>(std::ceil(total * percentile / 100.0));
+        target = std::max<uint64_t>(target, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; i++) {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= target) return std::min(UpperBound(i), Max());
+        }
+        return Max();
+    }
+
+    void Merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBuckets; i++) {
+            counts_[i].fetch_add(other.counts_[i].load(), std::memory_order_relaxed);
+        }
+        count_.fetch_add(other.Count(), std::memory_order_relaxed);
+        uint64_t other_max = other.Max();
+        if (other_max > max_.load()) max_.store(other_max);
+    }
+
+private:
+    static constexpr int kSubBucketBits = 6;
+    static constexpr uint64_t kLinear = 2ULL << kSubBucketBits;  // 128
+    static constexpr uint64_t kHalf = 1ULL << kSubBucketBits;    // 64
+    static constexpr size_t kBuckets = kLinear + 58 * kHalf;
+
+    static size_t Index(uint64_t value) {
+        if (value < kLinear) return static_cast<size_t>(value);
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - kSubBucketBits;
+        return static_cast<size_t>(kLinear + (shift - 1) * kHalf + ((value >> shift) - kHalf));
+    }
+
+    static uint64_t UpperBound(size_t index) {
+        if (index < kLinear) return index;
+        uint64_t shift = (index - kLinear) / kHalf + 1;
+        uint64_t sub = (index - kLinear) % kHalf + kHalf;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// --- options --------------------------------------------------------------
+
+enum RpcType { kLogin, kSendMessage, kGetMessages, kRpcTypeCount };
+
+const char* const kRpcNames[kRpcTypeCount] = {"Login", "SendMessage", "GetMessages"};
+const char* const kRpcMethods[kRpcTypeCount] = {
+    "/im.AuthService/Login",
+    "/im.MessageService/SendMessage",
+    "/im.MessageService/GetMessages",
+};
+
+struct Options {
+    std::string target = "localhost:50051";
+    double rps = 1000;
+    int duration = 30;
+    int warmup = 5;
+    int users = 100;
+    int workers = 4;
+    int max_inflight = 20000;
+    bool poisson = false;
+    int message_size = 64;
+    std::string user_prefix = "loadgen_";
+    std::string password = "loadgen_password";
+    std::array<int, kRpcTypeCount> mix = {2, 55, 43};
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "usage: loadgen [--target=host:port] [--rps=N] [--duration=SEC] [--warmup=SEC]\n"
+                 "               [--users=N] [--workers=N] [--max-inflight=N] [--poisson]\n"
+                 "               [--message-size=BYTES] [--user-prefix=S] [--password=S]\n"
+                 "               [--mix=login:W,send:W,get:W]\n");
+}
+
+bool ParseMix(const std::string& value, std::array<int, kRpcTypeCount>* mix) {
+    static const std::map<std::string, RpcType> kNames = {
+        {"login", kLogin}, {"send", kSendMessage}, {"get", kGetMessages}};
+
+    mix->fill(0);
+    size_t start = 0;
+    while (start < value.size()) {
+        size_t end = value.find(',', start);
+        if (end == std::string::npos) end = value.size();
+        std::string item = value.substr(start, end - start);
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+
+        auto it = kNames.find(item.substr(0, colon));
+        if (it == kNames.end()) return false;
+        (*mix)[it->second] = std::atoi(item.c_str() + colon + 1);
+        start = end + 1;
+    }
+
+    int total = 0;
+    for (int weight : *mix) total += std::max(weight, 0);
+    return total > 0;
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+
+        if (name == "--target") options->target = value;
+        else if (name == "--rps") options->rps = std::atof(value.c_str());
+        else if (name == "--duration") options->duration = std::atoi(value.c_str());
+        else if (name == "--warmup") options->warmup = std::atoi(value.c_str());
+        else if (name == "--users") options->users = std::atoi(value.c_str());
+        else if (name == "--workers") options->workers = std::atoi(value.c_str());
+        else if (name == "--max-inflight") options->max_inflight = std::atoi(value.c_str());
+        else if (name == "--poisson") options->poisson = true;
+        else if (name == "--message-size") options->message_size = std::atoi(value.c_str());
+        else if (name == "--user-prefix") options->user_prefix = value;
+        else if (name == "--password") options->password = value;
+        else if (name == "--mix") {
+            if (!ParseMix(value, &options->mix)) return false;
+        } else {
+            return false;
+        }
+    }
+    return options->rps > 0 && options->duration > 0 && options->users > 1 && options->workers > 0;
+}
+
+// --- simulated users ------------------------------------------------------
+
+struct User {
+    std::string username;
+    int64_t id = 0;
+    std::string token;
+};
+
+std::string LoginRequest(const Options& options, const User& user) {
+    ProtoWriter writer;
+    writer.String(1, user.username);
+    writer.String(2, options.password);
+    writer.String(3, "loadgen");
+    return writer.data();
+}
+
+bool ParseLoginResponse(const std::string& data, int64_t* user_id, std::string* token) {
+    ProtoReader reader(data);
+    int field = 0;
+    uint64_t varint = 0;
+    std::string_view bytes;
+    bool success = false;
+    while (reader.Next(&field, &varint, &bytes)) {
+        if (field == 1) success = varint != 0;
+        if (field == 3) *user_id = static_cast<int64_t>(varint);
+        if (field == 4) token->assign(bytes.data(), bytes.size());
+    }
+    return success && *user_id > 0 && !token->empty();
+}
+
+bool CallOnce(grpc::GenericStub* stub, const std::string& method, const std::string& request,
+              std::string* response) {
+    grpc::CompletionQueue cq;
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(10));
+
+    grpc::ByteBuffer reply;
+    grpc::Status status;
+    auto call = stub->PrepareUnaryCall(&context, method, ToByteBuffer(request), &cq);
+    call->StartCall();
+    call->Finish(&reply, &status, nullptr);
+
+    void* tag = nullptr;
+    bool ok = false;
+    if (!cq.Next(&tag, &ok) || !ok || !status.ok()) return false;
+    *response = FromByteBuffer(reply);
+    return true;
+}
+
+bool SetUpUser(grpc::GenericStub* stub, const Options& options, User* user) {
+    std::string response;
+    if (CallOnce(stub, kRpcMethods[kLogin], LoginRequest(options, *user), &response) &&
+        ParseLoginResponse(response, &user->id, &user->token)) {
+        return true;
+    }
+
+    ProtoWriter registration;
+    registration.String(1, user->username);
+    registration.String(2, options.password);
+    registration.String(5, user->username);
+    CallOnce(stub, "/im.AuthService/Register", registration.data(), &response);
+
+    return CallOnce(stub, kRpcMethods[kLogin], LoginRequest(options, *user), &response) &&
+           ParseLoginResponse(response, &user->id, &user->token);
+}
+
+// --- load -----------------------------------------------------------------
+
+struct Stats {
+    std::array<LatencyHistogram, kRpcTypeCount> latency;
+    std::array<std::atomic<uint64_t>, kRpcTypeCount> errors{};
+    std::mutex codes_mutex;
+    std::map<int, uint64_t> error_codes;
+    std::atomic<uint64_t> overflow{0};
+};
+
+struct Call {
+    RpcType type;
+    Clock::time_point due;
+    bool measured;
+    grpc::ClientContext context;
+    grpc::ByteBuffer response;
+    grpc::Status status;
+    std::unique_ptr<grpc::GenericClientAsyncResponseReader> reader;
+};
+
+class Worker {
+public:
+    Worker(int index, const Options& options, const std::vector<User>* users, Stats* stats)
+        : options_(options), users_(users), stats_(stats), random_(index * 7919 + 17) {
+        // A distinct channel argument keeps each worker on its own
+        // connection instead of sharing one subchannel.
+        grpc::ChannelArguments args;
+        args.SetInt("loadgen.worker", index);
+        channel_ = grpc::CreateCustomChannel(options.target, grpc::InsecureChannelCredentials(), args);
+        stub_ = std::make_unique<grpc::GenericStub>(channel_);
+
+        int total = 0;
+        for (int i = 0; i < kRpcTypeCount; i++) {
+            total += std::max(options.mix[i], 0);
+            cumulative_[i] = total;
+        }
+        content_.assign(static_cast<size_t>(std::max(options.message_size, 1)), 'x');
+    }
+
+    void Run(Clock::time_point start, Clock::time_point measure_from, Clock::time_point end) {
+        std::thread completer([this]() { Complete(); });
+
+        double rate = options_.rps / options_.workers;
+        std::exponential_distribution<double> gap(rate);
+        Clock::time_point due = start;
+        uint64_t sequence = 0;
+
+        while (due < end) {
+            std::this_thread::sleep_until(due);
+            Issue(due, due >= measure_from);
+
+            double seconds = options_.poisson ? gap(random_) : 1.0 / rate;
+            sequence++;
+            due = options_.poisson
+                      ? due + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds))
+                      : start + std::chrono::duration_cast<Clock::duration>(
+                                    std::chrono::duration<double>(sequence / rate));
+        }
+
+        // Let outstanding calls finish before shutting the queue down.
+        while (inflight_.load() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        cq_.Shutdown();
+        completer.join();
+    }
+
+private:
+    RpcType PickType() {
+        int roll = std::uniform_int_distribution<int>(1, cumulative_[kRpcTypeCount - 1])(random_);
+        for (int i = 0; i < kRpcTypeCount; i++) {
+            if (roll <= cumulative_[i]) return static_cast<RpcType>(i);
+        }
+        return kGetMessages;
+    }
+
+    const User& PickUser() {
+        return (*users_)[std::uniform_int_distribution<size_t>(0, users_->size() - 1)(random_)];
+    }
+
+    void Issue(Clock::time_point due, bool measured) {
+        RpcType type = PickType();
+        if (inflight_.load() >= options_.max_inflight) {
+            if (measured) stats_->overflow.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const User& user = PickUser();
+        const User& peer = PickUser();
+        ProtoWriter request;
+        switch (type) {
+        case kLogin:
+            return IssueCall(type, due, measured, user, LoginRequest(options_, user), false);
+        case kSendMessage:
+            request.Int64(1, user.id);
+            request.Int64(2, peer.id);
+            // message_type stays at its default, MESSAGE_TYPE_TEXT.
+            request.String(4, content_);
+            request.Int64(5, static_cast<int64_t>(random_() >> 1));
+            break;
+        case kGetMessages:
+        default:
+            request.Int64(1, user.id);
+            request.Int64(2, peer.id);
+            request.Int64(4, 20);
+            break;
+        }
+        IssueCall(type, due, measured, user, request.data(), true);
+    }
+
+    void IssueCall(RpcType type, Clock::time_point due, bool measured, const User& user,
+                   const std::string& request, bool authenticated) {
+        auto* call = new Call();
+        call->type = type;
+        call->due = due;
+        call->measured = measured;
+        call->context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(10));
+        if (authenticated) {
+            call->context.AddMetadata("authorization", "Bearer " + user.token);
+        }
+
+        inflight_.fetch_add(1);
+        call->reader = stub_->PrepareUnaryCall(&call->context, kRpcMethods[type], ToByteBuffer(request), &cq_);
+        call->reader->StartCall();
+        call->reader->Finish(&call->response, &call->status, call);
+    }
+
+    void Complete() {
+        void* tag = nullptr;
+        bool ok = false;
+        while (cq_.Next(&tag, &ok)) {
+            std::unique_ptr<Call> call(static_cast<Call*>(tag));
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - call->due);
+
+            if (call->measured) {
+                if (ok && call->status.ok()) {
+                    stats_->latency[call->type].Record(static_cast<uint64_t>(latency.count()));
+                } else {
+                    stats_->errors[call->type].fetch_add(1, std::memory_order_relaxed);
+                    std::lock_guard<std::mutex> lock(stats_->codes_mutex);
+                    stats_->error_codes[ok ? call->status.error_code() : grpc::StatusCode::UNKNOWN]++;
+                }
+            }
+            inflight_.fetch_sub(1);
+        }
+    }
+
+    const Options& options_;
+    const std::vector<User>* users_;
+    Stats* stats_;
+    std::mt19937_64 random_;
+    std::array<int, kRpcTypeCount> cumulative_{};
+    std::string content_;
+
+    std::shared_ptr<grpc::Channel> channel_;
+    std::unique_ptr<grpc::GenericStub> stub_;
+    grpc::CompletionQueue cq_;
+    std::atomic<int> inflight_{0};
+};
+
+void PrintRow(const char* name, const LatencyHistogram& histogram, uint64_t errors, double seconds) {
+    auto ms = [](uint64_t micros) { return micros / 1000.0; };
+    std::printf("%-12s %10llu %8llu %10.1f %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n", name,
+                static_cast<unsigned long long>(histogram.Count()),
+                static_cast<unsigned long long>(errors), histogram.Count() / seconds,
+                ms(histogram.Percentile(50)), ms(histogram.Percentile(90)), ms(histogram.Percentile(99)),
+                ms(histogram.Percentile(99.9)), ms(histogram.Percentile(99.99)), ms(histogram.Max()));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage();
+        return 2;
+    }
+
+    // Log everyone in, spread over a few threads.
+    std::vector<User> users(options.users);
+    std::atomic<size_t> next_user{0};
+    std::atomic<int> failed{0};
+    std::vector<std::thread> setup;
+    for (int t = 0; t < std::min(options.workers * 2, options.users); t++) {
+        setup.emplace_back([&]() {
+            grpc::GenericStub stub(grpc::CreateChannel(options.target, grpc::InsecureChannelCredentials()));
+            for (size_t i = next_user++; i < users.size(); i = next_user++) {
+                users[i].username = options.user_prefix + std::to_string(i);
+                if (!SetUpUser(&stub, options, &users[i])) failed++;
+            }
+        });
+    }
+    for (auto& thread : setup) thread.join();
+
+    if (failed > 0) {
+        std::fprintf(stderr, "loadgen: %d of %d users could not log in to %s\n", failed.load(),
+                     options.users, options.target.c_str());
+        return 1;
+    }
+
+    std::printf("loadgen: target=%s rps=%.0f%s duration=%ds warmup=%ds users=%d workers=%d\n",
+                options.target.c_str(), options.rps, options.poisson ? " (poisson)" : "",
+                options.duration, options.warmup, options.users, options.workers);
+
+    Stats stats;
+    auto start = Clock::now() + std::chrono::milliseconds(100);
+    auto measure_from = start + std::chrono::seconds(options.warmup);
+    auto end = measure_from + std::chrono::seconds(options.duration);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < options.workers; i++) {
+        workers.push_back(std::make_unique<Worker>(i, options, &users, &stats));
+    }
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back([&worker, start, measure_from, end]() { worker->Run(start, measure_from, end); });
+    }
+    for (auto& thread : threads) thread.join();
+
+    double seconds = options.duration;
+    std::printf("\n%-12s %10s %8s %10s %8s %8s %8s %8s %8s %8s\n", "rpc", "ok", "errors", "ok/s",
+                "p50", "p90", "p99", "p99.9", "p99.99", "max");
+    LatencyHistogram all;
+    uint64_t errors = 0;
+    for (int i = 0; i < kRpcTypeCount; i++) {
+        if (options.mix[i] <= 0) continue;
+        PrintRow(kRpcNames[i], stats.latency[i], stats.errors[i].load(), seconds);
+        all.Merge(stats.latency[i]);
+        errors += stats.errors[i].load();
+    }
+    PrintRow("all", all, errors, seconds);
+    std::printf("latencies in ms, measured from each request's scheduled time\n");
+
+    if (stats.overflow > 0) {
+        std::printf("not sent (over --max-inflight): %llu\n",
+                    static_cast<unsigned long long>(stats.overflow.load()));
+    }
+    for (const auto& code : stats.error_codes) {
+        std::printf("status %d: %llu\n", code.first, static_cast<unsigned long long>(code.second));
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include "benchmark_util.h"
+#include "common/logger.h"
+#include <memory>
+#include <string>
+
+namespace {
+
+using ourchat::Logger;
+using ourchat::LogLevel;
+
+// One logger shared by all benchmark threads, writing to /dev/null: this
+// measures formatting, the logger mutex and the write syscall, not the disk.
+Logger& SharedLogger() {
+    static Logger* logger = []() {
+        auto* created = new Logger();
+        created->SetConsoleOutput(false);
+        created->SetOutputFile("/dev/null");
+        created->SetLogLevel(LogLevel::INFO);
+        return created;
+    }();
+    return *logger;
+}
+
+const std::string kMessage = "Message sent: 1234567890123 from 42 to 4242";
+
+void BM_LoggerInfo(benchmark::State& state) {
+    Logger& logger = SharedLogger();
+    for (auto _ : state) {
+        logger.Info(kMessage);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerInfo)->ThreadRange(1, 8)->UseRealTime();
+
+// A message built per call, as at the LOG_INFO call sites.
+void BM_LoggerInfoConcat(benchmark::State& state) {
+    Logger& logger = SharedLogger();
+    int64_t message_id = 1234567890123;
+    for (auto _ : state) {
+        logger.Info("Message sent: " + std::to_string(message_id++) + " from 42 to 4242");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerInfoConcat)->ThreadRange(1, 8)->UseRealTime();
+
+// Below the configured level: should cost a comparison.
+void BM_LoggerFilteredDebug(benchmark::State& state) {
+    Logger& logger = SharedLogger();
+    for (auto _ : state) {
+        logger.Debug(kMessage);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerFilteredDebug)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,93 @@
+#include "benchmark_util.h"
+#include "data/connection_pool.h"
+#include <chrono>
+#include <memory>
+
+// MySQLPool and RedisPool hand out leases from ConnectionPool; a fake
+// connection isolates the checkout/return cost from any server.
+
+namespace {
+
+using ourchat::bench::AllocationCount;
+using ourchat::bench::ReportAllocations;
+
+struct FakeConnection {
+    bool usable = true;
+    uint64_t uses = 0;
+};
+
+using FakePool = ourchat::ConnectionPool<FakeConnection>;
+
+std::unique_ptr<FakePool> g_pool;
+
+// range(0) is the pool size, range(1) the idle time after which a borrow
+// validates the connection (0 validates on every borrow).
+void CreatePool(const benchmark::State& state) {
+    FakePool::Options options;
+    options.size = static_cast<size_t>(state.range(0));
+    options.validate_after = std::chrono::milliseconds(state.range(1));
+    options.is_usable = [](FakeConnection& connection) { return connection.usable; };
+    options.validate = [](FakeConnection& connection) { return connection.usable; };
+
+    g_pool = std::make_unique<FakePool>(
+        "benchmark", []() { return std::make_unique<FakeConnection>(); }, options);
+    g_pool->Init();
+}
+
+void DestroyPool(const benchmark::State&) {
+    g_pool.reset();
+}
+
+void BM_PoolLease(benchmark::State& state) {
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        auto lease = g_pool->Borrow();
+        lease->uses++;
+        benchmark::DoNotOptimize(lease.get());
+    }
+    ReportAllocations(state, before);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Default MySQLPool/RedisPool shape: 10 connections, validated after 30s
+// idle, with up to 16 threads competing.
+BENCHMARK(BM_PoolLease)
+    ->Args({10, 30000})
+    ->Setup(CreatePool)
+    ->Teardown(DestroyPool)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+// Fewer connections than threads: borrowers wait for returns.
+BENCHMARK(BM_PoolLease)
+    ->Args({2, 30000})
+    ->Setup(CreatePool)
+    ->Teardown(DestroyPool)
+    ->Threads(8)
+    ->UseRealTime();
+
+// Every borrow runs the validate hook.
+BENCHMARK(BM_PoolLease)
+    ->Args({10, 0})
+    ->Setup(CreatePool)
+    ->Teardown(DestroyPool)
+    ->Threads(1)
+    ->Threads(8)
+    ->UseRealTime();
+
+// A lease that is moved out of the scope that borrowed it, as when a
+// repository returns a lease to its caller.
+void BM_PoolLeaseMove(benchmark::State& state) {
+    for (auto _ : state) {
+        FakePool::Lease outer;
+        {
+            auto lease = g_pool->Borrow();
+            outer = std::move(lease);
+        }
+        outer->uses++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PoolLeaseMove)->Args({10, 30000})->Setup(CreatePool)->Teardown(DestroyPool);
+
+} // namespace
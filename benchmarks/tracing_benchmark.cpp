@@ -0,0 +1,48 @@
+#include "benchmark_util.h"
+#include "common/tracing.h"
+#include <memory>
+
+// Spans sit on the MySQL, Redis, pool and logger paths whether or not the
+// call is sampled, so the unsampled cost is the one every request pays.
+
+namespace {
+
+using ourchat::Span;
+using ourchat::SpanKind;
+using ourchat::Tracer;
+using ourchat::bench::AllocationCount;
+using ourchat::bench::ReportAllocations;
+
+void BM_SpanUnsampled(benchmark::State& state) {
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        Span span("redis.command", SpanKind::kClient);
+        span.SetAttribute("db.system", "redis");
+        benchmark::DoNotOptimize(span.Recording());
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_SpanUnsampled)->ThreadRange(1, 8)->UseRealTime();
+
+// A child span recorded under a sampled call and queued for the writer,
+// which exports to /dev/null. Spans beyond the queue limit are dropped, as
+// in production when the writer falls behind.
+void BM_SpanSampled(benchmark::State& state) {
+    ourchat::TracingConfig config{true, 1.0, "/dev/null", 65536, 10};
+    Tracer::Instance()->Start(config, "benchmark");
+    std::unique_ptr<Span> root = Span::StartServer("/im.MessageService/SendMessage", "");
+
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        Span span("redis.command", SpanKind::kClient);
+        span.SetAttribute("db.system", "redis");
+        span.SetAttribute("db.operation", "GET");
+    }
+    ReportAllocations(state, before);
+
+    root.reset();
+    Tracer::Instance()->Stop();
+}
+BENCHMARK(BM_SpanSampled);
+
+} // namespace
@@ -0,0 +1,135 @@
+#include "benchmark_util.h"
+#include "common/crypto_util.h"
+#include "common/string_util.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+using ourchat::CryptoUtil;
+using ourchat::StringUtil;
+using ourchat::bench::AllocationCount;
+using ourchat::bench::ReportAllocations;
+
+const std::string kPassword = "correct horse battery staple";
+
+// Arg is the bcrypt cost; production uses 12, which is too slow to repeat
+// often, so the curve is sampled below it.
+void BM_PasswordHash(benchmark::State& state) {
+    int cost = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        std::string hash = CryptoUtil::HashPassword(kPassword, cost);
+        benchmark::DoNotOptimize(hash);
+    }
+}
+BENCHMARK(BM_PasswordHash)->Arg(4)->Arg(8)->Arg(10)->Unit(benchmark::kMillisecond);
+
+void BM_PasswordValidate(benchmark::State& state) {
+    std::string hash = CryptoUtil::HashPassword(kPassword, static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        bool ok = CryptoUtil::ValidatePassword(kPassword, hash);
+        benchmark::DoNotOptimize(ok);
+    }
+}
+BENCHMARK(BM_PasswordValidate)->Arg(4)->Arg(10)->Unit(benchmark::kMillisecond);
+
+// Unsalted SHA-256 hex digests still stored for old accounts.
+void BM_PasswordValidateLegacy(benchmark::State& state) {
+    std::string hash = CryptoUtil::SHA256Hash(kPassword);
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        bool ok = CryptoUtil::ValidatePassword(kPassword, hash);
+        benchmark::DoNotOptimize(ok);
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_PasswordValidateLegacy);
+
+void BM_SHA256Hash(benchmark::State& state) {
+    std::string data(static_cast<size_t>(state.range(0)), 'x');
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        std::string digest = CryptoUtil::SHA256Hash(data);
+        benchmark::DoNotOptimize(digest);
+    }
+    ReportAllocations(state, before);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SHA256Hash)->Arg(64)->Arg(4096);
+
+std::string BinaryPayload(size_t size) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<char>((i * 131 + 7) & 0xff);
+    }
+    return data;
+}
+
+void BM_Base64Encode(benchmark::State& state) {
+    std::string data = BinaryPayload(static_cast<size_t>(state.range(0)));
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        std::string encoded = StringUtil::EncodeBase64(data);
+        benchmark::DoNotOptimize(encoded);
+    }
+    ReportAllocations(state, before);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Base64Encode)->Arg(32)->Arg(1024)->Arg(65536);
+
+void BM_Base64Decode(benchmark::State& state) {
+    std::string encoded = StringUtil::EncodeBase64(BinaryPayload(static_cast<size_t>(state.range(0))));
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        std::string decoded = StringUtil::DecodeBase64(encoded);
+        benchmark::DoNotOptimize(decoded);
+    }
+    ReportAllocations(state, before);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Base64Decode)->Arg(32)->Arg(1024)->Arg(65536);
+
+// Comma-separated list of `count` short fields, e.g. a prefix list from
+// config or a batch of ids.
+std::string FieldList(int count, const std::string& separator) {
+    std::vector<std::string> parts;
+    for (int i = 0; i < count; i++) {
+        parts.push_back("field" + std::to_string(i));
+    }
+    return StringUtil::Join(parts, separator);
+}
+
+void BM_SplitChar(benchmark::State& state) {
+    std::string list = FieldList(static_cast<int>(state.range(0)), ",");
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        auto parts = StringUtil::Split(list, ',');
+        benchmark::DoNotOptimize(parts);
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_SplitChar)->Arg(4)->Arg(64);
+
+void BM_SplitString(benchmark::State& state) {
+    std::string list = FieldList(static_cast<int>(state.range(0)), ", ");
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        auto parts = StringUtil::Split(list, ", ");
+        benchmark::DoNotOptimize(parts);
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_SplitString)->Arg(4)->Arg(64);
+
+void BM_Join(benchmark::State& state) {
+    auto parts = StringUtil::Split(FieldList(static_cast<int>(state.range(0)), ","), ',');
+    uint64_t before = AllocationCount();
+    for (auto _ : state) {
+        std::string joined = StringUtil::Join(parts, ",");
+        benchmark::DoNotOptimize(joined);
+    }
+    ReportAllocations(state, before);
+}
+BENCHMARK(BM_Join)->Arg(4)->Arg(64);
+
+} // namespace
@@ -0,0 +1,53 @@
+#ifndef OURCHAT_BOUNDED_WORKER_POOL_H
+#define OURCHAT_BOUNDED_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ourchat {
+
+// Fixed set of worker threads with a hard cap on queued tasks. TrySubmit
+// never blocks: when max_queue tasks are already waiting it returns false so
+// the caller can shed load instead of piling up. With pin_threads the
+// workers are pinned to the last `threads` CPUs of the process affinity
+// mask, which caps the CPU they can take from everything else.
+class BoundedWorkerPool {
+public:
+    BoundedWorkerPool(const std::string& name, int threads, int max_queue, bool pin_threads);
+    ~BoundedWorkerPool();
+
+    BoundedWorkerPool(const BoundedWorkerPool&) = delete;
+    BoundedWorkerPool& operator=(const BoundedWorkerPool&) = delete;
+
+    bool TrySubmit(std::function<void()> task);
+    void Stop();
+
+    size_t QueueDepth();
+    uint64_t Rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    void Run();
+    void Pin(std::thread& thread, int slot, int threads);
+
+    std::string name_;
+    size_t max_queue_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::queue<std::function<void()>> tasks_;
+    bool stopping_ = false;
+
+    std::vector<std::thread> workers_;
+    std::atomic<uint64_t> rejected_{0};
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_BOUNDED_WORKER_POOL_H
@@ -1,12 +1,18 @@
 #ifndef OURCHAT_CONFIG_H
 #define OURCHAT_CONFIG_H
 
+#include <map>
 #include <string>
 #include <vector>
 #include <memory>
 
 namespace ourchat {
 
+struct DatabaseEndpoint {
+    std::string host;
+    int port;
+};
+
 struct DatabaseConfig {
     std::string host;
     int port;
@@ -17,6 +23,15 @@ struct DatabaseConfig {
     int max_pool_size;
     int connection_timeout;
     int idle_timeout;
+    std::vector<DatabaseEndpoint> replicas;
+    int replica_pool_size;
+    int replica_max_lag;
+    int read_your_writes_window;
+};
+
+struct RedisNode {
+    std::string host;
+    int port;
 };
 
 struct RedisConfig {
@@ -26,6 +41,10 @@ struct RedisConfig {
     int db;
     int pool_size;
     int command_timeout;
+    int async_connections;
+    int async_max_pending;
+    bool cluster;
+    std::vector<RedisNode> cluster_nodes;
 };
 
 struct KafkaConfig {
@@ -43,16 +62,111 @@ struct ServerConfig {
     std::string service_name;
     std::string host;
     int port;
+    // Completion queues, each with its own polling threads.
     int worker_threads;
+    // Cap on all server threads, handlers included; 0 is unlimited.
+    int max_threads;
+    int memory_quota_mb;  // 0 is unlimited
     int max_connection;
-    int keepalive_time;
-    int keepalive_timeout;
+    int max_concurrent_streams;  // per connection
+    int keepalive_time;     // seconds
+    int keepalive_timeout;  // seconds
+    int node_id;
+    // On SIGTERM: health checks report NOT_SERVING for lame_duck_ms while
+    // calls are still served, then in-flight calls get shutdown_grace_ms
+    // to finish before they are cancelled.
+    int lame_duck_ms;
+    int shutdown_grace_ms;
+};
+
+struct JWTKeyConfig {
+    std::string kid;
+    std::string secret;
 };
 
 struct JWTConfig {
     std::string secret;
     int expire_seconds;
     int refresh_expire_seconds;
+    std::vector<JWTKeyConfig> keys;
+    std::string active_kid;
+};
+
+struct PasswordHashConfig {
+    int bcrypt_cost;
+    int worker_threads;
+    int max_queue;
+    bool pin_threads;
+};
+
+struct MessageStoreConfig {
+    bool partitioned;
+    int shard_count;
+    // Serve first pages from an in-process tail of each conversation. The
+    // tail only sees sends made through this node, so it is only correct
+    // when a single instance serves messages.
+    bool tail_cache;
+};
+
+struct StorageConfig {
+    // "mysql" (MySQL and Redis) or "memory" (in-process stand-ins).
+    std::string backend;
+    // Added to every in-memory store call, to model backend round trips.
+    int latency_us;
+    int latency_jitter_us;
+};
+
+struct SendDedupConfig {
+    int window_seconds;
+    // How long an unfinished send holds its claim; retries during it get
+    // kInFlight. Must exceed the longest a send can take.
+    int claim_seconds;
+    int local_capacity;
+};
+
+struct NearCacheConfig {
+    bool enabled;
+    // Keys cached and tracked; empty means every key.
+    std::vector<std::string> prefixes;
+    int max_entries;
+    int max_memory_mb;
+    int ttl_ms;
+};
+
+struct RateLimitRule {
+    double rate;  // tokens per second
+    int burst;
+};
+
+struct RateLimitConfig {
+    bool enabled;
+    int table_size;
+    RateLimitRule per_ip;
+    RateLimitRule per_user;
+    // Extra per-IP rules for expensive methods, by full method name.
+    std::map<std::string, RateLimitRule, std::less<>> methods;
+    // Sliding-window limit per user shared by all nodes through Redis.
+    bool distributed;
+    int window_ms;
+    int window_limit;
+};
+
+struct LoggingConfig {
+    std::string level;
+    bool console_output;
+    bool file_output;
+    std::string log_file;
+};
+
+struct TracingConfig {
+    bool enabled;
+    // Fraction of new traces recorded; a sampled traceparent from the
+    // caller is always followed.
+    double sample_ratio;
+    // OTLP JSON lines, appended.
+    std::string export_path;
+    int max_queued_spans;
+    int flush_interval_ms;
 };
 
 struct Config {
@@ -61,6 +175,14 @@ struct Config {
     KafkaConfig kafka;
     ServerConfig server;
     JWTConfig jwt;
+    PasswordHashConfig password_hash;
+    MessageStoreConfig message_store;
+    StorageConfig storage;
+    SendDedupConfig send_dedup;
+    NearCacheConfig near_cache;
+    RateLimitConfig rate_limit;
+    TracingConfig tracing;
+    LoggingConfig logging;
 };
 
 } // namespace ourchat
@@ -2,33 +2,82 @@
 #define OURCHAT_CONFIG_MANAGER_H
 
 #include "config.h"
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace ourchat {
 
+// Holds the parsed server.yaml as an immutable Config snapshot. A reload
+// parses the file into a new snapshot and swaps it in with std::atomic_store;
+// readers take Current() and see every section from the same version of
+// the file for as long as they hold it. A file that fails to parse leaves
+// the current snapshot in place.
+//
+// Components that can change settings at runtime Subscribe(); the rest
+// read their section once at startup and need a restart.
 class ConfigManager {
 public:
+    // Called after each reload with the replaced and the new snapshot, on
+    // the reloading thread and in subscription order.
+    using Listener = std::function<void(const Config& previous, const Config& current)>;
+
     static ConfigManager& Instance();
     
     bool LoadConfig(const std::string& config_path);
+    // Re-reads the file and notifies subscribers.
+    bool Reload();
+    // Reloads whenever the file's content changes, whether it is written
+    // in place, replaced by a rename or swapped behind a symlink (as in a
+    // Kubernetes ConfigMap volume), from a background inotify thread.
+    bool StartWatching();
+    void StopWatching();
+    void Subscribe(Listener listener);
+    
+    std::shared_ptr<const Config> Current() const;
+    const std::string& GetConfigPath() const;
     
-    const DatabaseConfig& GetDatabaseConfig() const;
-    const RedisConfig& GetRedisConfig() const;
-    const KafkaConfig& GetKafkaConfig() const;
-    const ServerConfig& GetServerConfig() const;
-    const JWTConfig& GetJWTConfig() const;
+    // Copies of sections of the current snapshot.
+    DatabaseConfig GetDatabaseConfig() const;
+    RedisConfig GetRedisConfig() const;
+    KafkaConfig GetKafkaConfig() const;
+    ServerConfig GetServerConfig() const;
+    JWTConfig GetJWTConfig() const;
+    PasswordHashConfig GetPasswordHashConfig() const;
+    MessageStoreConfig GetMessageStoreConfig() const;
+    StorageConfig GetStorageConfig() const;
+    SendDedupConfig GetSendDedupConfig() const;
+    NearCacheConfig GetNearCacheConfig() const;
+    RateLimitConfig GetRateLimitConfig() const;
+    TracingConfig GetTracingConfig() const;
+    LoggingConfig GetLoggingConfig() const;
     
 private:
     ConfigManager() = default;
-    ~ConfigManager() = default;
+    ~ConfigManager();
     ConfigManager(const ConfigManager&) = delete;
     ConfigManager& operator=(const ConfigManager&) = delete;
     
-    DatabaseConfig mysql_;
-    RedisConfig redis_;
-    KafkaConfig kafka_;
-    ServerConfig server_;
-    JWTConfig jwt_;
+    static bool ReadFile(const std::string& path, std::string* content);
+    static bool Parse(const std::string& content, Config* out);
+    // With only_if_changed, a file identical to the loaded one is skipped.
+    bool ReloadFile(bool only_if_changed);
+    void WatchLoop();
+    
+    std::string config_path_;
+    std::shared_ptr<const Config> config_;
+    
+    // Serializes reloads; guards loaded_content_ and listeners_.
+    std::mutex reload_mutex_;
+    std::string loaded_content_;
+    std::vector<Listener> listeners_;
+    
+    std::thread watcher_;
+    int inotify_fd_ = -1;
+    int stop_fd_ = -1;
 };
 
 } // namespace ourchat
@@ -17,8 +17,11 @@ public:
     static std::string GenerateToken(int length = 32);
     static std::string GenerateSessionId();
     
+    // bcrypt ($2b$) with the given cost. Hashes that are not crypt(3)
+    // strings are treated as legacy unsalted SHA-256 hex digests.
     static bool ValidatePassword(const std::string& password, const std::string& hash);
-    static std::string HashPassword(const std::string& password);
+    static std::string HashPassword(const std::string& password, int cost = 12);
+    static bool NeedsRehash(const std::string& hash, int cost);
     
     static std::string GenerateUUID();
 };
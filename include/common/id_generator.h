@@ -0,0 +1,40 @@
+#ifndef OURCHAT_ID_GENERATOR_H
+#define OURCHAT_ID_GENERATOR_H
+
+#include <cstdint>
+#include <mutex>
+
+namespace ourchat {
+
+// Snowflake style ids: 41 bits of milliseconds since kEpochMs, 10 bits of
+// node id and 12 bits of per-millisecond sequence. Ids are time ordered, so
+// the creation time can be recovered from the id alone.
+class IdGenerator {
+public:
+    static IdGenerator& Instance();
+    
+    void Init(int node_id);
+    int64_t NextId();
+    
+    static int64_t TimestampMs(int64_t id);
+    static int64_t MinIdForTimestampMs(int64_t timestamp_ms);
+    
+    static constexpr int64_t kEpochMs = 1704067200000LL; // 2024-01-01 00:00:00 UTC
+    
+private:
+    IdGenerator() = default;
+    IdGenerator(const IdGenerator&) = delete;
+    IdGenerator& operator=(const IdGenerator&) = delete;
+    
+    static constexpr int kNodeBits = 10;
+    static constexpr int kSequenceBits = 12;
+    
+    std::mutex mutex_;
+    int64_t node_id_ = 0;
+    int64_t last_ms_ = 0;
+    int64_t sequence_ = 0;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_ID_GENERATOR_H
@@ -0,0 +1,49 @@
+#ifndef OURCHAT_JWT_KEYRING_H
+#define OURCHAT_JWT_KEYRING_H
+
+#include "config.h"
+#include "jwt_util.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ourchat {
+
+// Signing and verification keys selected by the "kid" header. New tokens
+// are signed with active_kid; every configured key still verifies, so a
+// rotation is: add the new key, reload, switch active_kid, reload, and drop
+// the old key once its tokens have expired. Tokens without a kid verify
+// against jwt.secret. Each key keeps a prepared HmacKey, and the key set is
+// an immutable snapshot swapped atomically on Load.
+class JWTKeyring {
+public:
+    static std::shared_ptr<JWTKeyring> Instance();
+
+    // Keeps the current keys and returns false if config is invalid.
+    bool Load(const JWTConfig& config);
+
+    std::string Sign(int64_t user_id, int expires_in_seconds, int64_t version = 0);
+    bool Verify(std::string_view token, JWTClaims* claims);
+
+private:
+    JWTKeyring() = default;
+
+    struct Key {
+        std::string kid;
+        HmacKey hmac;
+    };
+
+    struct KeySet {
+        std::vector<Key> keys;
+        size_t active = 0;
+
+        const Key* Find(std::string_view kid) const;
+    };
+
+    std::shared_ptr<const KeySet> keys_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_JWT_KEYRING_H
@@ -1,134 +1,67 @@
 #ifndef OURCHAT_JWT_UTIL_H
 #define OURCHAT_JWT_UTIL_H
 
+#include <cstdint>
 #include <string>
-#include <chrono>
-#include <openssl/hmac.h>
-#include <openssl/sha.h>
-#include <openssl/evp.h>
-#include <openssl/bio.h>
-#include <openssl/buffer.h>
-#include <iomanip>
-#include <sstream>
+#include <string_view>
 
 namespace ourchat {
 
+struct JWTClaims {
+    int64_t user_id = 0;
+    int64_t iat = 0;
+    int64_t exp = 0;
+    int64_t version = 0;
+};
+
+// HMAC-SHA256 key holding the SHA-256 state after the ipad/opad blocks, so
+// signing starts from a copy of those eight words instead of rehashing the
+// key. Plain values all the way through: signing never allocates, which
+// copying an OpenSSL 3 digest context does.
+class HmacKey {
+public:
+    explicit HmacKey(std::string_view secret);
+
+    // Writes kMacSize bytes.
+    void Sign(std::string_view data, unsigned char* mac) const;
+
+    static constexpr size_t kMacSize = 32;
+
+private:
+    uint32_t inner_[8];
+    uint32_t outer_[8];
+};
+
 class JWTUtil {
 public:
-    static std::string GenerateToken(int64_t user_id, const std::string& secret, int expires_in_seconds = 3600) {
-        auto now = std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
-        
-        std::string header = Base64UrlEncode("{\"alg\":\"HS256\",\"typ\":\"JWT\"}");
-        std::string payload = Base64UrlEncode("{\"user_id\":" + std::to_string(user_id) + 
-                                              ",\"iat\":" + std::to_string(now) + 
-                                              ",\"exp\":" + std::to_string(now + expires_in_seconds) + "}");
-        
-        std::string signature = Sign(header + "." + payload, secret);
-        
-        return header + "." + payload + "." + signature;
-    }
-    
-    static bool ValidateToken(const std::string& token, int64_t& user_id, const std::string& secret) {
-        auto parts = Split(token, '.');
-        if (parts.size() != 3) return false;
-        
-        std::string expected_signature = Sign(parts[0] + "." + parts[1], secret);
-        if (expected_signature != parts[2]) return false;
-        
-        std::string payload = Base64UrlDecode(parts[1]);
-        auto pos = payload.find("\"user_id\":");
-        if (pos == std::string::npos) return false;
-        
-        pos += 10;
-        size_t end = payload.find_first_of(",}", pos);
-        try {
-            user_id = std::stoll(payload.substr(pos, end - pos));
-        } catch (...) {
-            return false;
-        }
-        
-        auto exp_pos = payload.find("\"exp\":");
-        if (exp_pos != std::string::npos) {
-            exp_pos += 5;
-            size_t exp_end = payload.find_first_of(",}", exp_pos);
-            int64_t exp = std::stoll(payload.substr(exp_pos, exp_end - exp_pos));
-            auto now = std::chrono::duration_cast<std::chrono::seconds>(
-                std::chrono::system_clock::now().time_since_epoch()).count();
-            if (now > exp) return false;
-        }
-        
-        return true;
-    }
-    
+    static std::string GenerateToken(int64_t user_id, const std::string& secret, int expires_in_seconds = 3600);
+    // Adds "kid" to the header when kid is not empty and a "ver" claim when
+    // version is not 0.
+    static std::string GenerateToken(int64_t user_id, const HmacKey& key, std::string_view kid,
+                                     int expires_in_seconds, int64_t version = 0);
+
+    static bool ValidateToken(const std::string& token, int64_t& user_id, const std::string& secret);
+
+    // Does not allocate: segments are string_views into the token, base64url
+    // is decoded into fixed stack buffers, the HMAC key is cached per thread
+    // and the signature is compared in constant time. Tokens with an expired
+    // exp claim are rejected.
+    static bool Verify(std::string_view token, std::string_view secret, JWTClaims* claims);
+    static bool Verify(std::string_view token, const HmacKey& key, JWTClaims* claims);
+
+    // Decodes the header into buffer and returns its "kid", or an empty view
+    // if there is none. Returns false if the token is malformed.
+    static bool ReadKid(std::string_view token, char* buffer, size_t capacity, std::string_view* kid);
+
+    // Largest decoded header/payload Verify accepts.
+    static constexpr size_t kMaxSegmentSize = 1024;
+
 private:
-    static std::string Sign(const std::string& data, const std::string& key) {
-        unsigned char hash[EVP_MAX_MD_SIZE];
-        unsigned int hash_len;
-        
-        HMAC(EVP_sha256(), key.data(), key.length(), 
-             reinterpret_cast<const unsigned char*>(data.data()), data.length(),
-             hash, &hash_len);
-        
-        return Base64UrlEncode(std::string(reinterpret_cast<char*>(hash), hash_len));
-    }
-    
-    static std::string Base64UrlEncode(const std::string& input) {
-        BIO* b64 = BIO_new(BIO_f_base64());
-        BIO* bio = BIO_new(BIO_s_mem());
-        bio = BIO_push(b64, bio);
-        
-        BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
-        BIO_write(bio, input.data(), input.length());
-        BIO_flush(bio);
-        
-        BUF_MEM* buffer_ptr;
-        BIO_get_mem_ptr(bio, &buffer_ptr);
-        
-        std::string result(buffer_ptr->data, buffer_ptr->length);
-        BIO_free_all(bio);
-        
-        for (char& c : result) {
-            if (c == '+') c = '-';
-            else if (c == '/') c = '_';
-            else if (c == '=') c = '\0';
-        }
-        
-        return result;
-    }
-    
-    static std::string Base64UrlDecode(const std::string& input) {
-        std::string temp = input;
-        for (char& c : temp) {
-            if (c == '-') c = '+';
-            else if (c == '_') c = '/';
-        }
-        
-        while (temp.length() % 4) temp += '=';
-        
-        BIO* b64 = BIO_new(BIO_f_base64());
-        BIO* bio = BIO_new_mem_buf(temp.data(), temp.length());
-        bio = BIO_push(b64, bio);
-        
-        BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
-        
-        char buffer[4096];
-        int len = BIO_read(bio, buffer, sizeof(buffer));
-        
-        BIO_free_all(bio);
-        
-        return std::string(buffer, len);
-    }
-    
-    static std::vector<std::string> Split(const std::string& s, char delim) {
-        std::vector<std::string> parts;
-        std::stringstream ss(s);
-        std::string part;
-        while (std::getline(ss, part, delim)) {
-            parts.push_back(part);
-        }
-        return parts;
-    }
+    static bool SplitToken(std::string_view token, size_t* first, size_t* second);
+    static std::string Base64UrlEncode(std::string_view input);
+    // Returns the decoded length, or -1 on invalid input or overflow.
+    static int Base64UrlDecode(std::string_view input, unsigned char* out, size_t capacity);
+    static bool ParseClaims(std::string_view payload, JWTClaims* claims);
 };
 
 }
@@ -1,6 +1,7 @@
 #ifndef OURCHAT_LOGGER_H
 #define OURCHAT_LOGGER_H
 
+#include <atomic>
 #include <string>
 #include <memory>
 #include <functional>
@@ -25,6 +26,8 @@ public:
     
     void SetLogLevel(LogLevel level);
     void SetOutputFile(const std::string& filepath);
+    // Stops writing to the log file, if one is open.
+    void CloseOutputFile();
     void SetConsoleOutput(bool enable);
     
     void Debug(const std::string& message);
@@ -42,9 +45,10 @@ private:
     void Write(LogLevel level, const std::string& message);
     std::string GetCurrentTime();
     
-    LogLevel current_level_;
+    // Changed at runtime by config reloads.
+    std::atomic<LogLevel> current_level_;
     std::string output_file_;
-    bool console_output_;
+    std::atomic<bool> console_output_;
     std::mutex mutex_;
     FILE* file_handle_;
 };
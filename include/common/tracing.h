@@ -0,0 +1,171 @@
+#ifndef OURCHAT_TRACING_H
+#define OURCHAT_TRACING_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "config.h"
+
+namespace ourchat {
+
+// W3C trace context, carried in the "traceparent" metadata entry:
+// 00-<32 hex trace id>-<16 hex parent span id>-<2 hex flags>.
+struct TraceContext {
+    uint64_t trace_id_high = 0;
+    uint64_t trace_id_low = 0;
+    uint64_t span_id = 0;
+    bool sampled = false;
+
+    bool Valid() const { return (trace_id_high | trace_id_low) != 0 && span_id != 0; }
+
+    static bool Parse(std::string_view traceparent, TraceContext* out);
+    std::string ToTraceparent() const;
+};
+
+enum class SpanKind {
+    kInternal = 1,
+    kServer = 2,
+    kClient = 3
+};
+
+// A finished span, as queued for export.
+struct SpanData {
+    struct Attribute {
+        const char* key;
+        std::string value;
+        bool is_int;
+    };
+
+    TraceContext context;
+    uint64_t parent_span_id = 0;
+    std::string name;
+    SpanKind kind = SpanKind::kInternal;
+    uint64_t start_unix_nanos = 0;
+    uint64_t end_unix_nanos = 0;
+    std::vector<Attribute> attributes;
+    bool error = false;
+    std::string status_message;
+};
+
+// Collects finished spans and appends them to tracing.export_path as OTLP
+// JSON, one ExportTraceServiceRequest per line (the format the collector's
+// otlpjsonfile receiver reads, so it can forward them over OTLP). Spans are
+// buffered up to max_queued_spans and written by one background thread every
+// flush_interval_ms; when the writer falls behind new spans are dropped and
+// counted rather than blocking the call that produced them.
+class Tracer {
+public:
+    static std::shared_ptr<Tracer> Instance();
+
+    ~Tracer();
+
+    bool Start(const TracingConfig& config, const std::string& service_name);
+    // Writes what is queued and stops the writer.
+    void Stop();
+
+    bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Head-based decision for a new trace, derived from its id so every
+    // node reaches the same answer for the same trace.
+    bool ShouldSample(uint64_t trace_id_low) const;
+
+    void Submit(SpanData&& span);
+
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    Tracer() = default;
+
+    void Run();
+    void Write(const std::vector<SpanData>& spans);
+
+    std::atomic<bool> enabled_{false};
+    // sample_ratio scaled to the uint64_t range; ids below it are sampled.
+    uint64_t sample_threshold_ = 0;
+    bool sample_all_ = false;
+    size_t max_queued_ = 0;
+    int flush_interval_ms_ = 0;
+    std::string service_name_;
+    FILE* file_ = nullptr;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<SpanData> queue_;
+    bool stopping_ = false;
+    std::thread writer_;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// A timed operation in the trace of the current call. Each thread tracks
+// the context of its innermost open span, so a Span declared while a sampled
+// call runs on this thread becomes its child, and one declared anywhere else
+// records nothing: the cost of an unsampled span is one thread-local load,
+// and the attribute setters return at once.
+//
+// A trace only begins at StartServer, which TracingInterceptor calls for
+// every incoming call.
+class Span {
+public:
+    explicit Span(const char* name, SpanKind kind = SpanKind::kInternal) {
+        if (current_.sampled) Open(current_, name, kind);
+    }
+    ~Span() {
+        if (data_) End();
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    // Continues the trace in traceparent if it is valid, else starts a new
+    // one subject to head sampling. Returns nullptr when tracing is off or
+    // the trace is not sampled. Either way whatever an earlier call left
+    // current on this thread is dropped first.
+    static std::unique_ptr<Span> StartServer(std::string_view method, std::string_view traceparent);
+
+    // The context of the innermost open span on this thread, for
+    // propagating to outgoing calls; not Valid() when nothing is recorded.
+    static TraceContext Current() { return current_; }
+
+    bool Recording() const { return data_ != nullptr; }
+
+    // Keys are kept by pointer: pass string literals.
+    void SetAttribute(const char* key, std::string_view value) {
+        if (data_) AddAttribute(key, std::string(value), false);
+    }
+    void SetAttribute(const char* key, int64_t value) {
+        if (data_) AddAttribute(key, std::to_string(value), true);
+    }
+    void SetError(std::string_view message) {
+        if (data_) RecordError(message);
+    }
+
+    // Idempotent; the destructor calls it.
+    void End();
+
+private:
+    Span() = default;
+
+    void Open(const TraceContext& parent, std::string_view name, SpanKind kind);
+    void AddAttribute(const char* key, std::string value, bool is_int);
+    void RecordError(std::string_view message);
+
+    static inline thread_local TraceContext current_;
+
+    std::unique_ptr<SpanData> data_;
+    // Restored as the thread's current context when this span ends.
+    TraceContext parent_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_TRACING_H
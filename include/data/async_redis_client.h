@@ -0,0 +1,133 @@
+#ifndef OURCHAT_ASYNC_REDIS_CLIENT_H
+#define OURCHAT_ASYNC_REDIS_CLIENT_H
+
+#include "common/config.h"
+#include "data/redis_script.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <hiredis/async.h>
+
+namespace ourchat {
+
+// Owned copy of a redisReply that can outlive the callback and cross threads.
+struct RedisValue {
+    int type = REDIS_REPLY_NIL;
+    std::string str;
+    long long integer = 0;
+    std::vector<RedisValue> elements;
+
+    bool IsError() const { return type == REDIS_REPLY_ERROR; }
+
+    // A null reply (the command never got an answer) becomes an error value.
+    static RedisValue From(const redisReply* reply);
+    static RedisValue Error(const std::string& message);
+};
+
+// Redis client that multiplexes any number of concurrent callers over a few
+// redisAsyncContext connections driven by one epoll event loop thread.
+//
+// Execute() only queues the command and wakes the loop through an eventfd
+// (once per batch); the loop hands every queued command to hiredis before
+// the socket becomes writable, so commands issued close together go out in
+// a single write and their replies come back in a single read.
+class AsyncRedisClient {
+public:
+    // Runs on the event loop thread and must not block. reply is nullptr
+    // when the command got no answer (connection lost or client stopped)
+    // and is freed once the callback returns.
+    using Callback = std::function<void(const redisReply* reply)>;
+
+    static std::shared_ptr<AsyncRedisClient> Instance();
+
+    bool Start(const RedisConfig& config);
+    // Waits up to timeout for commands in flight to be answered; false if
+    // some were still pending. Run before Stop() on shutdown so
+    // fire-and-forget writes are not dropped.
+    bool Drain(std::chrono::milliseconds timeout);
+    void Stop();
+
+    // Returns false without calling callback if the client is not running
+    // or async_max_pending commands are already in flight.
+    bool Execute(std::vector<std::string> args, Callback callback);
+    std::future<RedisValue> Execute(std::vector<std::string> args);
+
+    // EVALSHA of a registered script (loaded on every connection as it
+    // opens); a NOSCRIPT reply is retried once with EVAL and the source.
+    // callback sees only the final reply.
+    bool EvalScript(const RedisScript& script, const std::vector<std::string>& keys,
+                    const std::vector<std::string>& args, Callback callback);
+
+    size_t Pending() const { return pending_.load(std::memory_order_relaxed); }
+
+    ~AsyncRedisClient();
+
+private:
+    AsyncRedisClient() = default;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        std::vector<std::string> args;
+        Callback callback;
+    };
+
+    // Owned by the loop thread.
+    struct Connection {
+        AsyncRedisClient* owner = nullptr;
+        redisAsyncContext* context = nullptr;
+        int fd = -1;
+        uint32_t events = 0;
+        bool registered = false;
+        bool ready = false;
+        Clock::time_point retry_at;
+        std::chrono::milliseconds backoff{0};
+    };
+
+    void Loop();
+    void Dispatch();
+    void Connect(Connection* connection);
+    void ScheduleRetry(Connection* connection);
+    void Fail(Request* request);
+    void Wake();
+
+    static void OnConnect(const redisAsyncContext* context, int status);
+    static void OnDisconnect(const redisAsyncContext* context, int status);
+    static void OnReply(redisAsyncContext* context, void* reply, void* privdata);
+
+    // hiredis event hooks; privdata is the Connection.
+    static void AddRead(void* privdata);
+    static void DelRead(void* privdata);
+    static void AddWrite(void* privdata);
+    static void DelWrite(void* privdata);
+    static void Cleanup(void* privdata);
+    void UpdateEvents(Connection* connection, uint32_t events);
+
+    static constexpr std::chrono::milliseconds kMinBackoff{100};
+    static constexpr std::chrono::milliseconds kMaxBackoff{5000};
+
+    RedisConfig config_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+    size_t next_connection_ = 0;
+
+    int epoll_fd_ = -1;
+    int event_fd_ = -1;
+    std::thread loop_thread_;
+    std::atomic<bool> running_{false};
+
+    std::mutex queue_mutex_;
+    std::vector<Request> queue_;
+    bool accepting_ = false;
+
+    std::atomic<size_t> pending_{0};
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_ASYNC_REDIS_CLIENT_H
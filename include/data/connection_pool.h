@@ -0,0 +1,366 @@
+#ifndef OURCHAT_CONNECTION_POOL_H
+#define OURCHAT_CONNECTION_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sched.h>
+#include "../common/tracing.h"
+
+namespace ourchat {
+
+// Fixed-size pool of connections handed out as scoped leases.
+//
+// Idle connections live in per-CPU free lists (LIFO, so the warmest
+// connection is reused first); a borrow tries the current CPU's list and
+// then steals from the others. Each list has its own mutex, so checkout and
+// return are an uncontended lock and no syscall in the common case.
+//
+// Nothing is checked on return except the connection's own cheap
+// is_usable() flag. A connection that sat idle longer than validate_after
+// is validated (e.g. pinged) on borrow. Broken connections are dropped;
+// borrowers never connect. Replacements are opened by Maintain(), which the
+// owner calls periodically from one background thread: it validates stale
+// idle connections one at a time outside every lock and refills the pool,
+// backing off exponentially while the server is unreachable.
+//
+// Resize() changes the target size at runtime: Maintain() opens the extra
+// connections, and surplus ones are closed when returned or found idle.
+template <typename T>
+class ConnectionPool {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Factory = std::function<std::unique_ptr<T>()>;
+    using Check = std::function<bool(T&)>;
+
+    struct Options {
+        size_t size = 10;
+        std::chrono::milliseconds validate_after{30000};
+        // Cheap, no I/O; called when a lease is released.
+        Check is_usable;
+        // May do I/O; called on borrow after validate_after of idleness.
+        Check validate;
+        // Delay between failed refills, doubled per failure up to the max.
+        std::chrono::milliseconds reconnect_backoff_min{500};
+        std::chrono::milliseconds reconnect_backoff_max{30000};
+    };
+
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(ConnectionPool* pool, std::unique_ptr<T> connection)
+            : pool_(pool), connection_(std::move(connection)) {}
+        ~Lease() { Release(); }
+
+        Lease(Lease&& other) noexcept
+            : pool_(other.pool_), connection_(std::move(other.connection_)) {
+            other.pool_ = nullptr;
+        }
+
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                Release();
+                pool_ = other.pool_;
+                connection_ = std::move(other.connection_);
+                other.pool_ = nullptr;
+            }
+            return *this;
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        T* operator->() const { return connection_.get(); }
+        T& operator*() const { return *connection_; }
+        T* get() const { return connection_.get(); }
+        explicit operator bool() const { return connection_ != nullptr; }
+
+        // Drops the connection instead of returning it to the pool.
+        void Discard() {
+            if (pool_ && connection_) pool_->Drop(std::move(connection_));
+            pool_ = nullptr;
+        }
+
+        void Release() {
+            if (pool_ && connection_) pool_->Return(std::move(connection_));
+            pool_ = nullptr;
+        }
+
+    private:
+        ConnectionPool* pool_ = nullptr;
+        std::unique_ptr<T> connection_;
+    };
+
+    ConnectionPool(const std::string& name, Factory factory, Options options)
+        : name_(name), factory_(std::move(factory)), options_(std::move(options)),
+          shards_(ShardCount()), size_(options_.size), backoff_(options_.reconnect_backoff_min) {}
+
+    ~ConnectionPool() { Close(); }
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Opens the configured number of connections; returns how many are open.
+    size_t Init() {
+        closed_ = false;
+        Refill();
+        return live_.load();
+    }
+
+    // With wait, blocks until a connection is free. Returns an empty lease if
+    // the pool is closed or has no live connections; callers fail fast while
+    // the server is down instead of queueing behind reconnect attempts.
+    Lease Borrow(bool wait = true) {
+        Span span("pool.checkout");
+        span.SetAttribute("pool.name", name_);
+        int64_t waits = 0;
+
+        while (!closed_) {
+            IdleConnection entry;
+            if (Pop(&entry)) {
+                if (options_.validate && Clock::now() - entry.since > options_.validate_after &&
+                    !options_.validate(*entry.connection)) {
+                    Drop(std::move(entry.connection));
+                    continue;
+                }
+                if (waits > 0) span.SetAttribute("pool.waits", waits);
+                return Lease(this, std::move(entry.connection));
+            }
+
+            if (!wait || live_.load() == 0) break;
+
+            waits++;
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            waiters_.fetch_add(1);
+            wait_cv_.wait(lock, [this]() {
+                return closed_ || idle_.load() > 0 || live_.load() == 0;
+            });
+            waiters_.fetch_sub(1);
+        }
+        span.SetError("no connection available");
+        return Lease();
+    }
+
+    // One health-check round: validates stale idle connections, then reopens
+    // missing ones unless a previous attempt failed within the backoff.
+    // Must only be called from a single thread.
+    void Maintain() {
+        Trim();
+        CheckIdle();
+
+        auto now = Clock::now();
+        if (now < next_refill_) return;
+
+        if (Refill()) {
+            backoff_ = options_.reconnect_backoff_min;
+            next_refill_ = Clock::time_point();
+        } else {
+            connect_failures_.fetch_add(1, std::memory_order_relaxed);
+            next_refill_ = now + backoff_;
+            backoff_ = std::min(backoff_ * 2, options_.reconnect_backoff_max);
+        }
+    }
+
+    // Validates idle connections that exceeded validate_after, one at a time
+    // and outside every lock.
+    void CheckIdle() {
+        size_t budget = idle_.load();
+        for (size_t i = 0; i < budget && !closed_; i++) {
+            std::unique_ptr<T> connection = PopStale();
+            if (!connection) break;
+
+            if (Validate(connection.get())) {
+                Push(std::move(connection));
+            } else {
+                Drop(std::move(connection));
+            }
+        }
+    }
+
+    void Resize(size_t size) {
+        size_.store(size);
+    }
+
+    void Close() {
+        closed_ = true;
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+        }
+        wait_cv_.notify_all();
+
+        for (auto& shard : shards_) {
+            std::vector<IdleConnection> idle;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                idle.swap(shard.idle);
+                idle_.fetch_sub(idle.size());
+            }
+            live_.fetch_sub(idle.size());
+        }
+    }
+
+    const std::string& Name() const { return name_; }
+    size_t Capacity() const { return size_.load(std::memory_order_relaxed); }
+    size_t Live() const { return live_.load(std::memory_order_relaxed); }
+    size_t Idle() const { return idle_.load(std::memory_order_relaxed); }
+    size_t InUse() const {
+        size_t live = Live();
+        size_t idle = Idle();
+        return live > idle ? live - idle : 0;
+    }
+    // Refill rounds that failed to open a connection.
+    uint64_t ConnectFailures() const { return connect_failures_.load(std::memory_order_relaxed); }
+
+private:
+    struct IdleConnection {
+        std::unique_ptr<T> connection;
+        Clock::time_point since;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<IdleConnection> idle;
+    };
+
+    static size_t ShardCount() {
+        size_t cpus = std::thread::hardware_concurrency();
+        return std::min<size_t>(std::max<size_t>(cpus, 1), 64);
+    }
+
+    size_t HomeShard() const {
+        int cpu = sched_getcpu();
+        return cpu < 0 ? 0 : static_cast<size_t>(cpu) % shards_.size();
+    }
+
+    // Opens connections until the pool is back at its size. Stops at the
+    // first failure and returns false.
+    bool Refill() {
+        while (!closed_ && ReserveSlot()) {
+            auto connection = factory_();
+            if (!connection) {
+                Drop(nullptr);
+                return false;
+            }
+            Push(std::move(connection));
+        }
+        return true;
+    }
+
+    bool Validate(T* connection) {
+        return !options_.validate || options_.validate(*connection);
+    }
+
+    void Push(std::unique_ptr<T> connection) {
+        Shard& shard = shards_[HomeShard()];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.idle.push_back(IdleConnection{std::move(connection), Clock::now()});
+            idle_.fetch_add(1);
+        }
+        WakeWaiter();
+    }
+
+    bool Pop(IdleConnection* entry) {
+        if (idle_.load() == 0) return false;
+
+        size_t home = HomeShard();
+        for (size_t i = 0; i < shards_.size(); i++) {
+            Shard& shard = shards_[(home + i) % shards_.size()];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.idle.empty()) continue;
+
+            *entry = std::move(shard.idle.back());
+            shard.idle.pop_back();
+            idle_.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    // Oldest idle connection past validate_after, if any.
+    std::unique_ptr<T> PopStale() {
+        auto cutoff = Clock::now() - options_.validate_after;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.idle.empty() || shard.idle.front().since > cutoff) continue;
+
+            IdleConnection entry = std::move(shard.idle.front());
+            shard.idle.erase(shard.idle.begin());
+            idle_.fetch_sub(1);
+            return std::move(entry.connection);
+        }
+        return nullptr;
+    }
+
+    // Claims room for one more connection if the pool is below its size.
+    bool ReserveSlot() {
+        size_t live = live_.load();
+        while (live < size_.load()) {
+            if (live_.compare_exchange_weak(live, live + 1)) return true;
+        }
+        return false;
+    }
+
+    // Closes idle connections while the pool is above its size.
+    void Trim() {
+        while (live_.load() > size_.load()) {
+            IdleConnection entry;
+            if (!Pop(&entry)) break;
+            Drop(std::move(entry.connection));
+        }
+    }
+
+    void Return(std::unique_ptr<T> connection) {
+        if (closed_ || live_.load() > size_.load() ||
+            (options_.is_usable && !options_.is_usable(*connection))) {
+            Drop(std::move(connection));
+            return;
+        }
+        Push(std::move(connection));
+    }
+
+    void Drop(std::unique_ptr<T> connection) {
+        connection.reset();
+        live_.fetch_sub(1);
+        WakeWaiter();
+    }
+
+    void WakeWaiter() {
+        if (waiters_.load() == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+        }
+        wait_cv_.notify_one();
+    }
+
+    std::string name_;
+    Factory factory_;
+    Options options_;
+
+    std::vector<Shard> shards_;
+    std::atomic<size_t> size_;
+    std::atomic<size_t> live_{0};
+    std::atomic<size_t> idle_{0};
+    std::atomic<bool> closed_{false};
+    std::atomic<uint64_t> connect_failures_{0};
+
+    // Owned by the thread calling Maintain().
+    std::chrono::milliseconds backoff_;
+    Clock::time_point next_refill_;
+
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+    std::atomic<int> waiters_{0};
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_CONNECTION_POOL_H
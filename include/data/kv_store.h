@@ -0,0 +1,44 @@
+#ifndef OURCHAT_KV_STORE_H
+#define OURCHAT_KV_STORE_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ourchat {
+
+// The Redis commands the services rely on for shared, expiring state
+// (tokens, send deduplication, revocation versions). RedisKVStore is the
+// production implementation; MemoryKVStore serves a single process.
+// Obtained from Storage.
+//
+// Failures look like a missing key: reads return empty, writes false.
+class KVStore {
+public:
+    virtual ~KVStore() = default;
+
+    virtual std::string Get(const std::string& key) = 0;
+    virtual bool SetEx(const std::string& key, int seconds, const std::string& value) = 0;
+    // False if the key exists (or on failure).
+    virtual bool SetNxEx(const std::string& key, int seconds, const std::string& value) = 0;
+    // Writes all entries with one TTL in a single round trip, atomically
+    // whenever the backend can: always on a single Redis, and under Redis
+    // Cluster when the keys share a hash slot (give them a {hash tag}).
+    virtual bool SetExMany(const std::vector<std::pair<std::string, std::string>>& entries,
+                           int seconds) = 0;
+    virtual bool Del(const std::string& key) = 0;
+    virtual bool Expire(const std::string& key, int seconds) = 0;
+
+    virtual std::string HGet(const std::string& key, const std::string& field) = 0;
+    // The new value, or 0 on failure.
+    virtual int64_t HIncrBy(const std::string& key, const std::string& field, int64_t increment) = 0;
+    virtual std::map<std::string, std::string> HGetAll(const std::string& key) = 0;
+
+    // Fire and forget.
+    virtual void Publish(const std::string& channel, const std::string& message) = 0;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_KV_STORE_H
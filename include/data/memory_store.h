@@ -0,0 +1,154 @@
+#ifndef OURCHAT_MEMORY_STORE_H
+#define OURCHAT_MEMORY_STORE_H
+
+#include "kv_store.h"
+#include "message_store.h"
+#include "user_store.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ourchat {
+
+// In-process stand-ins for the MySQL and Redis backed stores, selected with
+// storage.backend: memory. They keep the semantics the services rely on
+// (unique usernames, newest-first pages, NX claims, expiry) but persist
+// nothing and are not shared between nodes. Nothing is evicted except
+// expired keys, so they are meant for benchmark and load-test runs.
+
+// Delay added to every store call so the stand-ins can model a backend
+// round trip: latency_us plus a uniform draw from [0, jitter_us]. The
+// calling thread sleeps, as it would block on a socket.
+class SimulatedLatency {
+public:
+    SimulatedLatency(int latency_us, int jitter_us);
+
+    void Wait() const;
+
+private:
+    int latency_us_;
+    int jitter_us_;
+};
+
+class MemoryUserStore : public UserStore {
+public:
+    explicit MemoryUserStore(SimulatedLatency latency);
+
+    bool Create(UserRecord* record) override;
+    bool FindByUsername(const std::string& username, UserRecord* out, bool* found) override;
+    bool UpdatePasswordHash(int64_t user_id, const std::string& old_hash,
+                            const std::string& new_hash) override;
+
+private:
+    SimulatedLatency latency_;
+
+    std::shared_mutex mutex_;
+    std::unordered_map<std::string, UserRecord> by_username_;
+    std::unordered_map<int64_t, std::string> username_by_id_;
+    int64_t next_id_ = 1;
+};
+
+// Messages per conversation (and per group) in id order, sharded by
+// conversation id. Ids come from IdGenerator like the partitioned MySQL
+// store, so pagination by before_id behaves the same.
+class MemoryMessageStore : public MessageStore {
+public:
+    explicit MemoryMessageStore(SimulatedLatency latency);
+
+    bool InsertSingle(MessageRecord* record) override;
+    bool InsertGroup(GroupMessageRecord* record) override;
+    bool QuerySingle(int64_t reader_id, int64_t conversation_id, int64_t before_id,
+                     int64_t start_time, int limit, std::vector<MessageRecord>* out,
+                     bool* current) override;
+    bool IsGroupMember(int64_t group_id, int64_t user_id, bool* member) override;
+    bool SaveReadReceipts(const std::vector<ReadReceiptRecord>& receipts) override;
+
+    // Groups are not created in process; load tests seed members here.
+    void AddGroupMember(int64_t group_id, int64_t user_id);
+
+private:
+    static constexpr size_t kShardCount = 16;
+
+    template <typename Record>
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<int64_t, std::vector<Record>> messages;
+    };
+
+    template <typename Record>
+    static void InsertOrdered(std::vector<Record>* messages, Record record);
+
+    static size_t ShardOf(int64_t key);
+
+    SimulatedLatency latency_;
+
+    Shard<MessageRecord> conversations_[kShardCount];
+    Shard<GroupMessageRecord> groups_[kShardCount];
+
+    std::shared_mutex members_mutex_;
+    std::set<std::pair<int64_t, int64_t>> group_members_;
+
+    std::mutex receipts_mutex_;
+    std::map<std::pair<int64_t, int64_t>, ReadReceiptRecord> receipts_;
+};
+
+// String and hash keys with per-key expiry, in shards. Expired keys are
+// dropped when touched and by a sweep of the shard every kSweepInterval
+// writes. Publish has no subscribers in process and is a no-op.
+class MemoryKVStore : public KVStore {
+public:
+    explicit MemoryKVStore(SimulatedLatency latency);
+
+    std::string Get(const std::string& key) override;
+    bool SetEx(const std::string& key, int seconds, const std::string& value) override;
+    bool SetNxEx(const std::string& key, int seconds, const std::string& value) override;
+    bool SetExMany(const std::vector<std::pair<std::string, std::string>>& entries,
+                   int seconds) override;
+    bool Del(const std::string& key) override;
+    bool Expire(const std::string& key, int seconds) override;
+
+    std::string HGet(const std::string& key, const std::string& field) override;
+    int64_t HIncrBy(const std::string& key, const std::string& field, int64_t increment) override;
+    std::map<std::string, std::string> HGetAll(const std::string& key) override;
+
+    void Publish(const std::string& channel, const std::string& message) override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string value;
+        std::map<std::string, std::string> hash;
+        // Clock::time_point::max() for keys without a TTL.
+        Clock::time_point expires_at;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        size_t writes = 0;
+    };
+
+    static constexpr size_t kShardCount = 16;
+    static constexpr size_t kSweepInterval = 4096;
+
+    Shard& GetShard(const std::string& key);
+    // The live entry for key, erasing it if it has expired.
+    static Entry* FindLocked(Shard& shard, const std::string& key, Clock::time_point now);
+    static void SetLocked(Shard& shard, const std::string& key, int seconds,
+                          const std::string& value, Clock::time_point now);
+
+    SimulatedLatency latency_;
+    Shard shards_[kShardCount];
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_MEMORY_STORE_H
@@ -0,0 +1,70 @@
+#ifndef OURCHAT_MESSAGE_STORE_H
+#define OURCHAT_MESSAGE_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ourchat {
+
+struct MessageRecord {
+    int64_t id = 0;
+    int64_t conversation_id = 0;
+    int64_t sender_id = 0;
+    int64_t receiver_id = 0;
+    int message_type = 0;
+    std::string content;
+    int status = 0;
+    int64_t create_time = 0;
+};
+
+struct GroupMessageRecord {
+    int64_t id = 0;
+    int64_t group_id = 0;
+    int64_t sender_id = 0;
+    int message_type = 0;
+    std::string content;
+    int64_t seq_id = 0;
+    int64_t create_time = 0;
+};
+
+struct ReadReceiptRecord {
+    int64_t user_id = 0;
+    int64_t peer_id = 0;
+    int64_t last_read_message_id = 0;
+    int64_t read_time = 0;
+};
+
+// Message persistence used by the message and group services. The server
+// runs MySQLMessageStore; MemoryMessageStore keeps everything in process
+// for benchmarks and load tests. Obtained from Storage.
+class MessageStore {
+public:
+    virtual ~MessageStore() = default;
+
+    // Assigns id and create_time before writing.
+    virtual bool InsertSingle(MessageRecord* record) = 0;
+
+    // The time ordered id doubles as seq_id. Assigns id, seq_id and
+    // create_time before writing.
+    virtual bool InsertGroup(GroupMessageRecord* record) = 0;
+
+    // Newest first, ids below before_id (0 for the newest) and create_time
+    // not after start_time (0 for no bound). reader_id is the user asking,
+    // so a store with replicas can keep them on their own writes. *current
+    // is set to whether the page reflects every committed write, i.e. was
+    // not read from a replica that may lag.
+    virtual bool QuerySingle(int64_t reader_id, int64_t conversation_id, int64_t before_id,
+                             int64_t start_time, int limit, std::vector<MessageRecord>* out,
+                             bool* current) = 0;
+
+    // False only when the store could not be read.
+    virtual bool IsGroupMember(int64_t group_id, int64_t user_id, bool* member) = 0;
+
+    // Upserts each (user_id, peer_id); last_read_message_id never moves back.
+    virtual bool SaveReadReceipts(const std::vector<ReadReceiptRecord>& receipts) = 0;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_MESSAGE_STORE_H
@@ -22,17 +22,26 @@ public:
     
     std::unique_ptr<MYSQL_RES> Query(const std::string& query);
     
+    std::string Escape(const std::string& value);
+    
     bool BeginTransaction();
     bool Commit();
     bool Rollback();
     
     bool Ping();
     
+    // Set when a query failed because the server connection was lost, so
+    // the pool can drop the connection without pinging it.
+    bool IsBroken() const;
+    
     MYSQL* GetRawConnection();
     
 private:
+    void CheckError();
+    
     MYSQL* connection_;
     bool connected_;
+    bool broken_ = false;
 };
 
 } // namespace ourchat
@@ -0,0 +1,91 @@
+#ifndef OURCHAT_MYSQL_MESSAGE_STORE_H
+#define OURCHAT_MYSQL_MESSAGE_STORE_H
+
+#include "message_store.h"
+#include "mysql_pool.h"
+#include "../common/config.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ourchat {
+
+// Routes single chat messages to tables named
+// im_single_message_s<shard>_<yyyymm>, where the shard comes from the
+// conversation id and the month from the (time ordered) message id. Each
+// table is created on first write from the im_single_message template, so
+// index maintenance cost depends on the size of one month of one shard.
+// The unpartitioned im_single_message table is read last for history that
+// predates partitioning.
+//
+// Other nodes create partitions too, so a month this node has not seen a
+// table for is checked against the primary before a read skips it. Months
+// that have ended cannot gain a table and are remembered as absent; the
+// current month is checked again after kAbsentRecheck.
+//
+// Group messages stay in im_group_message and read receipts in
+// im_message_read. Reads are served by a replica unless the reader wrote
+// recently; partitions are visited from the newest month backwards and
+// only until the page is full.
+class MySQLMessageStore : public MessageStore {
+public:
+    MySQLMessageStore() = default;
+
+    bool Init(const MessageStoreConfig& config);
+
+    bool InsertSingle(MessageRecord* record) override;
+    bool InsertGroup(GroupMessageRecord* record) override;
+    bool QuerySingle(int64_t reader_id, int64_t conversation_id, int64_t before_id,
+                     int64_t start_time, int limit, std::vector<MessageRecord>* out,
+                     bool* current) override;
+    bool IsGroupMember(int64_t group_id, int64_t user_id, bool* member) override;
+    bool SaveReadReceipts(const std::vector<ReadReceiptRecord>& receipts) override;
+
+private:
+    int ShardOf(int64_t conversation_id) const;
+    static int MonthOf(int64_t timestamp_ms);
+    static int PreviousMonth(int month);
+    std::string TableName(int shard, int month) const;
+
+    bool LoadPartitions();
+    bool EnsurePartition(MySQLConnection* conn, int shard, int month);
+    // Tables to read for shard, newest month first, ending with the base
+    // table. Looks up months not known either way on the primary first.
+    std::vector<std::string> PlanPartitions(int shard, int newest_month);
+    void ProbePartitions(int shard, const std::vector<int>& months);
+    bool QueryPartitions(MySQLConnection* conn, const std::vector<std::string>& tables,
+                         int64_t conversation_id, int64_t before_id, int64_t start_time,
+                         int limit, std::vector<MessageRecord>* out);
+
+    bool QueryTable(MySQLConnection* conn, const std::string& table,
+                    int64_t conversation_id, int64_t before_id, int64_t start_time,
+                    int limit, std::vector<MessageRecord>* out);
+
+    using Clock = std::chrono::steady_clock;
+
+    static const char* kBaseTable;
+    static constexpr size_t kReceiptRowsPerStatement = 500;
+    static constexpr std::chrono::seconds kAbsentRecheck{1};
+    // How long after a month ends a node with a lagging clock may still
+    // create its table.
+    static constexpr int64_t kMonthSettleMs = 3600 * 1000;
+
+    MessageStoreConfig config_;
+    std::shared_ptr<MySQLPool> mysql_pool_;
+
+    std::mutex mutex_;
+    // Per shard: months with a table, and months without one mapped to when
+    // to look again (Clock::time_point::max() once the month has ended).
+    std::vector<std::set<int>> partitions_;
+    std::vector<std::map<int, Clock::time_point>> absent_;
+    // No partition is older than this month.
+    int oldest_month_ = 0;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_MYSQL_MESSAGE_STORE_H
@@ -1,49 +1,95 @@
 #ifndef OURCHAT_MYSQL_POOL_H
 #define OURCHAT_MYSQL_POOL_H
 
+#include "connection_pool.h"
 #include "mysql_connection.h"
 #include "../common/config.h"
-#include <queue>
 #include <mutex>
-#include <condition_variable>
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
 
 namespace ourchat {
 
+enum class QueryIntent {
+    kRead,
+    kWrite
+};
+
+using MySQLLease = ConnectionPool<MySQLConnection>::Lease;
+
+// Keeps one connection pool for the primary and one per read replica.
+// Writes always go to the primary. Reads go to a healthy replica whose
+// replication lag is within replica_max_lag, unless the user wrote within
+// read_your_writes_window, in which case they stay on the primary.
 class MySQLPool {
 public:
     static std::shared_ptr<MySQLPool> Instance();
-    
+
     bool Init(const DatabaseConfig& config);
-    std::unique_ptr<MySQLConnection> GetConnection();
-    void ReturnConnection(std::unique_ptr<MySQLConnection> connection);
-    
+    // The connection goes back to its pool when the lease is destroyed.
+    // *replica, if given, is set to whether the lease is on a replica.
+    MySQLLease GetConnection(QueryIntent intent = QueryIntent::kWrite, int64_t user_id = 0,
+                             bool* replica = nullptr);
+
+    void MarkWrite(int64_t user_id);
+    bool HasReplicas() const;
+
+    // New target sizes for the primary and for each replica pool.
+    void Resize(int pool_size, int replica_pool_size);
+
     void Close();
-    
+
     int GetPoolSize();
     int GetActiveConnections();
     int GetIdleConnections();
-    
+
 public:
     ~MySQLPool();
 
 private:
     MySQLPool() = default;
-    
-    void CreateConnection();
+
+    struct Endpoint {
+        std::string host;
+        int port = 0;
+        std::unique_ptr<ConnectionPool<MySQLConnection>> pool;
+        std::atomic<bool> healthy{true};
+        std::atomic<int> lag_seconds{0};
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t kPrimary = 0;
+    // Idle connections older than this are pinged before being handed out.
+    static constexpr std::chrono::seconds kValidateAfterIdle{30};
+    static constexpr size_t kWriterShardCount = 16;
+
+    struct WriterShard {
+        std::mutex mutex;
+        std::unordered_map<int64_t, Clock::time_point> last_write;
+    };
+
+    MySQLLease Acquire(size_t index, bool wait);
+    Endpoint* PickReplica(size_t* index);
+    bool RecentlyWrote(int64_t user_id);
+    void PruneWriters();
+
+    void AddEndpoint(const std::string& host, int port, int pool_size);
+    std::unique_ptr<MySQLConnection> CreateConnection(const Endpoint& endpoint);
     void CheckConnections();
-    
-    std::queue<std::unique_ptr<MySQLConnection>> connections_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    
+    void CheckReplicaLag();
+
+    std::vector<std::unique_ptr<Endpoint>> endpoints_;
+    std::atomic<size_t> next_replica_{0};
+    WriterShard writers_[kWriterShardCount];
+
     DatabaseConfig config_;
     std::atomic<bool> running_{false};
     std::thread monitor_thread_;
-    
-    int active_count_ = 0;
 };
 
 } // namespace ourchat
@@ -0,0 +1,28 @@
+#ifndef OURCHAT_MYSQL_USER_STORE_H
+#define OURCHAT_MYSQL_USER_STORE_H
+
+#include "user_store.h"
+#include "mysql_pool.h"
+#include <memory>
+
+namespace ourchat {
+
+// im_user through MySQLPool. Lookups go to a replica and fall back to the
+// primary when the user is missing there, since the account may be newer
+// than what the replica has applied.
+class MySQLUserStore : public UserStore {
+public:
+    MySQLUserStore();
+
+    bool Create(UserRecord* record) override;
+    bool FindByUsername(const std::string& username, UserRecord* out, bool* found) override;
+    bool UpdatePasswordHash(int64_t user_id, const std::string& old_hash,
+                            const std::string& new_hash) override;
+
+private:
+    std::shared_ptr<MySQLPool> mysql_pool_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_MYSQL_USER_STORE_H
@@ -0,0 +1,105 @@
+#ifndef OURCHAT_NEAR_CACHE_H
+#define OURCHAT_NEAR_CACHE_H
+
+#include "redis_client.h"
+#include "common/config.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace ourchat {
+
+// In-process cache of Redis string keys under the configured prefixes, kept
+// coherent with server-assisted client tracking.
+//
+// A dedicated connection subscribes to __redis__:invalidate and a second one
+// turns on CLIENT TRACKING in broadcast mode for the prefixes, redirecting
+// invalidations to the first. Any write to a tracked key, from any node,
+// drops it here. Entries also expire after ttl_ms, which bounds staleness
+// if an invalidation is lost. While the invalidation stream is down the
+// cache is empty and every Get goes to Redis.
+class NearCache {
+public:
+    static std::shared_ptr<NearCache> Instance();
+
+    bool Start(const RedisConfig& redis_config, const NearCacheConfig& config);
+    void Stop();
+
+    // GET key, served locally when cached. Misses (including "no such key")
+    // are cached too. Returns false if the key does not exist or Redis
+    // could not be reached.
+    bool Get(const std::string& key, std::string* value);
+    // Drops key locally; writers call it so this node does not serve the old
+    // value while the invalidation is in flight.
+    void Invalidate(std::string_view key);
+
+    uint64_t Hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t Misses() const { return misses_.load(std::memory_order_relaxed); }
+
+    ~NearCache();
+
+private:
+    NearCache() = default;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string key;
+        std::string value;
+        bool exists;
+        Clock::time_point expires;
+    };
+
+    // The index keys view Entry::key, whose address is stable in the list.
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+        // Bumped by every invalidation, so a fetch that raced one is not
+        // cached.
+        uint64_t epoch = 0;
+    };
+
+    static constexpr size_t kShardCount = 16;
+
+    Shard& GetShard(std::string_view key);
+    bool Tracked(std::string_view key) const;
+    void Insert(Shard& shard, uint64_t epoch, const std::string& key, const std::string& value, bool exists);
+    void Erase(Shard& shard, std::list<Entry>::iterator it);
+    void Clear();
+
+    void Run();
+    bool Track(RedisClient* subscriber, RedisClient* tracker);
+    void HandleInvalidation(const redisReply* reply);
+    void Backoff(int* delay_ms);
+
+    Shard shards_[kShardCount];
+
+    RedisConfig redis_config_;
+    NearCacheConfig config_;
+    size_t shard_max_entries_ = 0;
+    size_t shard_max_bytes_ = 0;
+
+    // True only while invalidations are being delivered.
+    std::atomic<bool> tracking_{false};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+
+    std::atomic<bool> running_{false};
+    std::thread tracking_thread_;
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_NEAR_CACHE_H
@@ -2,14 +2,35 @@
 #define OURCHAT_REDIS_CLIENT_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
+#include <optional>
+#include <initializer_list>
+#include <functional>
+#include <cstdint>
 #include <hiredis/hiredis.h>
+#include "redis_script.h"
 
 namespace ourchat {
 
+struct RedisReplyDeleter {
+    void operator()(redisReply* reply) const { freeReplyObject(reply); }
+};
+
+using RedisReplyPtr = std::unique_ptr<redisReply, RedisReplyDeleter>;
+
+// Every command is sent through redisCommandArgv with explicit lengths, so
+// keys, fields, members and values may hold any bytes, including spaces and
+// NUL (e.g. serialized protobuf messages).
 class RedisClient {
 public:
+    // Called with a MOVED/ASK error reply and the command that caused it;
+    // returns the reply from the node the command was redirected to.
+    using RedirectHandler = std::function<RedisReplyPtr(std::string_view error,
+                                                        const std::vector<std::string_view>& args)>;
+    
     RedisClient();
     ~RedisClient();
     
@@ -17,48 +38,121 @@ public:
     void Close();
     
     bool IsConnected();
+    bool Ping();
+    
+    // Sends one command; returns nullptr on I/O errors.
+    RedisReplyPtr Command(std::initializer_list<std::string_view> args);
+    RedisReplyPtr Command(const std::vector<std::string_view>& args);
     
-    bool Set(const std::string& key, const std::string& value);
-    bool Setex(const std::string& key, int seconds, const std::string& value);
-    bool Setnx(const std::string& key, const std::string& value);
+    // SCRIPT LOAD; true once the server has the script under its SHA1.
+    bool LoadScript(const RedisScript& script);
+    // Every script in RedisScript::All(); returns how many were loaded.
+    size_t LoadScripts();
+    // EVALSHA, retried as EVAL if the server does not have the script.
+    RedisReplyPtr EvalScript(const RedisScript& script,
+                             const std::vector<std::string_view>& keys,
+                             const std::vector<std::string_view>& args);
     
-    std::string Get(const std::string& key);
-    bool Del(const std::string& key);
+    // Pipelining: queue commands with Append, then read one reply per
+    // command with GetReply. Redirects are not followed here.
+    bool Append(const std::vector<std::string>& args);
+    // Writes the appended commands without waiting for replies.
+    bool Flush();
+    RedisReplyPtr GetReply();
+    
+    // Set by RedisCluster so every command on the connection follows
+    // cluster redirects.
+    void SetRedirectHandler(RedirectHandler handler);
+    
+    bool Set(std::string_view key, std::string_view value);
+    bool Setex(std::string_view key, int seconds, std::string_view value);
+    bool Setnx(std::string_view key, std::string_view value);
+    // SET key value NX EX seconds; false if the key already exists.
+    bool SetNxEx(std::string_view key, int seconds, std::string_view value);
+    
+    std::string Get(std::string_view key);
+    // Distinguishes a missing key from an empty value.
+    bool Get(std::string_view key, std::string* value);
+    std::vector<std::optional<std::string>> MGet(const std::vector<std::string>& keys);
+    bool Del(std::string_view key);
     bool Del(const std::vector<std::string>& keys);
-    bool Exists(const std::string& key);
-    
-    bool HSet(const std::string& key, const std::string& field, const std::string& value);
-    bool HDel(const std::string& key, const std::string& field);
-    std::string HGet(const std::string& key, const std::string& field);
-    std::map<std::string, std::string> HGetAll(const std::string& key);
-    std::vector<std::string> HMGet(const std::string& key, const std::vector<std::string>& fields);
-    
-    bool SAdd(const std::string& key, const std::string& member);
-    bool SRem(const std::string& key, const std::string& member);
-    std::vector<std::string> SMembers(const std::string& key);
-    bool SIsMember(const std::string& key, const std::string& member);
-    int SCard(const std::string& key);
-    
-    bool ZAdd(const std::string& key, double score, const std::string& member);
-    bool ZRem(const std::string& key, const std::string& member);
-    std::vector<std::string> ZRange(const std::string& key, int start, int stop);
-    std::vector<std::string> ZRevRange(const std::string& key, int start, int stop);
-    std::vector<std::string> ZRangeByScore(const std::string& key, double min, double max);
-    std::vector<std::string> ZRevRangeByScore(const std::string& key, double min, double max);
-    int ZCard(const std::string& key);
-    
-    int64_t Incr(const std::string& key);
-    int64_t IncrBy(const std::string& key, int64_t increment);
-    int64_t Decr(const std::string& key);
-    
-    bool Expire(const std::string& key, int seconds);
-    int64_t TTL(const std::string& key);
+    bool Exists(std::string_view key);
+    
+    bool HSet(std::string_view key, std::string_view field, std::string_view value);
+    bool HDel(std::string_view key, std::string_view field);
+    std::string HGet(std::string_view key, std::string_view field);
+    bool HGet(std::string_view key, std::string_view field, std::string* value);
+    int64_t HIncrBy(std::string_view key, std::string_view field, int64_t increment);
+    std::map<std::string, std::string> HGetAll(std::string_view key);
+    std::vector<std::string> HMGet(std::string_view key, const std::vector<std::string>& fields);
+    
+    bool SAdd(std::string_view key, std::string_view member);
+    bool SRem(std::string_view key, std::string_view member);
+    std::vector<std::string> SMembers(std::string_view key);
+    bool SIsMember(std::string_view key, std::string_view member);
+    int SCard(std::string_view key);
+    
+    bool ZAdd(std::string_view key, double score, std::string_view member);
+    bool ZRem(std::string_view key, std::string_view member);
+    std::vector<std::string> ZRange(std::string_view key, int start, int stop);
+    std::vector<std::string> ZRevRange(std::string_view key, int start, int stop);
+    std::vector<std::string> ZRangeByScore(std::string_view key, double min, double max);
+    std::vector<std::string> ZRevRangeByScore(std::string_view key, double min, double max);
+    int ZCard(std::string_view key);
+    
+    int64_t Incr(std::string_view key);
+    int64_t IncrBy(std::string_view key, int64_t increment);
+    int64_t Decr(std::string_view key);
+    
+    int64_t Publish(std::string_view channel, std::string_view message);
+    
+    // After Subscribe the connection only delivers messages; read them with
+    // WaitMessage, which returns 1 for a message, 0 on timeout and -1 once
+    // the connection is broken.
+    bool Subscribe(std::string_view channel);
+    int WaitMessage(int timeout_ms, std::string* channel, std::string* message);
+    // Same contract for any reply, for pushes whose payload is not a string.
+    int WaitReply(int timeout_ms, RedisReplyPtr* reply);
+    
+    bool Expire(std::string_view key, int seconds);
+    int64_t TTL(std::string_view key);
+    
+    // Stores message.SerializeToString() under key, with a TTL if seconds > 0.
+    template <typename Message>
+    bool SetProto(std::string_view key, const Message& message, int seconds = 0) {
+        std::string blob;
+        if (!message.SerializeToString(&blob)) return false;
+        return seconds > 0 ? Setex(key, seconds, blob) : Set(key, blob);
+    }
+    
+    // False if the key is missing or does not parse as Message.
+    template <typename Message>
+    bool GetProto(std::string_view key, Message* message) {
+        std::string blob;
+        return Get(key, &blob) && message->ParseFromArray(blob.data(), static_cast<int>(blob.size()));
+    }
+    
+    template <typename Message>
+    bool HSetProto(std::string_view key, std::string_view field, const Message& message) {
+        std::string blob;
+        return message.SerializeToString(&blob) && HSet(key, field, blob);
+    }
+    
+    template <typename Message>
+    bool HGetProto(std::string_view key, std::string_view field, Message* message) {
+        std::string blob;
+        return HGet(key, field, &blob) &&
+               message->ParseFromArray(blob.data(), static_cast<int>(blob.size()));
+    }
     
     redisContext* GetRawContext();
     
 private:
+    RedisReplyPtr CommandArgv(int argc, const char** argv, const size_t* argvlen);
+    
     redisContext* context_;
     bool connected_;
+    RedirectHandler redirect_handler_;
 };
 
 } // namespace ourchat
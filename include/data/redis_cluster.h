@@ -0,0 +1,94 @@
+#ifndef OURCHAT_REDIS_CLUSTER_H
+#define OURCHAT_REDIS_CLUSTER_H
+
+#include "connection_pool.h"
+#include "redis_client.h"
+#include "common/config.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ourchat {
+
+// Routes commands to the master that owns the key's hash slot.
+//
+// The slot map comes from CLUSTER SLOTS and is swapped as an immutable
+// snapshot, so routing a command is a CRC16 and an array lookup. Each master
+// has its own ConnectionPool. Connections carry a redirect handler: a MOVED
+// reply retries the command on the named node and refreshes the slot map,
+// an ASK reply retries it once behind ASKING without touching the map.
+class RedisCluster {
+public:
+    static constexpr int kSlotCount = 16384;
+
+    static std::shared_ptr<RedisCluster> Instance();
+
+    // CRC16 (XMODEM) of the key, or of its non-empty {hash tag}, mod 16384.
+    static int KeySlot(std::string_view key);
+
+    bool Init(const RedisConfig& config);
+    void Close();
+
+    // A connection to the master owning key's slot; an empty key picks any
+    // master (for commands such as PUBLISH that any node accepts).
+    ConnectionPool<RedisClient>::Lease GetConnection(std::string_view key);
+
+    // Sends each command (key at args[1]) to its slot owner. Commands for
+    // the same node are pipelined on one connection; replies come back in
+    // the order of commands, nullptr where a node could not be reached.
+    std::vector<RedisReplyPtr> Pipeline(const std::vector<std::vector<std::string>>& commands);
+
+    bool RefreshSlots();
+
+    // Health-checks every node pool; called by the RedisPool monitor.
+    void Maintain();
+
+    // New per-node pool size, for existing and future nodes.
+    void Resize(int pool_size);
+
+    int GetPoolSize();
+    int GetActiveConnections();
+    int GetIdleConnections();
+
+    ~RedisCluster();
+
+private:
+    RedisCluster() = default;
+
+    using NodePool = ConnectionPool<RedisClient>;
+
+    struct SlotMap {
+        std::vector<NodePool*> owners = std::vector<NodePool*>(kSlotCount, nullptr);
+    };
+
+    NodePool* Owner(std::string_view key);
+    NodePool* GetNodePool(const std::string& host, int port);
+    std::unique_ptr<RedisClient> CreateConnection(const std::string& host, int port);
+    RedisReplyPtr Redirect(std::string_view error, const std::vector<std::string_view>& args);
+    bool LoadSlots(RedisClient* client, const std::string& fallback_host);
+
+    static constexpr int kMaxRedirects = 5;
+    static constexpr std::chrono::milliseconds kMinRefreshInterval{500};
+
+    RedisConfig config_;
+    std::shared_ptr<const SlotMap> slots_;
+
+    // Pools are created on first sight of a node and live until Close, so
+    // SlotMap can hold raw pointers to them.
+    std::mutex nodes_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<NodePool>> nodes_;
+
+    std::mutex refresh_mutex_;
+    std::chrono::steady_clock::time_point last_refresh_;
+    std::atomic<size_t> next_node_{0};
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_REDIS_CLUSTER_H
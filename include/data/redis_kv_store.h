@@ -0,0 +1,44 @@
+#ifndef OURCHAT_REDIS_KV_STORE_H
+#define OURCHAT_REDIS_KV_STORE_H
+
+#include "kv_store.h"
+#include "redis_pool.h"
+#include "async_redis_client.h"
+#include "near_cache.h"
+#include <memory>
+
+namespace ourchat {
+
+// KVStore on RedisPool, one pooled connection per call. Publishes are
+// pipelined on AsyncRedisClient instead of holding a pooled connection.
+// Gets go through NearCache, which serves tracked keys locally while it is
+// running and is a plain GET otherwise; writes invalidate the local copy.
+class RedisKVStore : public KVStore {
+public:
+    RedisKVStore();
+
+    std::string Get(const std::string& key) override;
+    bool SetEx(const std::string& key, int seconds, const std::string& value) override;
+    bool SetNxEx(const std::string& key, int seconds, const std::string& value) override;
+    bool SetExMany(const std::vector<std::pair<std::string, std::string>>& entries,
+                   int seconds) override;
+    bool Del(const std::string& key) override;
+    bool Expire(const std::string& key, int seconds) override;
+
+    std::string HGet(const std::string& key, const std::string& field) override;
+    int64_t HIncrBy(const std::string& key, const std::string& field, int64_t increment) override;
+    std::map<std::string, std::string> HGetAll(const std::string& key) override;
+
+    void Publish(const std::string& channel, const std::string& message) override;
+
+private:
+    bool WriteMany(const std::vector<std::pair<std::string, std::string>>& entries, int seconds);
+
+    std::shared_ptr<RedisPool> redis_pool_;
+    std::shared_ptr<AsyncRedisClient> async_redis_;
+    std::shared_ptr<NearCache> near_cache_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_REDIS_KV_STORE_H
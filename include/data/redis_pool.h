@@ -1,23 +1,38 @@
 #ifndef OURCHAT_REDIS_POOL_H
 #define OURCHAT_REDIS_POOL_H
 
+#include "connection_pool.h"
 #include "redis_client.h"
+#include "redis_cluster.h"
 #include "common/config.h"
-#include <queue>
-#include <mutex>
-#include <condition_variable>
+#include <chrono>
 #include <memory>
 #include <atomic>
+#include <thread>
 
 namespace ourchat {
 
+using RedisLease = ConnectionPool<RedisClient>::Lease;
+
 class RedisPool {
 public:
     static std::shared_ptr<RedisPool> Instance();
     
     bool Init(const RedisConfig& config);
-    std::unique_ptr<RedisClient> GetConnection();
-    void ReturnConnection(std::unique_ptr<RedisClient> connection);
+    // The connection goes back to the pool when the lease is destroyed. In
+    // cluster mode it belongs to the node that owns key, so every command
+    // on it should use keys from the same slot (or a shared {hash tag});
+    // keyless commands may pass an empty key.
+    RedisLease GetConnection(std::string_view key = std::string_view());
+    
+    // Pipelines the commands (key at args[1]) and returns their replies in
+    // order; in cluster mode the batch is split per node.
+    std::vector<RedisReplyPtr> Pipeline(const std::vector<std::vector<std::string>>& commands);
+    
+    bool IsCluster() const { return cluster_ != nullptr; }
+    
+    // New target size; per master node in cluster mode.
+    void Resize(int pool_size);
     
     void Close();
     
@@ -26,19 +41,23 @@ public:
     int GetIdleConnections();
     
 public:
-    RedisPool() = default;
     ~RedisPool();
     
-    void CreateConnection();
+private:
+    RedisPool() = default;
+    
+    std::unique_ptr<RedisClient> CreateConnection();
+    void MonitorLoop();
     
-    std::queue<std::unique_ptr<RedisClient>> connections_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
+    // Idle connections older than this are pinged before being handed out.
+    static constexpr std::chrono::seconds kValidateAfterIdle{30};
+    
+    std::unique_ptr<ConnectionPool<RedisClient>> pool_;
+    std::shared_ptr<RedisCluster> cluster_;
     
     RedisConfig config_;
     std::atomic<bool> running_{false};
-    
-    int active_count_ = 0;
+    std::thread monitor_thread_;
 };
 
 } // namespace ourchat
@@ -0,0 +1,46 @@
+#ifndef OURCHAT_REDIS_SCRIPT_H
+#define OURCHAT_REDIS_SCRIPT_H
+
+#include <string>
+#include <vector>
+
+namespace ourchat {
+
+// A Lua script run with EVALSHA. The SHA1 is computed locally, so it is
+// known before the server has seen the script; every registered script is
+// sent with SCRIPT LOAD when a connection opens, and a NOSCRIPT reply (after
+// SCRIPT FLUSH or a failover) falls back to EVAL, which loads it again.
+class RedisScript {
+public:
+    RedisScript(const char* name, const char* source);
+
+    const std::string& Name() const { return name_; }
+    const std::string& Source() const { return source_; }
+    const std::string& Sha1() const { return sha1_; }
+
+    // Every script below, for loading on new connections.
+    static const std::vector<const RedisScript*>& All();
+
+    // Under cluster mode all KEYS of one call must share a hash slot.
+
+    // KEYS: any number of string keys
+    // ARGV: ttl_seconds, then one value per key
+    // Sets every key to its value with the shared TTL, all or nothing.
+    static const RedisScript& SetExMany();
+
+    // KEYS: rate:{<user_id>}
+    // ARGV: now_ms, window_ms, limit, member
+    // Sliding-window admission: drops entries older than the window, then
+    // records member if fewer than limit remain. Returns 0 if admitted,
+    // otherwise the milliseconds until the oldest entry leaves the window.
+    static const RedisScript& SlidingWindow();
+
+private:
+    std::string name_;
+    std::string source_;
+    std::string sha1_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_REDIS_SCRIPT_H
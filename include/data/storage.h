@@ -0,0 +1,39 @@
+#ifndef OURCHAT_STORAGE_H
+#define OURCHAT_STORAGE_H
+
+#include "kv_store.h"
+#include "message_store.h"
+#include "user_store.h"
+#include "../common/config.h"
+#include <memory>
+
+namespace ourchat {
+
+// The stores the services use, picked once at startup from
+// storage.backend: MySQL and Redis, or the in-memory stand-ins. With the
+// mysql backend, MySQLPool, RedisPool and AsyncRedisClient must be running
+// before Init.
+class Storage {
+public:
+    static std::shared_ptr<Storage> Instance();
+
+    bool Init(const StorageConfig& config, const MessageStoreConfig& message_store_config);
+
+    bool InMemory() const { return in_memory_; }
+
+    std::shared_ptr<UserStore> Users() const { return users_; }
+    std::shared_ptr<MessageStore> Messages() const { return messages_; }
+    std::shared_ptr<KVStore> KV() const { return kv_; }
+
+private:
+    Storage() = default;
+
+    bool in_memory_ = false;
+    std::shared_ptr<UserStore> users_;
+    std::shared_ptr<MessageStore> messages_;
+    std::shared_ptr<KVStore> kv_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_STORAGE_H
@@ -0,0 +1,36 @@
+#ifndef OURCHAT_USER_STORE_H
+#define OURCHAT_USER_STORE_H
+
+#include <cstdint>
+#include <string>
+
+namespace ourchat {
+
+struct UserRecord {
+    int64_t id = 0;
+    std::string username;
+    std::string password_hash;
+    std::string email;
+};
+
+// Account storage used by AuthServiceImpl. Obtained from Storage.
+class UserStore {
+public:
+    virtual ~UserStore() = default;
+
+    // Assigns id. False if the username is taken or the write failed.
+    virtual bool Create(UserRecord* record) = 0;
+
+    // False only when the store could not be read; a missing user returns
+    // true with *found false.
+    virtual bool FindByUsername(const std::string& username, UserRecord* out, bool* found) = 0;
+
+    // Replaces the hash only if it is still old_hash, so a concurrent
+    // password change is never overwritten.
+    virtual bool UpdatePasswordHash(int64_t user_id, const std::string& old_hash,
+                                    const std::string& new_hash) = 0;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_USER_STORE_H
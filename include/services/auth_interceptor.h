@@ -0,0 +1,79 @@
+#ifndef OURCHAT_AUTH_INTERCEPTOR_H
+#define OURCHAT_AUTH_INTERCEPTOR_H
+
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/server_interceptor.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "common/jwt_keyring.h"
+#include "services/call_context.h"
+#include "services/token_revocation_list.h"
+
+namespace ourchat {
+
+class AuthInterceptorFactory;
+
+// Authenticates every call except the public AuthService methods from the
+// "authorization: Bearer <token>" metadata. The caller's id replaces any
+// x-ourchat-user-id the client sent, and calls without a valid token fail
+// with UNAUTHENTICATED through CallContext before a handler does any work.
+class AuthInterceptor : public grpc::experimental::Interceptor {
+public:
+    AuthInterceptor(grpc::experimental::ServerRpcInfo* info, AuthInterceptorFactory* factory);
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override;
+
+private:
+    grpc::experimental::ServerRpcInfo* info_;
+    AuthInterceptorFactory* factory_;
+    bool rejected_ = false;
+    // Backs the injected metadata value for the life of the call.
+    std::string user_id_;
+};
+
+// Owns the cache of verified tokens shared by all calls. A hit skips
+// parsing and the HMAC; revocation is still checked on every call, and
+// entries expire with the token or after kCacheSeconds, whichever is first,
+// so a key dropped from the keyring stops working soon after a reload.
+class AuthInterceptorFactory : public grpc::experimental::ServerInterceptorFactoryInterface {
+public:
+    AuthInterceptorFactory();
+
+    grpc::experimental::Interceptor* CreateServerInterceptor(
+        grpc::experimental::ServerRpcInfo* info) override;
+
+    // The user the token belongs to, or 0 if it is invalid or revoked.
+    int64_t Authenticate(std::string_view token);
+
+    // Methods callable without a token (login and friends).
+    static bool IsPublic(std::string_view method);
+
+private:
+    struct CachedToken {
+        std::string token;
+        int64_t user_id;
+        int64_t version;
+        int64_t expires_at;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, CachedToken> tokens;
+    };
+
+    static constexpr size_t kShardCount = 16;
+    static constexpr size_t kShardCapacity = 4096;
+    static constexpr int64_t kCacheSeconds = 60;
+
+    std::shared_ptr<JWTKeyring> keyring_;
+    std::shared_ptr<TokenRevocationList> revocations_;
+    Shard shards_[kShardCount];
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_AUTH_INTERCEPTOR_H
@@ -4,15 +4,20 @@
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/impl/service_type.h>
 #include "user.grpc.pb.h"
-#include "data/mysql_pool.h"
-#include "data/redis_pool.h"
+#include "data/kv_store.h"
+#include "data/user_store.h"
 #include "common/config_manager.h"
+#include "common/bounded_worker_pool.h"
+#include "common/jwt_keyring.h"
+#include "services/token_revocation_list.h"
+#include <functional>
 
 namespace ourchat {
 
 class AuthServiceImpl : public im::AuthService, public grpc::Service {
 public:
     AuthServiceImpl();
+    ~AuthServiceImpl();
     
     grpc::Status Register(grpc::ServerContext* context,
                          const im::RegisterRequest* request,
@@ -35,9 +40,24 @@ public:
                                im::ValidateTokenResponse* response) override;
     
 private:
-    std::shared_ptr<MySQLPool> mysql_pool_;
-    std::shared_ptr<RedisPool> redis_pool_;
+    // Runs a hashing task on hash_pool_ and waits for it. Returns false
+    // without running it when the pool's queue is full.
+    bool RunOnHashPool(const std::function<void()>& task);
+    void UpdatePasswordHash(int64_t user_id, const std::string& old_hash,
+                            const std::string& new_hash);
+    // Writes token:<token> and user_token:<user_id> with the token TTL.
+    void StoreToken(int64_t user_id, const std::string& token);
+    
+    std::shared_ptr<UserStore> users_;
+    std::shared_ptr<KVStore> kv_;
+    std::shared_ptr<JWTKeyring> keyring_;
+    std::shared_ptr<TokenRevocationList> revocations_;
     JWTConfig jwt_config_;
+    PasswordHashConfig password_config_;
+    // A hash of a random password at bcrypt_cost. Logins for unknown users
+    // are checked against it, so they take as long as a wrong password.
+    std::string dummy_hash_;
+    std::unique_ptr<BoundedWorkerPool> hash_pool_;
 };
 
 } // namespace ourchat
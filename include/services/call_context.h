@@ -0,0 +1,44 @@
+#ifndef OURCHAT_CALL_CONTEXT_H
+#define OURCHAT_CALL_CONTEXT_H
+
+#include <grpcpp/grpcpp.h>
+#include <cstdint>
+
+namespace ourchat {
+
+// Metadata key carrying the caller's user id. AuthInterceptor replaces any
+// client-sent value with the id from the validated token.
+constexpr char kUserIdMetadataKey[] = "x-ourchat-user-id";
+
+// Per-call state shared by the server interceptors and the handlers.
+//
+// gRPC interceptors cannot stop a synchronous handler from running, so an
+// interceptor that fails a call records it here (and rewrites the status on
+// the way out); every handler starts with Admit() or Authorize() and
+// returns before doing any work.
+class CallContext {
+public:
+    // The authenticated caller, or 0.
+    static int64_t UserId(const grpc::ServerContext* context);
+
+    // Status of a call rejected by an interceptor, otherwise OK. For
+    // handlers that do not act on behalf of a user.
+    static grpc::Status Admit(const grpc::ServerContext* context);
+
+    // Admit(), then PERMISSION_DENIED unless claimed_user_id (taken from the
+    // request) is the authenticated caller. An unset (0) id is denied too,
+    // so handlers never act on user 0.
+    static grpc::Status Authorize(const grpc::ServerContext* context, int64_t claimed_user_id);
+
+    // For interceptors. Begin clears whatever an earlier call on this thread
+    // left behind and is called by the first interceptor in the chain; the
+    // first rejection of a call wins.
+    static void Begin(const grpc::ServerContextBase* context);
+    static void Reject(const grpc::ServerContextBase* context, const grpc::Status& status);
+    static bool Rejected(const grpc::ServerContextBase* context, grpc::Status* status = nullptr);
+    static void Finish(const grpc::ServerContextBase* context);
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_CALL_CONTEXT_H
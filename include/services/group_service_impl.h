@@ -4,11 +4,15 @@
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/impl/service_type.h>
 #include "group.grpc.pb.h"
+#include "data/message_store.h"
+#include "services/send_deduplicator.h"
 
 namespace ourchat {
 
 class GroupServiceImpl : public im::GroupService, public grpc::Service {
 public:
+    GroupServiceImpl();
+    
     grpc::Status CreateGroup(grpc::ServerContext* context,
                               const im::CreateGroupRequest* request,
                               im::CreateGroupResponse* response) override;
@@ -16,6 +20,14 @@ public:
     grpc::Status GetGroupInfo(grpc::ServerContext* context,
                                const im::GetGroupInfoRequest* request,
                                im::GetGroupInfoResponse* response) override;
+    
+    grpc::Status SendGroupMessage(grpc::ServerContext* context,
+                                  const im::SendGroupMessageRequest* request,
+                                  im::SendGroupMessageResponse* response) override;
+    
+private:
+    std::shared_ptr<MessageStore> message_store_;
+    std::shared_ptr<SendDeduplicator> deduplicator_;
 };
 
 }
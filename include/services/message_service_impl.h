@@ -4,11 +4,17 @@
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/impl/service_type.h>
 #include "message.grpc.pb.h"
+#include "data/message_store.h"
+#include "services/message_tail_cache.h"
+#include "services/read_receipt_aggregator.h"
+#include "services/send_deduplicator.h"
 
 namespace ourchat {
 
 class MessageServiceImpl : public im::MessageService, public grpc::Service {
 public:
+    MessageServiceImpl();
+    
     grpc::Status SendMessage(grpc::ServerContext* context,
                              const im::SendMessageRequest* request,
                              im::SendMessageResponse* response) override;
@@ -16,6 +22,26 @@ public:
     grpc::Status GetMessages(grpc::ServerContext* context,
                              const im::GetMessagesRequest* request,
                              im::GetMessagesResponse* response) override;
+    
+    grpc::Status MarkMessageRead(grpc::ServerContext* context,
+                                 const im::MarkMessageReadRequest* request,
+                                 im::MarkMessageReadResponse* response) override;
+    
+    // Both directions of a single chat map to the same id. When both user
+    // ids are below 2^31 the smaller one goes in the high 32 bits and the
+    // larger one in the low 32 bits; other pairs map to a 64-bit hash of
+    // both ids with bit 63 set. Stores treat the id as unsigned.
+    static int64_t ConversationId(int64_t user_a, int64_t user_b);
+    
+private:
+    static void ToMessage(const MessageRecord& record, im::Message* message);
+    
+    std::shared_ptr<MessageStore> message_store_;
+    std::shared_ptr<ReadReceiptAggregator> read_receipts_;
+    std::shared_ptr<SendDeduplicator> deduplicator_;
+    // message_store.tail_cache; single-instance deployments only.
+    bool tail_cache_enabled_ = false;
+    MessageTailCache tail_cache_;
 };
 
 }
@@ -0,0 +1,64 @@
+#ifndef OURCHAT_MESSAGE_TAIL_CACHE_H
+#define OURCHAT_MESSAGE_TAIL_CACHE_H
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "message.pb.h"
+
+namespace ourchat {
+
+// Keeps the newest messages of recently active conversations in memory so
+// that the first pages of a chat are served without touching MySQL. Each
+// cached tail is a contiguous suffix of the conversation ordered by id.
+// Only sends made through this process reach Append, so the cache is only
+// coherent when one instance serves all messages (message_store.tail_cache).
+class MessageTailCache {
+public:
+    explicit MessageTailCache(size_t tail_size = 50, size_t max_conversations = 100000);
+
+    // Fills `out` newest first with up to `limit` messages whose id is below
+    // `before_id` (0 means from the newest). Returns false when the cached
+    // tail cannot answer the page and the caller has to go to the database.
+    bool GetPage(int64_t conversation_id, int64_t before_id, int limit,
+                 std::vector<im::Message>* out);
+
+    void Append(const im::Message& message);
+
+    // Merges the newest page read from the database. `complete` means the
+    // page holds the whole conversation.
+    void Fill(int64_t conversation_id, const std::vector<im::Message>& newest_first,
+              bool complete);
+
+    void Erase(int64_t conversation_id);
+
+private:
+    struct Tail {
+        std::deque<im::Message> messages;
+        bool complete = false;
+        std::list<int64_t>::iterator lru_pos;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<int64_t, Tail> tails;
+        std::list<int64_t> lru;
+    };
+
+    static constexpr size_t kShardCount = 16;
+
+    Shard& GetShard(int64_t conversation_id);
+    Tail& Touch(Shard& shard, int64_t conversation_id);
+    void Insert(Tail& tail, const im::Message& message);
+
+    size_t tail_size_;
+    size_t max_per_shard_;
+    Shard shards_[kShardCount];
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_MESSAGE_TAIL_CACHE_H
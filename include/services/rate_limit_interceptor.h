@@ -0,0 +1,35 @@
+#ifndef OURCHAT_RATE_LIMIT_INTERCEPTOR_H
+#define OURCHAT_RATE_LIMIT_INTERCEPTOR_H
+
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/server_interceptor.h>
+#include <memory>
+#include "services/call_context.h"
+#include "services/rate_limiter.h"
+
+namespace ourchat {
+
+// Applies RateLimiter to every call once its initial metadata arrives; a
+// call over the limit fails with RESOURCE_EXHAUSTED through CallContext.
+// Registered after AuthInterceptor, so the user id it sees is validated.
+class RateLimitInterceptor : public grpc::experimental::Interceptor {
+public:
+    explicit RateLimitInterceptor(grpc::experimental::ServerRpcInfo* info);
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override;
+
+private:
+    grpc::experimental::ServerRpcInfo* info_;
+    std::shared_ptr<RateLimiter> limiter_;
+    bool rejected_ = false;
+};
+
+class RateLimitInterceptorFactory : public grpc::experimental::ServerInterceptorFactoryInterface {
+public:
+    grpc::experimental::Interceptor* CreateServerInterceptor(
+        grpc::experimental::ServerRpcInfo* info) override;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_RATE_LIMIT_INTERCEPTOR_H
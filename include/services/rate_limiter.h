@@ -0,0 +1,80 @@
+#ifndef OURCHAT_RATE_LIMITER_H
+#define OURCHAT_RATE_LIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "common/config.h"
+
+namespace ourchat {
+
+// Admission control by token buckets per client IP, per user and per
+// (method, IP) for the methods listed in the config.
+//
+// Buckets live in fixed-size tables of packed atomic words indexed by key
+// hash; taking a token is one CAS and nothing is ever allocated or evicted,
+// since an untouched bucket simply refills. Distinct keys may share a bucket,
+// which can only make their limit stricter. With distributed mode on, calls
+// that pass locally also go through a per-user sliding window in Redis, so
+// a user spreading load over nodes still hits the global limit. The window
+// is checked off the call path on AsyncRedisClient: a call is admitted
+// while its check is in flight, and a user found over the limit is turned
+// away locally until the window has room again. Calls already in flight can
+// overshoot the limit by one round trip's worth. Under Redis Cluster the
+// async client cannot route by key, so the check blocks on the pool.
+//
+// Rules can be replaced at runtime; each call reads one immutable copy.
+// Whether limiting is enabled and the table size are fixed at Init.
+class RateLimiter {
+public:
+    static std::shared_ptr<RateLimiter> Instance();
+
+    void Init(const RateLimitConfig& config);
+    void UpdateRules(const RateLimitConfig& config);
+    bool Enabled() const { return config_.enabled; }
+
+    // peer is the gRPC peer string ("ipv4:10.0.0.1:5412"); user_id is 0 for
+    // unauthenticated calls. Fails open if Redis is unreachable.
+    bool Admit(std::string_view method, std::string_view peer, int64_t user_id);
+
+    uint64_t Rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    RateLimiter() = default;
+
+    class BucketTable {
+    public:
+        void Init(size_t size);
+        bool Take(uint64_t key_hash, const RateLimitRule& rule, uint64_t now_ms);
+        // The raw word for key_hash, for tables that hold other stamps.
+        std::atomic<uint64_t>& At(uint64_t key_hash) { return buckets_[key_hash & mask_]; }
+
+    private:
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+        size_t mask_ = 0;
+    };
+
+    bool AdmitGlobal(int64_t user_id, const RateLimitConfig& rules, uint64_t now_ms);
+    uint64_t NowMs() const;
+
+    RateLimitConfig config_{};
+    std::shared_ptr<const RateLimitConfig> rules_;
+    std::chrono::steady_clock::time_point start_;
+
+    BucketTable ip_buckets_;
+    BucketTable user_buckets_;
+    BucketTable method_buckets_;
+    // Per user, the NowMs() until which the global window is full.
+    BucketTable global_blocks_;
+
+    uint64_t window_seed_ = 0;
+    std::atomic<uint64_t> window_sequence_{0};
+    std::atomic<uint64_t> rejected_{0};
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_RATE_LIMITER_H
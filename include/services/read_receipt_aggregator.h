@@ -0,0 +1,69 @@
+#ifndef OURCHAT_READ_RECEIPT_AGGREGATOR_H
+#define OURCHAT_READ_RECEIPT_AGGREGATOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "data/message_store.h"
+
+namespace ourchat {
+
+// Coalesces MarkMessageRead calls. Only the highest last_read_message_id per
+// (user_id, peer_id) is kept in memory; every flush interval the pending
+// receipts are saved through the MessageStore (multi-row upserts into
+// im_message_read) and a read event is published to each peer on
+// "read_receipt:<peer_id>".
+class ReadReceiptAggregator {
+public:
+    static std::shared_ptr<ReadReceiptAggregator> Instance();
+
+    void Start(int flush_interval_ms = 200);
+    // Stops the flush thread after writing out everything still pending.
+    void Stop();
+
+    void Record(int64_t user_id, int64_t peer_id, int64_t last_read_message_id);
+    void Flush();
+
+    ~ReadReceiptAggregator();
+
+private:
+    ReadReceiptAggregator() = default;
+
+    using Receipt = ReadReceiptRecord;
+
+    struct PairHash {
+        size_t operator()(const std::pair<int64_t, int64_t>& key) const {
+            return std::hash<int64_t>()(key.first * 0x9E3779B97F4A7C15LL ^ key.second);
+        }
+    };
+
+    using PendingMap = std::unordered_map<std::pair<int64_t, int64_t>, Receipt, PairHash>;
+
+    struct Shard {
+        std::mutex mutex;
+        PendingMap pending;
+    };
+
+    static constexpr size_t kShardCount = 16;
+
+    Shard& GetShard(int64_t user_id);
+    void Merge(const Receipt& receipt);
+    void Publish(const std::vector<Receipt>& receipts);
+
+    Shard shards_[kShardCount];
+    std::mutex flush_mutex_;
+
+    std::atomic<bool> running_{false};
+    std::thread flush_thread_;
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_READ_RECEIPT_AGGREGATOR_H
@@ -0,0 +1,102 @@
+#ifndef OURCHAT_SEND_DEDUPLICATOR_H
+#define OURCHAT_SEND_DEDUPLICATOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "common/config.h"
+
+namespace ourchat {
+
+// Remembers (sender_id, client_message_id) -> server_message_id for a short
+// window so client retries get the original result instead of a new row.
+// The KVStore (SET NX EX in Redis) is the shared claim across nodes; a
+// bounded exact cache answers repeats on the same node without a round
+// trip. A client_message_id of 0 disables deduplication for that send.
+//
+// A claim lives for claim_seconds only and Complete() extends it to the
+// full window, so a node that dies mid-send blocks retries briefly rather
+// than for the whole window.
+class SendDeduplicator {
+public:
+    enum class Claim {
+        kNew,        // caller owns the send and must Complete() or Abort()
+        kDuplicate,  // already stored, original filled in
+        kInFlight    // another attempt is still storing it
+    };
+
+    enum class Scope : char {
+        kSingle = 's',
+        kGroup = 'g'
+    };
+
+    struct Result {
+        int64_t server_message_id = 0;
+        int64_t timestamp = 0;
+    };
+
+    static std::shared_ptr<SendDeduplicator> Instance();
+
+    void Init(const SendDedupConfig& config);
+
+    Claim Begin(Scope scope, int64_t sender_id, int64_t client_message_id, Result* original);
+    void Complete(Scope scope, int64_t sender_id, int64_t client_message_id, const Result& result);
+    void Abort(Scope scope, int64_t sender_id, int64_t client_message_id);
+
+private:
+    SendDeduplicator();
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Key {
+        Scope scope;
+        int64_t sender_id;
+        int64_t client_message_id;
+
+        bool operator==(const Key& other) const {
+            return scope == other.scope && sender_id == other.sender_id &&
+                   client_message_id == other.client_message_id;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            uint64_t h = static_cast<uint64_t>(key.sender_id) * 0x9E3779B97F4A7C15ULL;
+            h ^= static_cast<uint64_t>(key.client_message_id) + (h << 6) + (h >> 2);
+            return static_cast<size_t>(h ^ static_cast<uint64_t>(key.scope));
+        }
+    };
+
+    // server_message_id == 0 marks a send that is still in flight.
+    struct Entry {
+        Result result;
+        Clock::time_point expires_at;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<Key, Entry, KeyHash> entries;
+        std::deque<std::pair<Key, Clock::time_point>> order;
+    };
+
+    static constexpr size_t kShardCount = 16;
+
+    Shard& GetShard(const Key& key);
+    void Store(const Key& key, const Result& result, int seconds);
+    void StoreLocked(Shard& shard, const Key& key, const Result& result, int seconds);
+    void Erase(const Key& key);
+    static std::string RedisKey(const Key& key);
+
+    Shard shards_[kShardCount];
+    int window_seconds_;
+    int claim_seconds_;
+    size_t shard_capacity_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_SEND_DEDUPLICATOR_H
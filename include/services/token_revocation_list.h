@@ -0,0 +1,82 @@
+#ifndef OURCHAT_TOKEN_REVOCATION_LIST_H
+#define OURCHAT_TOKEN_REVOCATION_LIST_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "common/config.h"
+
+namespace ourchat {
+
+// Per-user token versions. Tokens carry the version that was current when
+// they were issued ("ver") and are rejected once the user's version has
+// moved past it, so checking a token is a local map lookup.
+//
+// A revocation sets the version to at least the current time in
+// milliseconds. Once no token issued before it can still be valid (the
+// longer of the access and refresh lifetimes), the entry is dropped: a user
+// without one gets version 0 again, and their next revocation still lands
+// above every outstanding token because the clock has moved on.
+//
+// Revoke writes the version into the Redis hash token_versions:<day> for
+// the current UTC day, which expires a day after the retention period, and
+// publishes "<user_id>:<version>" on token_revocations. Every node
+// subscribes and applies updates to its map; after each (re)subscribe the
+// buckets still in retention are reloaded so updates missed while
+// disconnected are not lost.
+class TokenRevocationList {
+public:
+    static std::shared_ptr<TokenRevocationList> Instance();
+
+    void Start(const RedisConfig& config);
+    void Stop();
+
+    bool IsRevoked(int64_t user_id, int64_t token_version);
+    // Version to embed in a new token; asks Redis so a revocation that has
+    // not reached this node yet is still honoured.
+    int64_t VersionForNewToken(int64_t user_id);
+    // Invalidates every token issued to the user so far. Returns false if
+    // Redis could not be updated (the local node still applies it).
+    bool Revoke(int64_t user_id);
+
+    ~TokenRevocationList();
+
+private:
+    TokenRevocationList();
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<int64_t, int64_t> versions;
+        size_t writes = 0;
+    };
+
+    static constexpr size_t kShardCount = 16;
+    static constexpr size_t kPruneInterval = 1024;
+
+    Shard& GetShard(int64_t user_id);
+    int64_t LocalVersion(int64_t user_id);
+    void Apply(int64_t user_id, int64_t version);
+    // Drops versions older than the retention period. Caller holds the lock.
+    void PruneLocked(Shard& shard);
+    void Resync();
+    void Run();
+    void Backoff(int* delay_ms);
+
+    Shard shards_[kShardCount];
+    // Longest token lifetime; versions older than this protect nothing.
+    int retention_seconds_;
+
+    RedisConfig config_;
+    std::atomic<bool> running_{false};
+    std::thread subscriber_thread_;
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_TOKEN_REVOCATION_LIST_H
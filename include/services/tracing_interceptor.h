@@ -0,0 +1,35 @@
+#ifndef OURCHAT_TRACING_INTERCEPTOR_H
+#define OURCHAT_TRACING_INTERCEPTOR_H
+
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/server_interceptor.h>
+#include <memory>
+#include "common/tracing.h"
+
+namespace ourchat {
+
+// Opens the root span of every call from its "traceparent" metadata and
+// ends it with the call's status. Registered first, so authentication and
+// rate limiting are inside the span. The handler runs on the thread that
+// received the metadata, so the spans it opens nest under this one.
+class TracingInterceptor : public grpc::experimental::Interceptor {
+public:
+    explicit TracingInterceptor(grpc::experimental::ServerRpcInfo* info);
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override;
+
+private:
+    grpc::experimental::ServerRpcInfo* info_;
+    // Null when the call is not sampled.
+    std::unique_ptr<Span> span_;
+};
+
+class TracingInterceptorFactory : public grpc::experimental::ServerInterceptorFactoryInterface {
+public:
+    grpc::experimental::Interceptor* CreateServerInterceptor(
+        grpc::experimental::ServerRpcInfo* info) override;
+};
+
+} // namespace ourchat
+
+#endif // OURCHAT_TRACING_INTERCEPTOR_H
@@ -89,7 +89,7 @@ CREATE TABLE IF NOT EXISTS im_single_message (
     content TEXT COMMENT '消息内容',
     status TINYINT DEFAULT 1 COMMENT '状态: 1-发送中, 2-已送达, 3-已读',
     create_time BIGINT UNSIGNED NOT NULL COMMENT '创建时间',
-    INDEX idx_conversation(conversation_id, create_time),
+    INDEX idx_conversation(conversation_id, id, create_time),
     INDEX idx_sender(sender_id),
     INDEX idx_receiver(receiver_id)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci COMMENT='单聊消息表';
@@ -133,7 +133,7 @@ CREATE TABLE IF NOT EXISTS im_device (
 
 -- Insert default admin user (password: admin123)
 INSERT INTO im_user (username, password_hash, phone, email, nickname, create_time, update_time) 
-VALUES ('admin', '$2b$12$LQv3c1yqBWVHxkd0LHAkCOYz6TtxMQJqhN8/X4.DvLDaLdG1pAuFy', 
+VALUES ('admin', '$2b$12$3EmVlGmnuPR4anCb0Pf6g.7/Qy6nDUh9TxgSeqTOJBEmR5b./rGYG', 
         '13800138000', 'admin@ourchat.com', '管理员', UNIX_TIMESTAMP(), UNIX_TIMESTAMP());
 
 -- Create indexes for better performance
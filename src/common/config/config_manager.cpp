@@ -1,75 +1,269 @@
 #include "../../../include/common/config_manager.h"
+#include "../../../include/common/logger.h"
 #include <yaml-cpp/yaml.h>
-#include <yaml-cpp/yaml.h>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
 
 namespace ourchat {
 
+namespace {
+
+void ParseJWTConfig(const YAML::Node& node, JWTConfig* jwt) {
+    jwt->secret = node["secret"].as<std::string>("");
+    jwt->expire_seconds = node["expire_seconds"].as<int>(86400);
+    jwt->refresh_expire_seconds = node["refresh_expire_seconds"].as<int>(604800);
+    jwt->keys.clear();
+    for (const auto& key : node["keys"]) {
+        JWTKeyConfig key_config;
+        key_config.kid = key["kid"].as<std::string>();
+        key_config.secret = key["secret"].as<std::string>();
+        jwt->keys.push_back(key_config);
+    }
+    jwt->active_kid = node["active_kid"].as<std::string>("");
+}
+
+// Editors and ConfigMap updates touch the directory several times per
+// change; events closer together than this are handled as one.
+constexpr int kSettleMs = 200;
+
+RateLimitRule ParseRateLimitRule(const YAML::Node& node, double rate, int burst) {
+    RateLimitRule rule{rate, burst};
+    if (!node || !node.IsMap()) return rule;
+
+    rule.rate = node["rate"].as<double>(rate);
+    rule.burst = node["burst"].as<int>(burst);
+    return rule;
+}
+
+} // namespace
+
 ConfigManager& ConfigManager::Instance() {
     static ConfigManager instance;
     return instance;
 }
 
+ConfigManager::~ConfigManager() {
+    StopWatching();
+}
+
 bool ConfigManager::LoadConfig(const std::string& config_path) {
+    std::string content;
+    if (!ReadFile(config_path, &content)) {
+        std::cerr << "Failed to read config file: " << config_path << std::endl;
+        return false;
+    }
+    
+    auto config = std::make_shared<Config>();
+    if (!Parse(content, config.get())) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    config_path_ = config_path;
+    loaded_content_ = std::move(content);
+    std::atomic_store(&config_, std::shared_ptr<const Config>(std::move(config)));
+    return true;
+}
+
+bool ConfigManager::ReadFile(const std::string& path, std::string* content) {
+    std::ifstream file(path);
+    if (!file) return false;
+    
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    *content = buffer.str();
+    return true;
+}
+
+bool ConfigManager::Parse(const std::string& content, Config* out) {
     try {
-        YAML::Node config = YAML::LoadFile(config_path);
+        YAML::Node config = YAML::Load(content);
         
         if (!config["mysql"]) {
             std::cerr << "MySQL config not found" << std::endl;
             return false;
         }
         
-        mysql_.host = config["mysql"]["host"].as<std::string>();
-        mysql_.port = config["mysql"]["port"].as<int>();
-        mysql_.username = config["mysql"]["username"].as<std::string>();
-        mysql_.password = config["mysql"]["password"].as<std::string>();
-        mysql_.database = config["mysql"]["database"].as<std::string>();
-        mysql_.pool_size = config["mysql"]["pool_size"].as<int>(10);
-        mysql_.max_pool_size = config["mysql"]["max_pool_size"].as<int>(20);
-        mysql_.connection_timeout = config["mysql"]["connection_timeout"].as<int>(10);
-        mysql_.idle_timeout = config["mysql"]["idle_timeout"].as<int>(300);
+        out->mysql.host = config["mysql"]["host"].as<std::string>();
+        out->mysql.port = config["mysql"]["port"].as<int>();
+        out->mysql.username = config["mysql"]["username"].as<std::string>();
+        out->mysql.password = config["mysql"]["password"].as<std::string>();
+        out->mysql.database = config["mysql"]["database"].as<std::string>();
+        out->mysql.pool_size = config["mysql"]["pool_size"].as<int>(10);
+        out->mysql.max_pool_size = config["mysql"]["max_pool_size"].as<int>(20);
+        out->mysql.connection_timeout = config["mysql"]["connection_timeout"].as<int>(10);
+        out->mysql.idle_timeout = config["mysql"]["idle_timeout"].as<int>(300);
+        out->mysql.replicas.clear();
+        for (const auto& replica : config["mysql"]["replicas"]) {
+            DatabaseEndpoint endpoint;
+            endpoint.host = replica["host"].as<std::string>();
+            endpoint.port = replica["port"].as<int>(out->mysql.port);
+            out->mysql.replicas.push_back(endpoint);
+        }
+        out->mysql.replica_pool_size = config["mysql"]["replica_pool_size"].as<int>(out->mysql.pool_size);
+        out->mysql.replica_max_lag = config["mysql"]["replica_max_lag"].as<int>(5);
+        out->mysql.read_your_writes_window = config["mysql"]["read_your_writes_window"].as<int>(10);
         
         if (!config["redis"]) {
             std::cerr << "Redis config not found" << std::endl;
             return false;
         }
         
-        redis_.host = config["redis"]["host"].as<std::string>();
-        redis_.port = config["redis"]["port"].as<int>();
-        redis_.password = config["redis"]["password"].as<std::string>("");
-        redis_.db = config["redis"]["db"].as<int>(0);
-        redis_.pool_size = config["redis"]["pool_size"].as<int>(10);
-        redis_.command_timeout = config["redis"]["command_timeout"].as<int>(5);
+        out->redis.host = config["redis"]["host"].as<std::string>();
+        out->redis.port = config["redis"]["port"].as<int>();
+        out->redis.password = config["redis"]["password"].as<std::string>("");
+        out->redis.db = config["redis"]["db"].as<int>(0);
+        out->redis.pool_size = config["redis"]["pool_size"].as<int>(10);
+        out->redis.command_timeout = config["redis"]["command_timeout"].as<int>(5);
+        out->redis.async_connections = config["redis"]["async_connections"].as<int>(2);
+        out->redis.async_max_pending = config["redis"]["async_max_pending"].as<int>(10000);
+        out->redis.cluster = config["redis"]["cluster"].as<bool>(false);
+        out->redis.cluster_nodes.clear();
+        for (const auto& node : config["redis"]["cluster_nodes"]) {
+            RedisNode seed;
+            seed.host = node["host"].as<std::string>();
+            seed.port = node["port"].as<int>(out->redis.port);
+            out->redis.cluster_nodes.push_back(seed);
+        }
         
         if (config["kafka"]) {
             auto brokers_node = config["kafka"]["brokers"];
             for (const auto& broker : brokers_node) {
-                kafka_.brokers.push_back(broker.as<std::string>());
+                out->kafka.brokers.push_back(broker.as<std::string>());
             }
-            kafka_.port = config["kafka"]["port"].as<int>(9092);
-            kafka_.client_id = config["kafka"]["client_id"].as<std::string>("im_server");
-            kafka_.batch_size = config["kafka"]["batch_size"].as<int>(16384);
-            kafka_.linger_ms = config["kafka"]["linger_ms"].as<int>(5);
-            kafka_.compression = config["kafka"]["compression"].as<int>(1);
-            kafka_.acks = config["kafka"]["acks"].as<int>(-1);
-            kafka_.retries = config["kafka"]["retries"].as<int>(3);
+            out->kafka.port = config["kafka"]["port"].as<int>(9092);
+            out->kafka.client_id = config["kafka"]["client_id"].as<std::string>("im_server");
+            out->kafka.batch_size = config["kafka"]["batch_size"].as<int>(16384);
+            out->kafka.linger_ms = config["kafka"]["linger_ms"].as<int>(5);
+            out->kafka.compression = config["kafka"]["compression"].as<int>(1);
+            out->kafka.acks = config["kafka"]["acks"].as<int>(-1);
+            out->kafka.retries = config["kafka"]["retries"].as<int>(3);
         }
         
         if (config["server"]) {
-            server_.service_name = config["server"]["service_name"].as<std::string>("ourchat_server");
-            server_.host = config["server"]["host"].as<std::string>("0.0.0.0");
-            server_.port = config["server"]["port"].as<int>(50051);
-            server_.worker_threads = config["server"]["worker_threads"].as<int>(4);
-            server_.max_connection = config["server"]["max_connection"].as<int>(10000);
-            server_.keepalive_time = config["server"]["keepalive_time"].as<int>(30);
-            server_.keepalive_timeout = config["server"]["keepalive_timeout"].as<int>(10);
+            out->server.service_name = config["server"]["service_name"].as<std::string>("ourchat_server");
+            out->server.host = config["server"]["host"].as<std::string>("0.0.0.0");
+            out->server.port = config["server"]["port"].as<int>(50051);
+            out->server.worker_threads = config["server"]["worker_threads"].as<int>(4);
+            out->server.max_threads = config["server"]["max_threads"].as<int>(0);
+            out->server.memory_quota_mb = config["server"]["memory_quota_mb"].as<int>(0);
+            out->server.max_connection = config["server"]["max_connection"].as<int>(10000);
+            out->server.max_concurrent_streams = config["server"]["max_concurrent_streams"].as<int>(100);
+            out->server.keepalive_time = config["server"]["keepalive_time"].as<int>(30);
+            out->server.keepalive_timeout = config["server"]["keepalive_timeout"].as<int>(10);
+            out->server.node_id = config["server"]["node_id"].as<int>(0);
+            out->server.lame_duck_ms = config["server"]["lame_duck_ms"].as<int>(0);
+            out->server.shutdown_grace_ms = config["server"]["shutdown_grace_ms"].as<int>(10000);
         }
         
         if (config["jwt"]) {
-            jwt_.secret = config["jwt"]["secret"].as<std::string>();
-            jwt_.expire_seconds = config["jwt"]["expire_seconds"].as<int>(86400);
-            jwt_.refresh_expire_seconds = config["jwt"]["refresh_expire_seconds"].as<int>(604800);
+            ParseJWTConfig(config["jwt"], &out->jwt);
+        }
+        
+        out->password_hash.bcrypt_cost = 12;
+        out->password_hash.worker_threads = 2;
+        out->password_hash.max_queue = 64;
+        out->password_hash.pin_threads = true;
+        if (config["password_hash"]) {
+            out->password_hash.bcrypt_cost = config["password_hash"]["bcrypt_cost"].as<int>(12);
+            out->password_hash.worker_threads = config["password_hash"]["worker_threads"].as<int>(2);
+            out->password_hash.max_queue = config["password_hash"]["max_queue"].as<int>(64);
+            out->password_hash.pin_threads = config["password_hash"]["pin_threads"].as<bool>(true);
+        }
+        
+        out->message_store.partitioned = false;
+        out->message_store.shard_count = 1;
+        out->message_store.tail_cache = false;
+        if (config["message_store"]) {
+            out->message_store.partitioned = config["message_store"]["partitioned"].as<bool>(false);
+            out->message_store.shard_count = config["message_store"]["shard_count"].as<int>(16);
+            out->message_store.tail_cache = config["message_store"]["tail_cache"].as<bool>(false);
+        }
+        
+        out->storage.backend = "mysql";
+        out->storage.latency_us = 0;
+        out->storage.latency_jitter_us = 0;
+        if (config["storage"]) {
+            out->storage.backend = config["storage"]["backend"].as<std::string>("mysql");
+            out->storage.latency_us = config["storage"]["latency_us"].as<int>(0);
+            out->storage.latency_jitter_us = config["storage"]["latency_jitter_us"].as<int>(0);
+        }
+        
+        out->send_dedup.window_seconds = 300;
+        out->send_dedup.claim_seconds = 15;
+        out->send_dedup.local_capacity = 100000;
+        if (config["send_dedup"]) {
+            out->send_dedup.window_seconds = config["send_dedup"]["window_seconds"].as<int>(300);
+            out->send_dedup.claim_seconds = config["send_dedup"]["claim_seconds"].as<int>(15);
+            out->send_dedup.local_capacity = config["send_dedup"]["local_capacity"].as<int>(100000);
+        }
+        
+        out->near_cache.enabled = false;
+        out->near_cache.prefixes.clear();
+        out->near_cache.max_entries = 100000;
+        out->near_cache.max_memory_mb = 64;
+        out->near_cache.ttl_ms = 30000;
+        if (config["near_cache"]) {
+            out->near_cache.enabled = config["near_cache"]["enabled"].as<bool>(false);
+            for (const auto& prefix : config["near_cache"]["prefixes"]) {
+                out->near_cache.prefixes.push_back(prefix.as<std::string>());
+            }
+            out->near_cache.max_entries = config["near_cache"]["max_entries"].as<int>(100000);
+            out->near_cache.max_memory_mb = config["near_cache"]["max_memory_mb"].as<int>(64);
+            out->near_cache.ttl_ms = config["near_cache"]["ttl_ms"].as<int>(30000);
+        }
+        
+        out->rate_limit.enabled = false;
+        out->rate_limit.table_size = 65536;
+        out->rate_limit.per_ip = RateLimitRule{200, 400};
+        out->rate_limit.per_user = RateLimitRule{50, 100};
+        out->rate_limit.methods.clear();
+        out->rate_limit.distributed = false;
+        out->rate_limit.window_ms = 1000;
+        out->rate_limit.window_limit = 100;
+        if (config["rate_limit"]) {
+            const YAML::Node& rate_limit = config["rate_limit"];
+            out->rate_limit.enabled = rate_limit["enabled"].as<bool>(false);
+            out->rate_limit.table_size = rate_limit["table_size"].as<int>(65536);
+            out->rate_limit.per_ip = ParseRateLimitRule(rate_limit["per_ip"], 200, 400);
+            out->rate_limit.per_user = ParseRateLimitRule(rate_limit["per_user"], 50, 100);
+            for (const auto& method : rate_limit["methods"]) {
+                out->rate_limit.methods[method.first.as<std::string>()] = ParseRateLimitRule(method.second, 1, 10);
+            }
+            out->rate_limit.distributed = rate_limit["distributed"].as<bool>(false);
+            out->rate_limit.window_ms = rate_limit["window_ms"].as<int>(1000);
+            out->rate_limit.window_limit = rate_limit["window_limit"].as<int>(100);
+        }
+        
+        out->tracing.enabled = false;
+        out->tracing.sample_ratio = 0.01;
+        out->tracing.export_path = "logs/traces.jsonl";
+        out->tracing.max_queued_spans = 65536;
+        out->tracing.flush_interval_ms = 1000;
+        if (config["tracing"]) {
+            out->tracing.enabled = config["tracing"]["enabled"].as<bool>(false);
+            out->tracing.sample_ratio = config["tracing"]["sample_ratio"].as<double>(0.01);
+            out->tracing.export_path = config["tracing"]["export_path"].as<std::string>("logs/traces.jsonl");
+            out->tracing.max_queued_spans = config["tracing"]["max_queued_spans"].as<int>(65536);
+            out->tracing.flush_interval_ms = config["tracing"]["flush_interval_ms"].as<int>(1000);
+        }
+        
+        out->logging.level = "INFO";
+        out->logging.console_output = true;
+        out->logging.file_output = false;
+        out->logging.log_file = "logs/ourchat.log";
+        if (config["logging"]) {
+            out->logging.level = config["logging"]["level"].as<std::string>("INFO");
+            out->logging.console_output = config["logging"]["console_output"].as<bool>(true);
+            out->logging.file_output = config["logging"]["file_output"].as<bool>(false);
+            out->logging.log_file = config["logging"]["log_file"].as<std::string>("logs/ourchat.log");
         }
         
         return true;
@@ -82,24 +276,168 @@ bool ConfigManager::LoadConfig(const std::string& config_path) {
     }
 }
 
-const DatabaseConfig& ConfigManager::GetDatabaseConfig() const {
-    return mysql_;
+bool ConfigManager::Reload() {
+    return ReloadFile(false);
+}
+
+bool ConfigManager::ReloadFile(bool only_if_changed) {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    
+    std::string content;
+    if (!ReadFile(config_path_, &content)) {
+        // Mid-rename the file can be briefly missing; the next event retries.
+        LOG_WARN("Config reload: cannot read " + config_path_);
+        return false;
+    }
+    if (only_if_changed && content == loaded_content_) {
+        return true;
+    }
+    
+    auto config = std::make_shared<Config>();
+    if (!Parse(content, config.get())) {
+        LOG_ERROR("Config reload: " + config_path_ + " is invalid, keeping the current config");
+        return false;
+    }
+    
+    std::shared_ptr<const Config> current(std::move(config));
+    std::shared_ptr<const Config> previous = std::atomic_exchange(&config_, current);
+    loaded_content_ = std::move(content);
+    LOG_INFO("Config reloaded from " + config_path_);
+    
+    for (const auto& listener : listeners_) {
+        listener(*previous, *current);
+    }
+    return true;
+}
+
+void ConfigManager::Subscribe(Listener listener) {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    listeners_.push_back(std::move(listener));
+}
+
+bool ConfigManager::StartWatching() {
+    if (watcher_.joinable()) return true;
+    
+    // Watch the directory, not the file: a rename or symlink swap replaces
+    // the inode a file watch would be attached to.
+    size_t slash = config_path_.rfind('/');
+    std::string directory = slash == std::string::npos ? "." :
+                            slash == 0 ? "/" : config_path_.substr(0, slash);
+    
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd_ < 0 || stop_fd_ < 0 ||
+        inotify_add_watch(inotify_fd_, directory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0) {
+        LOG_ERROR("Failed to watch " + directory + ": " + std::string(strerror(errno)));
+        if (inotify_fd_ >= 0) close(inotify_fd_);
+        if (stop_fd_ >= 0) close(stop_fd_);
+        inotify_fd_ = stop_fd_ = -1;
+        return false;
+    }
+    
+    watcher_ = std::thread(&ConfigManager::WatchLoop, this);
+    LOG_INFO("Watching " + config_path_ + " for changes");
+    return true;
+}
+
+void ConfigManager::StopWatching() {
+    if (!watcher_.joinable()) return;
+    
+    uint64_t one = 1;
+    ssize_t bytes = write(stop_fd_, &one, sizeof(one));
+    (void)bytes;
+    watcher_.join();
+    
+    close(inotify_fd_);
+    close(stop_fd_);
+    inotify_fd_ = stop_fd_ = -1;
+}
+
+void ConfigManager::WatchLoop() {
+    alignas(inotify_event) char buffer[4096];
+    auto drain = [this, &buffer]() {
+        while (read(inotify_fd_, buffer, sizeof(buffer)) > 0) {
+        }
+    };
+    
+    pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("Config watcher stopped: " + std::string(strerror(errno)));
+            return;
+        }
+        if (fds[1].revents & POLLIN) return;
+        
+        // Any change in the directory counts; the content comparison in
+        // ReloadFile skips the ones that did not touch the config.
+        do {
+            drain();
+        } while (poll(fds, 1, kSettleMs) > 0);
+        
+        ReloadFile(true);
+    }
+}
+
+std::shared_ptr<const Config> ConfigManager::Current() const {
+    return std::atomic_load(&config_);
+}
+
+const std::string& ConfigManager::GetConfigPath() const {
+    return config_path_;
+}
+
+DatabaseConfig ConfigManager::GetDatabaseConfig() const {
+    return Current()->mysql;
+}
+
+RedisConfig ConfigManager::GetRedisConfig() const {
+    return Current()->redis;
+}
+
+KafkaConfig ConfigManager::GetKafkaConfig() const {
+    return Current()->kafka;
+}
+
+ServerConfig ConfigManager::GetServerConfig() const {
+    return Current()->server;
+}
+
+JWTConfig ConfigManager::GetJWTConfig() const {
+    return Current()->jwt;
+}
+
+PasswordHashConfig ConfigManager::GetPasswordHashConfig() const {
+    return Current()->password_hash;
+}
+
+MessageStoreConfig ConfigManager::GetMessageStoreConfig() const {
+    return Current()->message_store;
+}
+
+StorageConfig ConfigManager::GetStorageConfig() const {
+    return Current()->storage;
+}
+
+SendDedupConfig ConfigManager::GetSendDedupConfig() const {
+    return Current()->send_dedup;
 }
 
-const RedisConfig& ConfigManager::GetRedisConfig() const {
-    return redis_;
+NearCacheConfig ConfigManager::GetNearCacheConfig() const {
+    return Current()->near_cache;
 }
 
-const KafkaConfig& ConfigManager::GetKafkaConfig() const {
-    return kafka_;
+RateLimitConfig ConfigManager::GetRateLimitConfig() const {
+    return Current()->rate_limit;
 }
 
-const ServerConfig& ConfigManager::GetServerConfig() const {
-    return server_;
+TracingConfig ConfigManager::GetTracingConfig() const {
+    return Current()->tracing;
 }
 
-const JWTConfig& ConfigManager::GetJWTConfig() const {
-    return jwt_;
+LoggingConfig ConfigManager::GetLoggingConfig() const {
+    return Current()->logging;
 }
 
 } // namespace ourchat
@@ -1,4 +1,5 @@
 #include "../../../include/common/logger.h"
+#include "../../../include/common/tracing.h"
 #include <chrono>
 #include <ctime>
 #include <iomanip>
@@ -44,6 +45,16 @@ void Logger::SetOutputFile(const std::string& filepath) {
     }
 }
 
+void Logger::CloseOutputFile() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (file_handle_) {
+        fclose(file_handle_);
+        file_handle_ = nullptr;
+    }
+    output_file_.clear();
+}
+
 void Logger::SetConsoleOutput(bool enable) {
     console_output_ = enable;
 }
@@ -77,6 +88,8 @@ void Logger::Log(LogLevel level, const std::string& message) {
 }
 
 void Logger::Write(LogLevel level, const std::string& message) {
+    // Includes the wait for the logger mutex.
+    Span span("log.write");
     std::lock_guard<std::mutex> lock(mutex_);
     
     std::string log_message = "[" + GetCurrentTime() + "] [" + 
@@ -0,0 +1,347 @@
+#include "../../../include/common/tracing.h"
+#include "../../../include/common/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+
+namespace ourchat {
+
+namespace {
+
+constexpr size_t kSpansPerLine = 512;
+
+uint64_t NextId() {
+    thread_local std::mt19937_64 rng{
+        std::random_device{}() ^ std::hash<std::thread::id>{}(std::this_thread::get_id())};
+    uint64_t id;
+    do {
+        id = rng();
+    } while (id == 0);
+    return id;
+}
+
+uint64_t UnixNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool ParseHex(std::string_view text, uint64_t* out) {
+    uint64_t value = 0;
+    for (char c : text) {
+        int digit = HexDigit(c);
+        if (digit < 0) return false;
+        value = (value << 4) | static_cast<uint64_t>(digit);
+    }
+    *out = value;
+    return true;
+}
+
+void AppendHex(std::string* out, uint64_t value) {
+    static const char kDigits[] = "0123456789abcdef";
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        out->push_back(kDigits[(value >> shift) & 0xf]);
+    }
+}
+
+void AppendJsonString(std::string* out, std::string_view value) {
+    static const char kDigits[] = "0123456789abcdef";
+    out->push_back('"');
+    for (char c : value) {
+        switch (c) {
+            case '"': *out += "\\\""; break;
+            case '\\': *out += "\\\\"; break;
+            case '\n': *out += "\\n"; break;
+            case '\r': *out += "\\r"; break;
+            case '\t': *out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    *out += "\\u00";
+                    out->push_back(kDigits[(c >> 4) & 0xf]);
+                    out->push_back(kDigits[c & 0xf]);
+                } else {
+                    out->push_back(c);
+                }
+        }
+    }
+    out->push_back('"');
+}
+
+// OTLP JSON: ids as hex, 64-bit integers as decimal strings.
+void AppendSpan(std::string* out, const SpanData& span) {
+    *out += "{\"traceId\":\"";
+    AppendHex(out, span.context.trace_id_high);
+    AppendHex(out, span.context.trace_id_low);
+    *out += "\",\"spanId\":\"";
+    AppendHex(out, span.context.span_id);
+    *out += "\"";
+    if (span.parent_span_id != 0) {
+        *out += ",\"parentSpanId\":\"";
+        AppendHex(out, span.parent_span_id);
+        *out += "\"";
+    }
+    *out += ",\"name\":";
+    AppendJsonString(out, span.name);
+    *out += ",\"kind\":" + std::to_string(static_cast<int>(span.kind));
+    *out += ",\"startTimeUnixNano\":\"" + std::to_string(span.start_unix_nanos) + "\"";
+    *out += ",\"endTimeUnixNano\":\"" + std::to_string(span.end_unix_nanos) + "\"";
+
+    *out += ",\"attributes\":[";
+    for (size_t i = 0; i < span.attributes.size(); i++) {
+        const auto& attribute = span.attributes[i];
+        if (i > 0) out->push_back(',');
+        *out += "{\"key\":";
+        AppendJsonString(out, attribute.key);
+        if (attribute.is_int) {
+            *out += ",\"value\":{\"intValue\":\"" + attribute.value + "\"}}";
+        } else {
+            *out += ",\"value\":{\"stringValue\":";
+            AppendJsonString(out, attribute.value);
+            *out += "}}";
+        }
+    }
+    *out += "]";
+
+    if (span.error) {
+        // STATUS_CODE_ERROR; unset (ok) spans carry no status.
+        *out += ",\"status\":{\"code\":2,\"message\":";
+        AppendJsonString(out, span.status_message);
+        *out += "}";
+    }
+    *out += "}";
+}
+
+} // namespace
+
+bool TraceContext::Parse(std::string_view traceparent, TraceContext* out) {
+    // Later versions may append fields after the flags.
+    if (traceparent.size() < 55 || traceparent[2] != '-' || traceparent[35] != '-' ||
+        traceparent[52] != '-') {
+        return false;
+    }
+    uint64_t version = 0;
+    if (!ParseHex(traceparent.substr(0, 2), &version) || version == 0xff) return false;
+    if (version == 0 ? traceparent.size() != 55
+                     : traceparent.size() > 55 && traceparent[55] != '-') {
+        return false;
+    }
+
+    TraceContext context;
+    uint64_t flags = 0;
+    if (!ParseHex(traceparent.substr(3, 16), &context.trace_id_high) ||
+        !ParseHex(traceparent.substr(19, 16), &context.trace_id_low) ||
+        !ParseHex(traceparent.substr(36, 16), &context.span_id) ||
+        !ParseHex(traceparent.substr(53, 2), &flags) || !context.Valid()) {
+        return false;
+    }
+    context.sampled = (flags & 0x01) != 0;
+    *out = context;
+    return true;
+}
+
+std::string TraceContext::ToTraceparent() const {
+    std::string traceparent;
+    traceparent.reserve(55);
+    traceparent += "00-";
+    AppendHex(&traceparent, trace_id_high);
+    AppendHex(&traceparent, trace_id_low);
+    traceparent += "-";
+    AppendHex(&traceparent, span_id);
+    traceparent += sampled ? "-01" : "-00";
+    return traceparent;
+}
+
+std::shared_ptr<Tracer> Tracer::Instance() {
+    static std::shared_ptr<Tracer> instance(new Tracer());
+    return instance;
+}
+
+Tracer::~Tracer() {
+    Stop();
+}
+
+bool Tracer::Start(const TracingConfig& config, const std::string& service_name) {
+    if (!config.enabled || writer_.joinable()) return true;
+
+    file_ = fopen(config.export_path.c_str(), "a");
+    if (!file_) {
+        LOG_ERROR("Failed to open trace export file: " + config.export_path);
+        return false;
+    }
+
+    double ratio = std::clamp(config.sample_ratio, 0.0, 1.0);
+    double threshold = std::ldexp(ratio, 64);
+    sample_all_ = threshold >= std::ldexp(1.0, 64);
+    sample_threshold_ = sample_all_ ? 0 : static_cast<uint64_t>(threshold);
+    max_queued_ = static_cast<size_t>(std::max(config.max_queued_spans, 1));
+    flush_interval_ms_ = std::max(config.flush_interval_ms, 10);
+    service_name_ = service_name;
+
+    stopping_ = false;
+    enabled_ = true;
+    writer_ = std::thread(&Tracer::Run, this);
+
+    LOG_INFO("Tracing enabled: sample_ratio " + std::to_string(ratio) + ", exporting to " +
+             config.export_path);
+    return true;
+}
+
+void Tracer::Stop() {
+    if (!writer_.joinable()) return;
+
+    enabled_ = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    writer_.join();
+
+    fclose(file_);
+    file_ = nullptr;
+}
+
+bool Tracer::ShouldSample(uint64_t trace_id_low) const {
+    return sample_all_ || trace_id_low < sample_threshold_;
+}
+
+void Tracer::Submit(SpanData&& span) {
+    if (!Enabled()) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.size() >= max_queued_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    queue_.push_back(std::move(span));
+}
+
+void Tracer::Run() {
+    std::vector<SpanData> batch;
+    uint64_t reported_drops = 0;
+
+    while (true) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_),
+                         [this]() { return stopping_; });
+            batch.swap(queue_);
+            stopping = stopping_;
+        }
+
+        if (!batch.empty()) {
+            Write(batch);
+            batch.clear();
+        }
+
+        uint64_t dropped = Dropped();
+        if (dropped != reported_drops) {
+            LOG_WARN("Tracing dropped " + std::to_string(dropped - reported_drops) +
+                     " spans, export queue full");
+            reported_drops = dropped;
+        }
+
+        if (stopping) break;
+    }
+}
+
+void Tracer::Write(const std::vector<SpanData>& spans) {
+    std::string line;
+    for (size_t begin = 0; begin < spans.size(); begin += kSpansPerLine) {
+        size_t end = std::min(begin + kSpansPerLine, spans.size());
+
+        line.clear();
+        line += "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\","
+                "\"value\":{\"stringValue\":";
+        AppendJsonString(&line, service_name_);
+        line += "}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"ourchat\"},\"spans\":[";
+        for (size_t i = begin; i < end; i++) {
+            if (i > begin) line.push_back(',');
+            AppendSpan(&line, spans[i]);
+        }
+        line += "]}]}]}\n";
+
+        if (fwrite(line.data(), 1, line.size(), file_) != line.size()) {
+            LOG_ERROR("Failed to write trace export file");
+            break;
+        }
+    }
+    fflush(file_);
+}
+
+std::unique_ptr<Span> Span::StartServer(std::string_view method, std::string_view traceparent) {
+    current_ = TraceContext();
+
+    static std::shared_ptr<Tracer> tracer = Tracer::Instance();
+    if (!tracer->Enabled()) return nullptr;
+
+    TraceContext parent;
+    if (TraceContext::Parse(traceparent, &parent)) {
+        // The caller already decided; follow it.
+        if (!parent.sampled) return nullptr;
+    } else {
+        parent.trace_id_high = NextId();
+        parent.trace_id_low = NextId();
+        parent.span_id = 0;
+        if (!tracer->ShouldSample(parent.trace_id_low)) return nullptr;
+    }
+
+    // Methods arrive as "/package.Service/Method"; span names drop the slash.
+    if (!method.empty() && method[0] == '/') method.remove_prefix(1);
+
+    std::unique_ptr<Span> span(new Span());
+    span->Open(parent, method, SpanKind::kServer);
+    return span;
+}
+
+void Span::Open(const TraceContext& parent, std::string_view name, SpanKind kind) {
+    data_ = std::make_unique<SpanData>();
+    data_->context.trace_id_high = parent.trace_id_high;
+    data_->context.trace_id_low = parent.trace_id_low;
+    data_->context.span_id = NextId();
+    data_->context.sampled = true;
+    data_->parent_span_id = parent.span_id;
+    data_->name.assign(name.data(), name.size());
+    data_->kind = kind;
+    data_->start_unix_nanos = UnixNanos();
+    start_ = std::chrono::steady_clock::now();
+
+    parent_ = current_;
+    current_ = data_->context;
+}
+
+void Span::AddAttribute(const char* key, std::string value, bool is_int) {
+    data_->attributes.push_back(SpanData::Attribute{key, std::move(value), is_int});
+}
+
+void Span::RecordError(std::string_view message) {
+    data_->error = true;
+    data_->status_message.assign(message.data(), message.size());
+}
+
+void Span::End() {
+    if (!data_) return;
+
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    data_->end_unix_nanos = data_->start_unix_nanos + static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    // A span ended on another thread leaves that thread's context alone.
+    if (current_.span_id == data_->context.span_id) {
+        current_ = parent_;
+    }
+
+    static std::shared_ptr<Tracer> tracer = Tracer::Instance();
+    tracer->Submit(std::move(*data_));
+    data_.reset();
+}
+
+} // namespace ourchat
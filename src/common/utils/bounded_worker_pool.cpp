@@ -0,0 +1,99 @@
+#include "../../../include/common/bounded_worker_pool.h"
+#include "../../../include/common/logger.h"
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+namespace ourchat {
+
+BoundedWorkerPool::BoundedWorkerPool(const std::string& name, int threads, int max_queue,
+                                     bool pin_threads)
+    : name_(name), max_queue_(static_cast<size_t>(std::max(max_queue, 0))) {
+    threads = std::max(threads, 1);
+    for (int i = 0; i < threads; i++) {
+        workers_.emplace_back([this]() { Run(); });
+        if (pin_threads) {
+            Pin(workers_.back(), i, threads);
+        }
+    }
+
+    LOG_INFO("Worker pool " + name_ + " started with " + std::to_string(threads) +
+             " threads, queue limit " + std::to_string(max_queue_));
+}
+
+BoundedWorkerPool::~BoundedWorkerPool() {
+    Stop();
+}
+
+bool BoundedWorkerPool::TrySubmit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || tasks_.size() >= max_queue_) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        tasks_.push(std::move(task));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void BoundedWorkerPool::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+size_t BoundedWorkerPool::QueueDepth() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void BoundedWorkerPool::Run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            // Drain what was accepted before stopping; callers are waiting on it.
+            if (tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
+
+void BoundedWorkerPool::Pin(std::thread& thread, int slot, int threads) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+    }
+    // Never take every core; leave at least one for the rest of the server.
+    if (cpus.size() < 2) return;
+
+    size_t reserved = std::min(static_cast<size_t>(threads), cpus.size() - 1);
+    int cpu = cpus[cpus.size() - reserved + static_cast<size_t>(slot) % reserved];
+
+    cpu_set_t target;
+    CPU_ZERO(&target);
+    CPU_SET(cpu, &target);
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(target), &target) != 0) {
+        LOG_WARN("Failed to pin " + name_ + " worker to cpu " + std::to_string(cpu));
+    }
+}
+
+} // namespace ourchat
@@ -7,17 +7,20 @@
 #include <openssl/rand.h>
 #include <openssl/bio.h>
 #include <openssl/buffer.h>
+#include <openssl/crypto.h>
+#include <crypt.h>
 #include <sstream>
 #include <iomanip>
 #include <random>
 #include <cstring>
+#include <cstdlib>
 #include <uuid/uuid.h>
 
 namespace ourchat {
 
 std::string CryptoUtil::MD5Hash(const std::string& data) {
     unsigned char hash[MD5_DIGEST_LENGTH];
-    ::MD5(reinterpret_cast<const unsigned char*>(data.c_str()), data.length(), hash);
+    EVP_Digest(data.data(), data.length(), hash, nullptr, EVP_md5(), nullptr);
     
     std::stringstream ss;
     for (int i = 0; i < MD5_DIGEST_LENGTH; i++) {
@@ -150,12 +153,56 @@ std::string CryptoUtil::GenerateSessionId() {
     return GenerateToken(32);
 }
 
+namespace {
+
+const char kBcryptPrefix[] = "$2b$";
+
+// struct crypt_data is ~32KB, keep one per thread instead of on the stack.
+thread_local struct crypt_data crypt_buffer;
+
+bool ConstantTimeEquals(const std::string& a, const std::string& b) {
+    return a.size() == b.size() && CRYPTO_memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+} // namespace
+
 bool CryptoUtil::ValidatePassword(const std::string& password, const std::string& hash) {
-    return HashPassword(password) == hash;
+    if (hash.empty()) return false;
+    
+    if (hash[0] != '$') {
+        return ConstantTimeEquals(SHA256Hash(password), hash);
+    }
+    
+    std::memset(&crypt_buffer, 0, sizeof(crypt_buffer));
+    const char* result = crypt_r(password.c_str(), hash.c_str(), &crypt_buffer);
+    // Failures return NULL or a string starting with '*'.
+    if (!result || result[0] == '*') return false;
+    
+    return ConstantTimeEquals(result, hash);
+}
+
+std::string CryptoUtil::HashPassword(const std::string& password, int cost) {
+    unsigned char random[16];
+    if (RAND_bytes(random, sizeof(random)) != 1) return "";
+    
+    char setting[CRYPT_GENSALT_OUTPUT_SIZE];
+    if (!crypt_gensalt_rn(kBcryptPrefix, static_cast<unsigned long>(cost),
+                          reinterpret_cast<const char*>(random), sizeof(random),
+                          setting, sizeof(setting))) {
+        return "";
+    }
+    
+    std::memset(&crypt_buffer, 0, sizeof(crypt_buffer));
+    const char* result = crypt_r(password.c_str(), setting, &crypt_buffer);
+    if (!result || result[0] == '*') return "";
+    
+    return result;
 }
 
-std::string CryptoUtil::HashPassword(const std::string& password) {
-    return SHA256Hash(password);
+bool CryptoUtil::NeedsRehash(const std::string& hash, int cost) {
+    // $2b$NN$...
+    if (hash.compare(0, 4, kBcryptPrefix) != 0 || hash.size() < 7) return true;
+    return std::atoi(hash.c_str() + 4) != cost;
 }
 
 std::string CryptoUtil::GenerateUUID() {
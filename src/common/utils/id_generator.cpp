@@ -0,0 +1,50 @@
+#include "../../../include/common/id_generator.h"
+#include "../../../include/common/time_util.h"
+
+namespace ourchat {
+
+IdGenerator& IdGenerator::Instance() {
+    static IdGenerator instance;
+    return instance;
+}
+
+void IdGenerator::Init(int node_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    node_id_ = node_id & ((1 << kNodeBits) - 1);
+}
+
+int64_t IdGenerator::NextId() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    int64_t now = TimeUtil::GetCurrentTimestampMs();
+    if (now < last_ms_) {
+        // Clock stepped backwards: keep issuing from the last timestamp so
+        // ids stay monotonic on this node.
+        now = last_ms_;
+    }
+    
+    if (now == last_ms_) {
+        sequence_ = (sequence_ + 1) & ((1 << kSequenceBits) - 1);
+        if (sequence_ == 0) {
+            // Sequence exhausted within this millisecond: borrow the next one.
+            now = last_ms_ + 1;
+        }
+    } else {
+        sequence_ = 0;
+    }
+    
+    last_ms_ = now;
+    return ((now - kEpochMs) << (kNodeBits + kSequenceBits)) |
+           (node_id_ << kSequenceBits) | sequence_;
+}
+
+int64_t IdGenerator::TimestampMs(int64_t id) {
+    return (id >> (kNodeBits + kSequenceBits)) + kEpochMs;
+}
+
+int64_t IdGenerator::MinIdForTimestampMs(int64_t timestamp_ms) {
+    if (timestamp_ms <= kEpochMs) return 0;
+    return (timestamp_ms - kEpochMs) << (kNodeBits + kSequenceBits);
+}
+
+} // namespace ourchat
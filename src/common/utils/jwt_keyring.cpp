@@ -0,0 +1,90 @@
+#include "../../../include/common/jwt_keyring.h"
+#include "../../../include/common/logger.h"
+#include <atomic>
+
+namespace ourchat {
+
+namespace {
+
+bool ValidKid(const std::string& kid) {
+    if (kid.empty() || kid.size() > 64) return false;
+    for (char c : kid) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                  c == '-' || c == '_' || c == '.';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<JWTKeyring> JWTKeyring::Instance() {
+    static std::shared_ptr<JWTKeyring> instance(new JWTKeyring());
+    return instance;
+}
+
+const JWTKeyring::Key* JWTKeyring::KeySet::Find(std::string_view kid) const {
+    for (const auto& key : keys) {
+        if (key.kid == kid) return &key;
+    }
+    return nullptr;
+}
+
+bool JWTKeyring::Load(const JWTConfig& config) {
+    auto key_set = std::make_shared<KeySet>();
+
+    // kid "" is the legacy single secret, used for tokens without a kid.
+    if (!config.secret.empty()) {
+        key_set->keys.push_back(Key{"", HmacKey(config.secret)});
+    }
+
+    for (const auto& key_config : config.keys) {
+        if (!ValidKid(key_config.kid) || key_config.secret.empty()) {
+            LOG_ERROR("Invalid JWT key '" + key_config.kid + "'");
+            return false;
+        }
+        if (key_set->Find(key_config.kid)) {
+            LOG_ERROR("Duplicate JWT kid '" + key_config.kid + "'");
+            return false;
+        }
+        key_set->keys.push_back(Key{key_config.kid, HmacKey(key_config.secret)});
+    }
+
+    const Key* active = key_set->Find(config.active_kid);
+    if (!active) {
+        LOG_ERROR("JWT active_kid '" + config.active_kid + "' has no key");
+        return false;
+    }
+    key_set->active = static_cast<size_t>(active - key_set->keys.data());
+
+    std::shared_ptr<const KeySet> snapshot = key_set;
+    std::atomic_store(&keys_, snapshot);
+
+    LOG_INFO("JWT keyring loaded with " + std::to_string(key_set->keys.size()) +
+             " keys, active kid '" + config.active_kid + "'");
+    return true;
+}
+
+std::string JWTKeyring::Sign(int64_t user_id, int expires_in_seconds, int64_t version) {
+    auto key_set = std::atomic_load(&keys_);
+    if (!key_set) return "";
+
+    const Key& key = key_set->keys[key_set->active];
+    return JWTUtil::GenerateToken(user_id, key.hmac, key.kid, expires_in_seconds, version);
+}
+
+bool JWTKeyring::Verify(std::string_view token, JWTClaims* claims) {
+    auto key_set = std::atomic_load(&keys_);
+    if (!key_set) return false;
+
+    char header[256];
+    std::string_view kid;
+    if (!JWTUtil::ReadKid(token, header, sizeof(header), &kid)) return false;
+
+    const Key* key = key_set->Find(kid);
+    if (!key) return false;
+
+    return JWTUtil::Verify(token, key->hmac, claims);
+}
+
+} // namespace ourchat
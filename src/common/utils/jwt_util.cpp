@@ -0,0 +1,429 @@
+#include "../../../include/common/jwt_util.h"
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace ourchat {
+
+namespace {
+
+const char kEncodeTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+constexpr std::array<int8_t, 256> MakeDecodeTable() {
+    std::array<int8_t, 256> table{};
+    for (auto& entry : table) entry = -1;
+    for (int i = 0; i < 64; i++) {
+        table[static_cast<unsigned char>(kEncodeTable[i])] = static_cast<int8_t>(i);
+    }
+    return table;
+}
+
+constexpr std::array<int8_t, 256> kDecodeTable = MakeDecodeTable();
+
+// Key for the plain-secret overloads, rebuilt only when the secret changes.
+struct CachedKey {
+    std::string secret;
+    HmacKey key{std::string_view()};
+    bool ready = false;
+};
+
+thread_local CachedKey cached_key;
+
+// SHA-256 (FIPS 180-4) over a caller-owned state. OpenSSL's EVP digests
+// cannot be resumed from a saved state without allocating, and its
+// SHA256_Init family is deprecated in 3.0. Uses the x86 SHA extensions
+// when the CPU has them, as OpenSSL does; the portable rounds are several
+// times slower.
+alignas(16) const uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+const uint32_t kInitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+inline uint32_t Rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+void CompressPortable(uint32_t* state, const unsigned char* data, size_t blocks) {
+    for (; blocks > 0; blocks--, data += SHA256_CBLOCK) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t(data[i * 4]) << 24) | (uint32_t(data[i * 4 + 1]) << 16) |
+                   (uint32_t(data[i * 4 + 2]) << 8) | uint32_t(data[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                          kRoundConstants[i] + w[i];
+            uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("sha,sse4.1")))
+void CompressShaNi(uint32_t* state, const unsigned char* data, size_t blocks) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The instructions keep the state as ABEF and CDGH.
+    __m128i cdab = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xb1);
+    __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1b);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
+
+    for (; blocks > 0; blocks--, data += SHA256_CBLOCK) {
+        __m128i abef_start = abef;
+        __m128i cdgh_start = cdgh;
+
+        // Four rounds per step; w holds the last four steps' message words.
+        __m128i w[4];
+        for (int i = 0; i < 16; i++) {
+            __m128i words;
+            if (i < 4) {
+                words = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16)), byte_swap);
+            } else {
+                words = _mm_add_epi32(_mm_sha256msg1_epu32(w[i % 4], w[(i + 1) % 4]),
+                                      _mm_alignr_epi8(w[(i + 3) % 4], w[(i + 2) % 4], 4));
+                words = _mm_sha256msg2_epu32(words, w[(i + 3) % 4]);
+            }
+            w[i % 4] = words;
+
+            __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(kRoundConstants + i * 4));
+            __m128i message = _mm_add_epi32(words, k);
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(message, 0x0e));
+        }
+
+        abef = _mm_add_epi32(abef, abef_start);
+        cdgh = _mm_add_epi32(cdgh, cdgh_start);
+    }
+
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+#endif
+
+void Compress(uint32_t* state, const unsigned char* data, size_t blocks) {
+#if defined(__x86_64__) && defined(__GNUC__)
+    static const bool sha_ni = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+    }();
+    if (sha_ni) {
+        CompressShaNi(state, data, blocks);
+        return;
+    }
+#endif
+    CompressPortable(state, data, blocks);
+}
+
+// Hashes data onto a state that has already absorbed prefix_len bytes (a
+// whole number of blocks) and writes the digest.
+void Finish(uint32_t* state, uint64_t prefix_len, std::string_view data, unsigned char* digest) {
+    const auto* in = reinterpret_cast<const unsigned char*>(data.data());
+    size_t len = data.size();
+    size_t blocks = len / SHA256_CBLOCK;
+    Compress(state, in, blocks);
+    in += blocks * SHA256_CBLOCK;
+    len -= blocks * SHA256_CBLOCK;
+
+    unsigned char tail[SHA256_CBLOCK * 2] = {0};
+    std::memcpy(tail, in, len);
+    tail[len] = 0x80;
+    size_t tail_len = len + 9 <= SHA256_CBLOCK ? SHA256_CBLOCK : SHA256_CBLOCK * 2;
+    uint64_t bits = (prefix_len + data.size()) * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tail_len - 1 - i] = static_cast<unsigned char>(bits >> (i * 8));
+    }
+    Compress(state, tail, tail_len / SHA256_CBLOCK);
+
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = static_cast<unsigned char>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<unsigned char>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<unsigned char>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<unsigned char>(state[i]);
+    }
+}
+
+const HmacKey& KeyForSecret(std::string_view secret) {
+    CachedKey& cached = cached_key;
+    if (!cached.ready || cached.secret != secret) {
+        cached.key = HmacKey(secret);
+        cached.secret.assign(secret.data(), secret.size());
+        cached.ready = true;
+    }
+    return cached.key;
+}
+
+// Finds "name":"value" in a flat JSON object.
+bool FindString(std::string_view json, std::string_view key, std::string_view* value) {
+    size_t pos = json.find(key);
+    if (pos == std::string_view::npos) return false;
+
+    pos += key.size();
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == ':')) pos++;
+    if (pos >= json.size() || json[pos] != '"') return false;
+
+    size_t end = json.find('"', pos + 1);
+    if (end == std::string_view::npos) return false;
+
+    *value = json.substr(pos + 1, end - pos - 1);
+    return true;
+}
+
+bool FindInt(std::string_view json, std::string_view key, int64_t* value) {
+    size_t pos = json.find(key);
+    if (pos == std::string_view::npos) return false;
+
+    pos += key.size();
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == ':')) pos++;
+
+    auto result = std::from_chars(json.data() + pos, json.data() + json.size(), *value);
+    return result.ec == std::errc();
+}
+
+} // namespace
+
+HmacKey::HmacKey(std::string_view secret) {
+    unsigned char block[SHA256_CBLOCK] = {0};
+    if (secret.size() > SHA256_CBLOCK) {
+        SHA256(reinterpret_cast<const unsigned char*>(secret.data()), secret.size(), block);
+    } else {
+        std::memcpy(block, secret.data(), secret.size());
+    }
+
+    unsigned char inner_pad[SHA256_CBLOCK];
+    unsigned char outer_pad[SHA256_CBLOCK];
+    for (size_t i = 0; i < SHA256_CBLOCK; i++) {
+        inner_pad[i] = block[i] ^ 0x36;
+        outer_pad[i] = block[i] ^ 0x5c;
+    }
+
+    std::memcpy(inner_, kInitialState, sizeof(inner_));
+    std::memcpy(outer_, kInitialState, sizeof(outer_));
+    Compress(inner_, inner_pad, 1);
+    Compress(outer_, outer_pad, 1);
+
+    OPENSSL_cleanse(block, sizeof(block));
+    OPENSSL_cleanse(inner_pad, sizeof(inner_pad));
+    OPENSSL_cleanse(outer_pad, sizeof(outer_pad));
+}
+
+void HmacKey::Sign(std::string_view data, unsigned char* mac) const {
+    static_assert(kMacSize == SHA256_DIGEST_LENGTH, "HMAC-SHA256 tag size");
+
+    uint32_t state[8];
+    unsigned char inner_hash[SHA256_DIGEST_LENGTH];
+    std::memcpy(state, inner_, sizeof(state));
+    Finish(state, SHA256_CBLOCK, data, inner_hash);
+
+    std::memcpy(state, outer_, sizeof(state));
+    Finish(state, SHA256_CBLOCK,
+           std::string_view(reinterpret_cast<const char*>(inner_hash), sizeof(inner_hash)), mac);
+}
+
+std::string JWTUtil::GenerateToken(int64_t user_id, const std::string& secret, int expires_in_seconds) {
+    return GenerateToken(user_id, KeyForSecret(secret), std::string_view(), expires_in_seconds);
+}
+
+std::string JWTUtil::GenerateToken(int64_t user_id, const HmacKey& key, std::string_view kid,
+                                   int expires_in_seconds, int64_t version) {
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+
+    std::string header = Base64UrlEncode(
+        kid.empty() ? std::string("{\"alg\":\"HS256\",\"typ\":\"JWT\"}")
+                    : "{\"alg\":\"HS256\",\"typ\":\"JWT\",\"kid\":\"" + std::string(kid) + "\"}");
+    std::string payload = Base64UrlEncode("{\"user_id\":" + std::to_string(user_id) +
+                                          ",\"iat\":" + std::to_string(now) +
+                                          ",\"exp\":" + std::to_string(now + expires_in_seconds) +
+                                          (version ? ",\"ver\":" + std::to_string(version) : std::string()) +
+                                          "}");
+
+    std::string signing_input = header + "." + payload;
+    unsigned char mac[SHA256_DIGEST_LENGTH];
+    key.Sign(signing_input, mac);
+
+    return signing_input + "." +
+           Base64UrlEncode(std::string_view(reinterpret_cast<const char*>(mac), sizeof(mac)));
+}
+
+bool JWTUtil::ValidateToken(const std::string& token, int64_t& user_id, const std::string& secret) {
+    JWTClaims claims;
+    if (!Verify(token, secret, &claims)) return false;
+
+    user_id = claims.user_id;
+    return true;
+}
+
+bool JWTUtil::Verify(std::string_view token, std::string_view secret, JWTClaims* claims) {
+    return Verify(token, KeyForSecret(secret), claims);
+}
+
+bool JWTUtil::Verify(std::string_view token, const HmacKey& key, JWTClaims* claims) {
+    size_t first = 0;
+    size_t second = 0;
+    if (!SplitToken(token, &first, &second)) return false;
+
+    unsigned char expected[SHA256_DIGEST_LENGTH];
+    key.Sign(token.substr(0, second), expected);
+
+    unsigned char signature[SHA256_DIGEST_LENGTH + 3];
+    int signature_len = Base64UrlDecode(token.substr(second + 1), signature, sizeof(signature));
+    if (signature_len != SHA256_DIGEST_LENGTH ||
+        CRYPTO_memcmp(expected, signature, SHA256_DIGEST_LENGTH) != 0) {
+        return false;
+    }
+
+    unsigned char payload[kMaxSegmentSize];
+    int payload_len = Base64UrlDecode(token.substr(first + 1, second - first - 1),
+                                      payload, sizeof(payload));
+    if (payload_len < 0) return false;
+
+    if (!ParseClaims(std::string_view(reinterpret_cast<const char*>(payload), payload_len), claims)) {
+        return false;
+    }
+
+    return claims->exp == 0 || static_cast<int64_t>(std::time(nullptr)) <= claims->exp;
+}
+
+bool JWTUtil::ReadKid(std::string_view token, char* buffer, size_t capacity, std::string_view* kid) {
+    size_t first = 0;
+    size_t second = 0;
+    if (!SplitToken(token, &first, &second)) return false;
+
+    int header_len = Base64UrlDecode(token.substr(0, first),
+                                     reinterpret_cast<unsigned char*>(buffer), capacity);
+    if (header_len < 0) return false;
+
+    *kid = std::string_view();
+    FindString(std::string_view(buffer, header_len), "\"kid\"", kid);
+    return true;
+}
+
+bool JWTUtil::SplitToken(std::string_view token, size_t* first, size_t* second) {
+    *first = token.find('.');
+    if (*first == std::string_view::npos) return false;
+
+    *second = token.find('.', *first + 1);
+    return *second != std::string_view::npos &&
+           token.find('.', *second + 1) == std::string_view::npos;
+}
+
+bool JWTUtil::ParseClaims(std::string_view payload, JWTClaims* claims) {
+    *claims = JWTClaims();
+    if (!FindInt(payload, "\"user_id\"", &claims->user_id)) return false;
+
+    // Optional; a present but malformed exp is rejected.
+    if (payload.find("\"exp\"") != std::string_view::npos &&
+        !FindInt(payload, "\"exp\"", &claims->exp)) {
+        return false;
+    }
+    FindInt(payload, "\"iat\"", &claims->iat);
+    FindInt(payload, "\"ver\"", &claims->version);
+    return true;
+}
+
+std::string JWTUtil::Base64UrlEncode(std::string_view input) {
+    std::string result;
+    result.reserve((input.size() * 4 + 2) / 3);
+
+    const auto* in = reinterpret_cast<const unsigned char*>(input.data());
+    size_t i = 0;
+    for (; i + 3 <= input.size(); i += 3) {
+        uint32_t v = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+        result += kEncodeTable[(v >> 18) & 0x3f];
+        result += kEncodeTable[(v >> 12) & 0x3f];
+        result += kEncodeTable[(v >> 6) & 0x3f];
+        result += kEncodeTable[v & 0x3f];
+    }
+
+    size_t rest = input.size() - i;
+    if (rest > 0) {
+        uint32_t v = in[i] << 16;
+        if (rest == 2) v |= in[i + 1] << 8;
+        result += kEncodeTable[(v >> 18) & 0x3f];
+        result += kEncodeTable[(v >> 12) & 0x3f];
+        if (rest == 2) result += kEncodeTable[(v >> 6) & 0x3f];
+    }
+
+    return result;
+}
+
+int JWTUtil::Base64UrlDecode(std::string_view input, unsigned char* out, size_t capacity) {
+    // Tokens issued before the encoder stripped padding carry trailing '='
+    // or NUL characters; they are not part of the data.
+    while (!input.empty() && (input.back() == '=' || input.back() == '\0')) {
+        input.remove_suffix(1);
+    }
+
+    size_t rest = input.size() % 4;
+    if (rest == 1) return -1;
+
+    size_t out_len = input.size() / 4 * 3 + (rest ? rest - 1 : 0);
+    if (out_len > capacity) return -1;
+
+    const auto* in = reinterpret_cast<const unsigned char*>(input.data());
+    size_t i = 0;
+    size_t o = 0;
+    for (; i + 4 <= input.size(); i += 4) {
+        int a = kDecodeTable[in[i]];
+        int b = kDecodeTable[in[i + 1]];
+        int c = kDecodeTable[in[i + 2]];
+        int d = kDecodeTable[in[i + 3]];
+        if ((a | b | c | d) < 0) return -1;
+
+        uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+        out[o++] = static_cast<unsigned char>(v >> 16);
+        out[o++] = static_cast<unsigned char>(v >> 8);
+        out[o++] = static_cast<unsigned char>(v);
+    }
+
+    if (rest > 0) {
+        int a = kDecodeTable[in[i]];
+        int b = kDecodeTable[in[i + 1]];
+        int c = rest == 3 ? kDecodeTable[in[i + 2]] : 0;
+        if ((a | b | c) < 0) return -1;
+
+        uint32_t v = (a << 18) | (b << 12) | (c << 6);
+        out[o++] = static_cast<unsigned char>(v >> 16);
+        if (rest == 3) out[o++] = static_cast<unsigned char>(v >> 8);
+    }
+
+    return static_cast<int>(o);
+}
+
+} // namespace ourchat
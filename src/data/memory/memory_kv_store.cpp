@@ -0,0 +1,153 @@
+#include "../../../include/data/memory_store.h"
+#include <cstdlib>
+#include <functional>
+
+namespace ourchat {
+
+MemoryKVStore::MemoryKVStore(SimulatedLatency latency) : latency_(latency) {}
+
+MemoryKVStore::Shard& MemoryKVStore::GetShard(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % kShardCount];
+}
+
+MemoryKVStore::Entry* MemoryKVStore::FindLocked(Shard& shard, const std::string& key,
+                                                Clock::time_point now) {
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) return nullptr;
+    if (it->second.expires_at <= now) {
+        shard.entries.erase(it);
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void MemoryKVStore::SetLocked(Shard& shard, const std::string& key, int seconds,
+                              const std::string& value, Clock::time_point now) {
+    if (++shard.writes % kSweepInterval == 0) {
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            it = it->second.expires_at <= now ? shard.entries.erase(it) : std::next(it);
+        }
+    }
+
+    Entry& entry = shard.entries[key];
+    entry.value = value;
+    entry.hash.clear();
+    entry.expires_at = now + std::chrono::seconds(seconds);
+}
+
+std::string MemoryKVStore::Get(const std::string& key) {
+    latency_.Wait();
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Entry* entry = FindLocked(shard, key, Clock::now());
+    return entry ? entry->value : std::string();
+}
+
+bool MemoryKVStore::SetEx(const std::string& key, int seconds, const std::string& value) {
+    latency_.Wait();
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    SetLocked(shard, key, seconds, value, Clock::now());
+    return true;
+}
+
+bool MemoryKVStore::SetNxEx(const std::string& key, int seconds, const std::string& value) {
+    latency_.Wait();
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto now = Clock::now();
+    if (FindLocked(shard, key, now)) return false;
+
+    SetLocked(shard, key, seconds, value, now);
+    return true;
+}
+
+bool MemoryKVStore::SetExMany(const std::vector<std::pair<std::string, std::string>>& entries,
+                              int seconds) {
+    latency_.Wait();
+
+    // Every shard involved is locked, in index order, before the first
+    // write, so readers see all of the entries or none.
+    bool involved[kShardCount] = {};
+    for (const auto& entry : entries) {
+        involved[&GetShard(entry.first) - shards_] = true;
+    }
+    std::unique_lock<std::mutex> locks[kShardCount];
+    for (size_t i = 0; i < kShardCount; i++) {
+        if (involved[i]) locks[i] = std::unique_lock<std::mutex>(shards_[i].mutex);
+    }
+
+    auto now = Clock::now();
+    for (const auto& entry : entries) {
+        SetLocked(GetShard(entry.first), entry.first, seconds, entry.second, now);
+    }
+    return true;
+}
+
+bool MemoryKVStore::Del(const std::string& key) {
+    latency_.Wait();
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.entries.erase(key) > 0;
+}
+
+bool MemoryKVStore::Expire(const std::string& key, int seconds) {
+    latency_.Wait();
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto now = Clock::now();
+    Entry* entry = FindLocked(shard, key, now);
+    if (!entry) return false;
+
+    entry->expires_at = now + std::chrono::seconds(seconds);
+    return true;
+}
+
+std::string MemoryKVStore::HGet(const std::string& key, const std::string& field) {
+    latency_.Wait();
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Entry* entry = FindLocked(shard, key, Clock::now());
+    if (!entry) return std::string();
+
+    auto it = entry->hash.find(field);
+    return it == entry->hash.end() ? std::string() : it->second;
+}
+
+int64_t MemoryKVStore::HIncrBy(const std::string& key, const std::string& field, int64_t increment) {
+    latency_.Wait();
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Entry* entry = FindLocked(shard, key, Clock::now());
+    if (!entry) {
+        entry = &shard.entries[key];
+        entry->expires_at = Clock::time_point::max();
+    }
+
+    std::string& value = entry->hash[field];
+    int64_t result = std::strtoll(value.c_str(), nullptr, 10) + increment;
+    value = std::to_string(result);
+    return result;
+}
+
+std::map<std::string, std::string> MemoryKVStore::HGetAll(const std::string& key) {
+    latency_.Wait();
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Entry* entry = FindLocked(shard, key, Clock::now());
+    return entry ? entry->hash : std::map<std::string, std::string>();
+}
+
+void MemoryKVStore::Publish(const std::string& channel, const std::string& message) {
+    // Publishes are asynchronous against Redis too, so no latency here.
+}
+
+} // namespace ourchat
@@ -0,0 +1,102 @@
+#include "../../../include/data/memory_store.h"
+#include "../../../include/common/id_generator.h"
+#include <algorithm>
+
+namespace ourchat {
+
+MemoryMessageStore::MemoryMessageStore(SimulatedLatency latency) : latency_(latency) {}
+
+size_t MemoryMessageStore::ShardOf(int64_t key) {
+    uint64_t h = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(h >> 32) % kShardCount;
+}
+
+template <typename Record>
+void MemoryMessageStore::InsertOrdered(std::vector<Record>* messages, Record record) {
+    // Ids are time ordered, so this is an append unless two senders raced.
+    auto position = messages->end();
+    while (position != messages->begin() && (position - 1)->id > record.id) {
+        --position;
+    }
+    messages->insert(position, std::move(record));
+}
+
+bool MemoryMessageStore::InsertSingle(MessageRecord* record) {
+    latency_.Wait();
+
+    record->id = IdGenerator::Instance().NextId();
+    record->create_time = IdGenerator::TimestampMs(record->id) / 1000;
+
+    auto& shard = conversations_[ShardOf(record->conversation_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    InsertOrdered(&shard.messages[record->conversation_id], *record);
+    return true;
+}
+
+bool MemoryMessageStore::InsertGroup(GroupMessageRecord* record) {
+    latency_.Wait();
+
+    record->id = IdGenerator::Instance().NextId();
+    record->seq_id = record->id;
+    record->create_time = IdGenerator::TimestampMs(record->id) / 1000;
+
+    auto& shard = groups_[ShardOf(record->group_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    InsertOrdered(&shard.messages[record->group_id], *record);
+    return true;
+}
+
+bool MemoryMessageStore::QuerySingle(int64_t reader_id, int64_t conversation_id, int64_t before_id,
+                                     int64_t start_time, int limit, std::vector<MessageRecord>* out,
+                                     bool* current) {
+    latency_.Wait();
+    out->clear();
+    *current = true;
+
+    auto& shard = conversations_[ShardOf(conversation_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.messages.find(conversation_id);
+    if (it == shard.messages.end()) return true;
+
+    const auto& messages = it->second;
+    auto end = messages.end();
+    if (before_id > 0) {
+        end = std::lower_bound(messages.begin(), messages.end(), before_id,
+                               [](const MessageRecord& record, int64_t id) { return record.id < id; });
+    }
+
+    for (auto cursor = end; cursor != messages.begin() && static_cast<int>(out->size()) < limit;) {
+        --cursor;
+        if (start_time > 0 && cursor->create_time > start_time) continue;
+        out->push_back(*cursor);
+    }
+    return true;
+}
+
+bool MemoryMessageStore::IsGroupMember(int64_t group_id, int64_t user_id, bool* member) {
+    latency_.Wait();
+
+    std::shared_lock<std::shared_mutex> lock(members_mutex_);
+    *member = group_members_.count(std::make_pair(group_id, user_id)) > 0;
+    return true;
+}
+
+void MemoryMessageStore::AddGroupMember(int64_t group_id, int64_t user_id) {
+    std::unique_lock<std::shared_mutex> lock(members_mutex_);
+    group_members_.emplace(group_id, user_id);
+}
+
+bool MemoryMessageStore::SaveReadReceipts(const std::vector<ReadReceiptRecord>& receipts) {
+    latency_.Wait();
+
+    std::lock_guard<std::mutex> lock(receipts_mutex_);
+    for (const auto& receipt : receipts) {
+        auto result = receipts_.emplace(std::make_pair(receipt.user_id, receipt.peer_id), receipt);
+        if (!result.second && result.first->second.last_read_message_id < receipt.last_read_message_id) {
+            result.first->second = receipt;
+        }
+    }
+    return true;
+}
+
+} // namespace ourchat
@@ -0,0 +1,46 @@
+#include "../../../include/data/memory_store.h"
+
+namespace ourchat {
+
+MemoryUserStore::MemoryUserStore(SimulatedLatency latency) : latency_(latency) {}
+
+bool MemoryUserStore::Create(UserRecord* record) {
+    latency_.Wait();
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (by_username_.count(record->username)) return false;
+
+    record->id = next_id_++;
+    by_username_[record->username] = *record;
+    username_by_id_[record->id] = record->username;
+    return true;
+}
+
+bool MemoryUserStore::FindByUsername(const std::string& username, UserRecord* out, bool* found) {
+    latency_.Wait();
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = by_username_.find(username);
+    *found = it != by_username_.end();
+    if (*found) {
+        *out = it->second;
+    }
+    return true;
+}
+
+bool MemoryUserStore::UpdatePasswordHash(int64_t user_id, const std::string& old_hash,
+                                         const std::string& new_hash) {
+    latency_.Wait();
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto name = username_by_id_.find(user_id);
+    if (name == username_by_id_.end()) return false;
+
+    UserRecord& user = by_username_[name->second];
+    if (user.password_hash != old_hash) return false;
+
+    user.password_hash = new_hash;
+    return true;
+}
+
+} // namespace ourchat
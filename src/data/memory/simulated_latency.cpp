@@ -0,0 +1,22 @@
+#include "../../../include/data/memory_store.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+namespace ourchat {
+
+SimulatedLatency::SimulatedLatency(int latency_us, int jitter_us)
+    : latency_us_(std::max(latency_us, 0)), jitter_us_(std::max(jitter_us, 0)) {}
+
+void SimulatedLatency::Wait() const {
+    if (latency_us_ == 0 && jitter_us_ == 0) return;
+
+    int delay_us = latency_us_;
+    if (jitter_us_ > 0) {
+        thread_local std::minstd_rand random(std::random_device{}());
+        delay_us += std::uniform_int_distribution<int>(0, jitter_us_)(random);
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+}
+
+} // namespace ourchat
@@ -1,8 +1,33 @@
 #include "../../../include/data/mysql_connection.h"
 #include "../../../include/common/logger.h"
+#include "../../../include/common/tracing.h"
+#include <algorithm>
+#include <mysql/errmsg.h>
 
 namespace ourchat {
 
+namespace {
+
+constexpr size_t kMaxTracedStatement = 160;
+
+// The statement up to its first literal-bearing clause, so spans show the
+// operation and table but not user data.
+std::string_view StatementSummary(std::string_view query) {
+    size_t end = std::min(query.size(), kMaxTracedStatement);
+    for (std::string_view clause : {" VALUES", " WHERE ", " SET "}) {
+        end = std::min(end, query.find(clause));
+    }
+    return query.substr(0, end);
+}
+
+void StartQuerySpan(Span* span, const std::string& query) {
+    if (!span->Recording()) return;
+    span->SetAttribute("db.system", "mysql");
+    span->SetAttribute("db.statement", StatementSummary(query));
+}
+
+} // namespace
+
 MySQLConnection::MySQLConnection() : connection_(nullptr), connected_(false) {
     connection_ = mysql_init(nullptr);
     if (!connection_) {
@@ -31,6 +56,7 @@ bool MySQLConnection::Connect(const std::string& host, int port,
     }
     
     connected_ = true;
+    broken_ = false;
     LOG_INFO("Successfully connected to MySQL database");
     return true;
 }
@@ -46,8 +72,13 @@ void MySQLConnection::Close() {
 bool MySQLConnection::Execute(const std::string& query) {
     if (!connected_) return false;
     
+    Span span("mysql.query", SpanKind::kClient);
+    StartQuerySpan(&span, query);
+    
     if (mysql_query(connection_, query.c_str())) {
+        span.SetError(mysql_error(connection_));
         LOG_ERROR("MySQL query failed: " + std::string(mysql_error(connection_)));
+        CheckError();
         return false;
     }
     return true;
@@ -63,20 +94,38 @@ bool MySQLConnection::Execute(const std::string& query, int64_t& insert_id) {
 std::unique_ptr<MYSQL_RES> MySQLConnection::Query(const std::string& query) {
     if (!connected_) return nullptr;
     
+    Span span("mysql.query", SpanKind::kClient);
+    StartQuerySpan(&span, query);
+    
     if (mysql_query(connection_, query.c_str())) {
+        span.SetError(mysql_error(connection_));
         LOG_ERROR("MySQL query failed: " + std::string(mysql_error(connection_)));
+        CheckError();
         return nullptr;
     }
     
     MYSQL_RES* result = mysql_store_result(connection_);
     if (!result) {
+        span.SetError(mysql_error(connection_));
         LOG_ERROR("MySQL store result failed: " + std::string(mysql_error(connection_)));
+        CheckError();
         return nullptr;
     }
     
+    span.SetAttribute("db.rows", static_cast<int64_t>(mysql_num_rows(result)));
     return std::unique_ptr<MYSQL_RES>(result);
 }
 
+std::string MySQLConnection::Escape(const std::string& value) {
+    if (!connection_) return "";
+    
+    std::string escaped(value.length() * 2 + 1, '\0');
+    unsigned long len = mysql_real_escape_string(connection_, &escaped[0],
+                                                 value.data(), value.length());
+    escaped.resize(len);
+    return escaped;
+}
+
 bool MySQLConnection::BeginTransaction() {
     return Execute("START TRANSACTION");
 }
@@ -91,7 +140,25 @@ bool MySQLConnection::Rollback() {
 
 bool MySQLConnection::Ping() {
     if (!connected_) return false;
-    return mysql_ping(connection_) == 0;
+    broken_ = mysql_ping(connection_) != 0;
+    return !broken_;
+}
+
+bool MySQLConnection::IsBroken() const {
+    return !connected_ || broken_;
+}
+
+void MySQLConnection::CheckError() {
+    switch (mysql_errno(connection_)) {
+        case CR_SERVER_GONE_ERROR:
+        case CR_SERVER_LOST:
+        case CR_SERVER_LOST_EXTENDED:
+        case CR_COMMANDS_OUT_OF_SYNC:
+            broken_ = true;
+            break;
+        default:
+            break;
+    }
 }
 
 MYSQL* MySQLConnection::GetRawConnection() {
@@ -0,0 +1,394 @@
+#include "../../../include/data/mysql_message_store.h"
+#include "../../../include/common/id_generator.h"
+#include "../../../include/common/logger.h"
+#include "../../../include/common/time_util.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+namespace ourchat {
+
+const char* MySQLMessageStore::kBaseTable = "im_single_message";
+
+bool MySQLMessageStore::Init(const MessageStoreConfig& config) {
+    config_ = config;
+    config_.shard_count = std::max(config_.shard_count, 1);
+    mysql_pool_ = MySQLPool::Instance();
+    partitions_.assign(config_.shard_count, std::set<int>());
+    absent_.assign(config_.shard_count, std::map<int, Clock::time_point>());
+    oldest_month_ = MonthOf(TimeUtil::GetCurrentTimestampMs());
+
+    if (!config_.partitioned) {
+        LOG_INFO("Message store using unpartitioned table " + std::string(kBaseTable));
+        return true;
+    }
+
+    if (!LoadPartitions()) {
+        return false;
+    }
+
+    LOG_INFO("Message store initialized with " + std::to_string(config_.shard_count) + " shards");
+    return true;
+}
+
+int MySQLMessageStore::ShardOf(int64_t conversation_id) const {
+    uint64_t h = static_cast<uint64_t>(conversation_id) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<int>((h >> 32) % static_cast<uint64_t>(config_.shard_count));
+}
+
+int MySQLMessageStore::MonthOf(int64_t timestamp_ms) {
+    time_t seconds = static_cast<time_t>(timestamp_ms / 1000);
+    std::tm tm = {};
+    gmtime_r(&seconds, &tm);
+    return (tm.tm_year + 1900) * 100 + tm.tm_mon + 1;
+}
+
+int MySQLMessageStore::PreviousMonth(int month) {
+    return month % 100 == 1 ? (month / 100 - 1) * 100 + 12 : month - 1;
+}
+
+std::string MySQLMessageStore::TableName(int shard, int month) const {
+    char name[64];
+    snprintf(name, sizeof(name), "%s_s%02d_%06d", kBaseTable, shard, month);
+    return name;
+}
+
+bool MySQLMessageStore::LoadPartitions() {
+    auto conn = mysql_pool_->GetConnection();
+    if (!conn) return false;
+
+    auto result = conn->Query("SHOW TABLES LIKE 'im\\_single\\_message\\_s%'");
+    conn.Release();
+    if (!result) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        int shard = 0;
+        int month = 0;
+        if (sscanf(row[0], "im_single_message_s%d_%d", &shard, &month) == 2 &&
+            shard >= 0 && shard < config_.shard_count) {
+            partitions_[shard].insert(month);
+            oldest_month_ = std::min(oldest_month_, month);
+        }
+    }
+
+    return true;
+}
+
+bool MySQLMessageStore::EnsurePartition(MySQLConnection* conn, int shard, int month) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (partitions_[shard].count(month)) return true;
+    }
+
+    std::string table = TableName(shard, month);
+    if (!conn->Execute("CREATE TABLE IF NOT EXISTS " + table + " LIKE " + kBaseTable)) {
+        LOG_ERROR("Failed to create message partition " + table);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    partitions_[shard].insert(month);
+    absent_[shard].erase(month);
+    return true;
+}
+
+std::vector<std::string> MySQLMessageStore::PlanPartitions(int shard, int newest_month) {
+    std::vector<int> unknown;
+    {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int month = newest_month; month >= oldest_month_; month = PreviousMonth(month)) {
+            if (partitions_[shard].count(month)) continue;
+            auto it = absent_[shard].find(month);
+            if (it == absent_[shard].end() || now >= it->second) {
+                unknown.push_back(month);
+            }
+        }
+    }
+    if (!unknown.empty()) {
+        ProbePartitions(shard, unknown);
+    }
+
+    std::vector<std::string> tables;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto& months = partitions_[shard];
+        for (auto it = months.rbegin(); it != months.rend(); ++it) {
+            if (*it <= newest_month) {
+                tables.push_back(TableName(shard, *it));
+            }
+        }
+    }
+    tables.push_back(kBaseTable);
+    return tables;
+}
+
+void MySQLMessageStore::ProbePartitions(int shard, const std::vector<int>& months) {
+    // The primary, since a replica may not have a new table yet. On failure
+    // nothing is recorded and the months are looked up on the next read.
+    auto conn = mysql_pool_->GetConnection(QueryIntent::kWrite);
+    if (!conn) return;
+
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "im\\_single\\_message\\_s%02d\\_%%", shard);
+    auto result = conn->Query("SHOW TABLES LIKE '" + std::string(pattern) + "'");
+    conn.Release();
+    if (!result) return;
+
+    std::set<int> found;
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        int table_shard = 0;
+        int month = 0;
+        if (sscanf(row[0], "im_single_message_s%d_%d", &table_shard, &month) == 2 &&
+            table_shard == shard) {
+            found.insert(month);
+        }
+    }
+
+    int settled_before = MonthOf(TimeUtil::GetCurrentTimestampMs() - kMonthSettleMs);
+    auto recheck = Clock::now() + kAbsentRecheck;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int month : found) {
+        partitions_[shard].insert(month);
+        absent_[shard].erase(month);
+    }
+    for (int month : months) {
+        if (!found.count(month)) {
+            absent_[shard][month] = month < settled_before ? Clock::time_point::max() : recheck;
+        }
+    }
+}
+
+bool MySQLMessageStore::InsertSingle(MessageRecord* record) {
+    auto conn = mysql_pool_->GetConnection();
+    if (!conn) return false;
+
+    std::string table = kBaseTable;
+    if (config_.partitioned) {
+        record->id = IdGenerator::Instance().NextId();
+        int64_t created_ms = IdGenerator::TimestampMs(record->id);
+        record->create_time = created_ms / 1000;
+
+        int shard = ShardOf(record->conversation_id);
+        int month = MonthOf(created_ms);
+        if (!EnsurePartition(conn.get(), shard, month)) {
+            return false;
+        }
+        table = TableName(shard, month);
+    } else {
+        record->create_time = TimeUtil::GetCurrentTimestamp();
+    }
+
+    std::string query = "INSERT INTO " + table + " (" +
+                       std::string(config_.partitioned ? "id, " : "") +
+                       "conversation_id, sender_id, receiver_id, message_type, content, "
+                       "status, create_time) VALUES (" +
+                       (config_.partitioned ? std::to_string(record->id) + ", " : std::string()) +
+                       std::to_string(static_cast<uint64_t>(record->conversation_id)) + ", " +
+                       std::to_string(record->sender_id) + ", " +
+                       std::to_string(record->receiver_id) + ", " +
+                       std::to_string(record->message_type) + ", '" +
+                       conn->Escape(record->content) + "', " +
+                       std::to_string(record->status) + ", " +
+                       std::to_string(record->create_time) + ")";
+
+    int64_t insert_id = 0;
+    bool ok = conn->Execute(query, insert_id);
+
+    if (ok) {
+        if (!config_.partitioned) {
+            record->id = insert_id;
+        }
+        mysql_pool_->MarkWrite(record->sender_id);
+    }
+    return ok;
+}
+
+bool MySQLMessageStore::InsertGroup(GroupMessageRecord* record) {
+    auto conn = mysql_pool_->GetConnection();
+    if (!conn) return false;
+
+    record->id = IdGenerator::Instance().NextId();
+    record->seq_id = record->id;
+    record->create_time = IdGenerator::TimestampMs(record->id) / 1000;
+
+    std::string query = "INSERT INTO im_group_message (id, group_id, sender_id, message_type, "
+                       "content, seq_id, create_time) VALUES (" +
+                       std::to_string(record->id) + ", " +
+                       std::to_string(record->group_id) + ", " +
+                       std::to_string(record->sender_id) + ", " +
+                       std::to_string(record->message_type) + ", '" +
+                       conn->Escape(record->content) + "', " +
+                       std::to_string(record->seq_id) + ", " +
+                       std::to_string(record->create_time) + ")";
+
+    bool ok = conn->Execute(query);
+
+    if (ok) {
+        mysql_pool_->MarkWrite(record->sender_id);
+    }
+    return ok;
+}
+
+bool MySQLMessageStore::QuerySingle(int64_t reader_id, int64_t conversation_id, int64_t before_id,
+                                    int64_t start_time, int limit, std::vector<MessageRecord>* out,
+                                    bool* current) {
+    std::vector<std::string> tables;
+    if (config_.partitioned) {
+        int64_t newest_ms = TimeUtil::GetCurrentTimestampMs();
+        if (before_id > 0) {
+            newest_ms = std::min(newest_ms, IdGenerator::TimestampMs(before_id));
+        }
+        if (start_time > 0) {
+            newest_ms = std::min(newest_ms, start_time * 1000);
+        }
+        tables = PlanPartitions(ShardOf(conversation_id), MonthOf(newest_ms));
+    } else {
+        tables.push_back(kBaseTable);
+    }
+
+    bool replica = false;
+    auto conn = mysql_pool_->GetConnection(QueryIntent::kRead, reader_id, &replica);
+    if (!conn) return false;
+
+    bool ok = QueryPartitions(conn.get(), tables, conversation_id, before_id, start_time, limit, out);
+    conn.Release();
+
+    if (!ok && replica) {
+        // A replica may not have replicated a freshly created partition yet.
+        conn = mysql_pool_->GetConnection(QueryIntent::kWrite);
+        if (!conn) return false;
+
+        replica = false;
+        ok = QueryPartitions(conn.get(), tables, conversation_id, before_id, start_time, limit, out);
+    }
+
+    *current = !replica;
+    return ok;
+}
+
+bool MySQLMessageStore::QueryPartitions(MySQLConnection* conn, const std::vector<std::string>& tables,
+                                        int64_t conversation_id, int64_t before_id, int64_t start_time,
+                                        int limit, std::vector<MessageRecord>* out) {
+    out->clear();
+
+    for (const auto& table : tables) {
+        std::vector<MessageRecord> page;
+        int remaining = limit - static_cast<int>(out->size());
+        if (!QueryTable(conn, table, conversation_id, before_id, start_time, remaining, &page)) {
+            return false;
+        }
+
+        // Partitions cover disjoint, descending id ranges, so appending
+        // keeps the merged page ordered.
+        for (auto& record : page) {
+            out->push_back(std::move(record));
+        }
+        if (static_cast<int>(out->size()) >= limit) break;
+    }
+
+    return true;
+}
+
+bool MySQLMessageStore::QueryTable(MySQLConnection* conn, const std::string& table,
+                                   int64_t conversation_id, int64_t before_id, int64_t start_time,
+                                   int limit, std::vector<MessageRecord>* out) {
+    // Keyset page over idx_conversation(conversation_id, id, create_time):
+    // the inner select is resolved from the index alone, only the page rows
+    // are looked up in the clustered index.
+    std::string page = "SELECT id FROM " + table + " FORCE INDEX (idx_conversation) "
+                      "WHERE conversation_id = " +
+                      std::to_string(static_cast<uint64_t>(conversation_id));
+    if (before_id > 0) {
+        page += " AND id < " + std::to_string(before_id);
+    }
+    if (start_time > 0) {
+        page += " AND create_time <= " + std::to_string(start_time);
+    }
+    page += " ORDER BY id DESC LIMIT " + std::to_string(limit);
+
+    std::string query = "SELECT m.id, m.conversation_id, m.sender_id, m.receiver_id, m.message_type, "
+                       "m.content, m.status, m.create_time FROM " + table + " m "
+                       "JOIN (" + page + ") p ON m.id = p.id ORDER BY m.id DESC";
+
+    auto result = conn->Query(query);
+    if (!result) return false;
+
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        MessageRecord record;
+        record.id = std::stoll(row[0]);
+        record.conversation_id = static_cast<int64_t>(std::stoull(row[1]));
+        record.sender_id = std::stoll(row[2]);
+        record.receiver_id = std::stoll(row[3]);
+        record.message_type = std::stoi(row[4]);
+        record.content = row[5] ? row[5] : "";
+        record.status = row[6] ? std::stoi(row[6]) : 0;
+        record.create_time = std::stoll(row[7]);
+        out->push_back(std::move(record));
+    }
+
+    return true;
+}
+
+bool MySQLMessageStore::IsGroupMember(int64_t group_id, int64_t user_id, bool* member) {
+    *member = false;
+
+    std::string query = "SELECT 1 FROM im_group_member WHERE group_id = " + std::to_string(group_id) +
+                       " AND user_id = " + std::to_string(user_id) + " LIMIT 1";
+
+    // A replica may not have the membership yet; only its "yes" is trusted.
+    bool replica = false;
+    auto conn = mysql_pool_->GetConnection(QueryIntent::kRead, user_id, &replica);
+    if (!conn) return false;
+
+    auto result = conn->Query(query);
+    MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+
+    if (!row && replica) {
+        conn.Release();
+        conn = mysql_pool_->GetConnection(QueryIntent::kWrite);
+        if (!conn) return false;
+
+        result = conn->Query(query);
+        row = result ? mysql_fetch_row(result.get()) : nullptr;
+    }
+
+    if (!result) return false;
+    *member = row != nullptr;
+    return true;
+}
+
+bool MySQLMessageStore::SaveReadReceipts(const std::vector<ReadReceiptRecord>& receipts) {
+    auto conn = mysql_pool_->GetConnection();
+    if (!conn) return false;
+
+    for (size_t begin = 0; begin < receipts.size(); begin += kReceiptRowsPerStatement) {
+        size_t end = std::min(receipts.size(), begin + kReceiptRowsPerStatement);
+
+        std::string query = "INSERT INTO im_message_read (user_id, peer_id, last_read_message_id, "
+                           "last_read_time) VALUES ";
+        for (size_t i = begin; i < end; i++) {
+            const ReadReceiptRecord& receipt = receipts[i];
+            if (i > begin) query += ", ";
+            query += "(" + std::to_string(receipt.user_id) + ", " +
+                     std::to_string(receipt.peer_id) + ", " +
+                     std::to_string(receipt.last_read_message_id) + ", " +
+                     std::to_string(receipt.read_time) + ")";
+        }
+        query += " ON DUPLICATE KEY UPDATE "
+                 "last_read_time = IF(VALUES(last_read_message_id) > last_read_message_id, "
+                 "VALUES(last_read_time), last_read_time), "
+                 "last_read_message_id = GREATEST(last_read_message_id, VALUES(last_read_message_id))";
+
+        if (!conn->Execute(query)) return false;
+    }
+
+    return true;
+}
+
+} // namespace ourchat
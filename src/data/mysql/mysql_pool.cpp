@@ -1,5 +1,8 @@
 #include "../../../include/data/mysql_pool.h"
 #include "../../../include/common/logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 namespace ourchat {
 
@@ -11,19 +14,42 @@ std::shared_ptr<MySQLPool> MySQLPool::Instance() {
 bool MySQLPool::Init(const DatabaseConfig& config) {
     config_ = config;
     running_ = true;
-    
-    for (int i = 0; i < config.pool_size; i++) {
-        CreateConnection();
+
+    AddEndpoint(config.host, config.port, config.pool_size);
+    for (const auto& replica_config : config.replicas) {
+        AddEndpoint(replica_config.host, replica_config.port, config.replica_pool_size);
+    }
+
+    for (auto& endpoint : endpoints_) {
+        size_t created = endpoint->pool->Init();
+        if (created < endpoint->pool->Capacity()) {
+            LOG_ERROR("MySQL pool " + endpoint->pool->Name() + " opened " + std::to_string(created) +
+                      " of " + std::to_string(endpoint->pool->Capacity()) + " connections");
+        }
+        endpoint->healthy = created > 0;
     }
-    
+
+    CheckReplicaLag();
+
     monitor_thread_ = std::thread([this]() {
+        int ticks = 0;
         while (running_) {
-            std::this_thread::sleep_for(std::chrono::seconds(30));
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (!running_) break;
+
+            ticks++;
             CheckConnections();
+            if (ticks % 5 == 0) {
+                CheckReplicaLag();
+            }
+            if (ticks % 30 == 0) {
+                PruneWriters();
+            }
         }
     });
-    
-    LOG_INFO("MySQL pool initialized with " + std::to_string(config_.pool_size) + " connections");
+
+    LOG_INFO("MySQL pool initialized with " + std::to_string(config_.pool_size) + " connections and " +
+             std::to_string(config_.replicas.size()) + " replicas");
     return true;
 }
 
@@ -31,98 +57,216 @@ MySQLPool::~MySQLPool() {
     Close();
 }
 
-std::unique_ptr<MySQLConnection> MySQLPool::GetConnection() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    
-    cv_.wait(lock, [this]() {
-        return !connections_.empty() || !running_;
-    });
-    
-    if (!running_) return nullptr;
-    
-    auto connection = std::move(connections_.front());
-    connections_.pop();
-    active_count_++;
-    
-    return connection;
+void MySQLPool::AddEndpoint(const std::string& host, int port, int pool_size) {
+    auto endpoint = std::make_unique<Endpoint>();
+    endpoint->host = host;
+    endpoint->port = port;
+
+    Endpoint* raw = endpoint.get();
+    ConnectionPool<MySQLConnection>::Options options;
+    // An empty pool would fail every borrower.
+    options.size = static_cast<size_t>(std::max(pool_size, 1));
+    options.validate_after = kValidateAfterIdle;
+    options.is_usable = [](MySQLConnection& connection) { return !connection.IsBroken(); };
+    options.validate = [](MySQLConnection& connection) { return connection.Ping(); };
+
+    endpoint->pool = std::make_unique<ConnectionPool<MySQLConnection>>(
+        "mysql " + host + ":" + std::to_string(port),
+        [this, raw]() { return CreateConnection(*raw); },
+        options);
+    endpoints_.push_back(std::move(endpoint));
+}
+
+MySQLLease MySQLPool::GetConnection(QueryIntent intent, int64_t user_id, bool* replica) {
+    if (intent == QueryIntent::kRead && endpoints_.size() > 1 &&
+        !(user_id > 0 && RecentlyWrote(user_id))) {
+        size_t index = 0;
+        if (PickReplica(&index)) {
+            auto connection = Acquire(index, true);
+            if (connection) {
+                if (replica) *replica = true;
+                return connection;
+            }
+        }
+    }
+
+    if (replica) *replica = false;
+    return Acquire(kPrimary, true);
+}
+
+MySQLPool::Endpoint* MySQLPool::PickReplica(size_t* index) {
+    size_t replica_count = endpoints_.size() - 1;
+    size_t start = next_replica_.fetch_add(1, std::memory_order_relaxed);
+    Endpoint* fallback = nullptr;
+
+    for (size_t i = 0; i < replica_count; i++) {
+        size_t candidate = 1 + (start + i) % replica_count;
+        Endpoint* endpoint = endpoints_[candidate].get();
+
+        int lag = endpoint->lag_seconds.load(std::memory_order_relaxed);
+        if (!endpoint->healthy.load(std::memory_order_relaxed) || lag < 0 ||
+            lag > config_.replica_max_lag) {
+            continue;
+        }
+
+        if (endpoint->pool->Idle() > 0) {
+            *index = candidate;
+            return endpoint;
+        }
+        if (!fallback && endpoint->pool->Live() > 0) {
+            // Busy but alive: wait here if no other replica has an idle connection.
+            fallback = endpoint;
+            *index = candidate;
+        }
+    }
+
+    return fallback;
+}
+
+MySQLLease MySQLPool::Acquire(size_t index, bool wait) {
+    if (index >= endpoints_.size() || !running_) return MySQLLease();
+    return endpoints_[index]->pool->Borrow(wait);
 }
 
-void MySQLPool::ReturnConnection(std::unique_ptr<MySQLConnection> connection) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (connection->Ping()) {
-        connections_.push(std::move(connection));
+void MySQLPool::MarkWrite(int64_t user_id) {
+    if (user_id <= 0 || endpoints_.size() <= 1) return;
+
+    WriterShard& shard = writers_[static_cast<uint64_t>(user_id) % kWriterShardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.last_write[user_id] = Clock::now();
+}
+
+bool MySQLPool::HasReplicas() const {
+    return endpoints_.size() > 1;
+}
+
+bool MySQLPool::RecentlyWrote(int64_t user_id) {
+    WriterShard& shard = writers_[static_cast<uint64_t>(user_id) % kWriterShardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.last_write.find(user_id);
+    if (it == shard.last_write.end()) return false;
+
+    return Clock::now() - it->second < std::chrono::seconds(config_.read_your_writes_window);
+}
+
+void MySQLPool::PruneWriters() {
+    auto cutoff = Clock::now() - std::chrono::seconds(config_.read_your_writes_window);
+
+    for (auto& shard : writers_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.last_write.begin(); it != shard.last_write.end();) {
+            if (it->second < cutoff) {
+                it = shard.last_write.erase(it);
+            } else {
+                ++it;
+            }
+        }
     }
-    
-    active_count_--;
-    cv_.notify_one();
 }
 
 void MySQLPool::Close() {
     running_ = false;
-    cv_.notify_all();
-    
+    for (auto& endpoint : endpoints_) {
+        endpoint->pool->Close();
+    }
+
     if (monitor_thread_.joinable()) {
         monitor_thread_.join();
     }
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    while (!connections_.empty()) {
-        connections_.pop();
-    }
 }
 
-void MySQLPool::CreateConnection() {
+std::unique_ptr<MySQLConnection> MySQLPool::CreateConnection(const Endpoint& endpoint) {
     auto connection = std::make_unique<MySQLConnection>();
-    
-    if (connection->Connect(config_.host, config_.port,
-                           config_.username, config_.password,
-                           config_.database)) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        connections_.push(std::move(connection));
-    } else {
-        LOG_ERROR("Failed to create MySQL connection");
+    if (!connection->Connect(endpoint.host, endpoint.port,
+                             config_.username, config_.password,
+                             config_.database)) {
+        LOG_ERROR("Failed to create MySQL connection to " + endpoint.host + ":" +
+                  std::to_string(endpoint.port));
+        return nullptr;
     }
+    return connection;
 }
 
 void MySQLPool::CheckConnections() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::queue<std::unique_ptr<MySQLConnection>> new_connections;
-    
-    while (!connections_.empty()) {
-        auto connection = std::move(connections_.front());
-        connections_.pop();
-        
-        if (connection->Ping()) {
-            new_connections.push(std::move(connection));
-        } else {
-            LOG_WARN("Reconnecting to MySQL");
-            auto new_conn = std::make_unique<MySQLConnection>();
-            if (new_conn->Connect(config_.host, config_.port,
-                                 config_.username, config_.password,
-                                 config_.database)) {
-                new_connections.push(std::move(new_conn));
+    for (size_t index = 0; index < endpoints_.size(); index++) {
+        Endpoint& endpoint = *endpoints_[index];
+        // Pings only connections idle past kValidateAfterIdle and reconnects
+        // with backoff, all without blocking borrowers.
+        endpoint.pool->Maintain();
+
+        bool healthy = endpoint.pool->Live() > 0;
+        if (endpoint.healthy.exchange(healthy) != healthy) {
+            if (healthy) {
+                LOG_INFO("MySQL endpoint " + endpoint.pool->Name() + " is reachable again");
+            } else {
+                LOG_WARN("MySQL endpoint " + endpoint.pool->Name() + " has no live connections");
+            }
+        }
+    }
+}
+
+void MySQLPool::CheckReplicaLag() {
+    for (size_t index = 1; index < endpoints_.size(); index++) {
+        Endpoint& endpoint = *endpoints_[index];
+
+        auto connection = Acquire(index, false);
+        if (!connection) continue;
+
+        int lag = -1;
+        auto result = connection->Query("SHOW SLAVE STATUS");
+        if (result) {
+            MYSQL_ROW row = mysql_fetch_row(result.get());
+            MYSQL_FIELD* fields = mysql_fetch_fields(result.get());
+            unsigned int field_count = mysql_num_fields(result.get());
+            for (unsigned int i = 0; row && i < field_count; i++) {
+                if (strcmp(fields[i].name, "Seconds_Behind_Master") == 0 ||
+                    strcmp(fields[i].name, "Seconds_Behind_Source") == 0) {
+                    // NULL means replication is stopped or broken.
+                    lag = row[i] ? std::atoi(row[i]) : -1;
+                    break;
+                }
             }
         }
+
+        int previous = endpoint.lag_seconds.exchange(lag);
+        if ((lag < 0 || lag > config_.replica_max_lag) &&
+            previous >= 0 && previous <= config_.replica_max_lag) {
+            LOG_WARN("MySQL replica " + endpoint.host + " excluded from reads, lag: " +
+                     std::to_string(lag));
+        }
+    }
+}
+
+void MySQLPool::Resize(int pool_size, int replica_pool_size) {
+    for (size_t i = 0; i < endpoints_.size(); i++) {
+        int size = i == 0 ? pool_size : replica_pool_size;
+        endpoints_[i]->pool->Resize(static_cast<size_t>(std::max(size, 1)));
     }
-    
-    connections_ = std::move(new_connections);
 }
 
 int MySQLPool::GetPoolSize() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return connections_.size() + active_count_;
+    size_t total = 0;
+    for (auto& endpoint : endpoints_) {
+        total += endpoint->pool->Live();
+    }
+    return static_cast<int>(total);
 }
 
 int MySQLPool::GetActiveConnections() {
-    return active_count_;
+    size_t total = 0;
+    for (auto& endpoint : endpoints_) {
+        total += endpoint->pool->InUse();
+    }
+    return static_cast<int>(total);
 }
 
 int MySQLPool::GetIdleConnections() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return connections_.size();
+    size_t total = 0;
+    for (auto& endpoint : endpoints_) {
+        total += endpoint->pool->Idle();
+    }
+    return static_cast<int>(total);
 }
 
 } // namespace ourchat
@@ -0,0 +1,68 @@
+#include "../../../include/data/mysql_user_store.h"
+#include "../../../include/common/time_util.h"
+
+namespace ourchat {
+
+MySQLUserStore::MySQLUserStore() : mysql_pool_(MySQLPool::Instance()) {}
+
+bool MySQLUserStore::Create(UserRecord* record) {
+    auto conn = mysql_pool_->GetConnection();
+    if (!conn) return false;
+
+    std::string now = std::to_string(TimeUtil::GetCurrentTimestamp());
+    std::string query = "INSERT INTO im_user (username, password_hash, email, create_time, update_time) "
+                       "VALUES ('" + conn->Escape(record->username) + "', '" +
+                       conn->Escape(record->password_hash) + "', '" +
+                       conn->Escape(record->email) + "', " + now + ", " + now + ")";
+
+    int64_t insert_id = 0;
+    if (!conn->Execute(query, insert_id)) return false;
+
+    record->id = insert_id;
+    return true;
+}
+
+bool MySQLUserStore::FindByUsername(const std::string& username, UserRecord* out, bool* found) {
+    *found = false;
+
+    auto conn = mysql_pool_->GetConnection(QueryIntent::kRead);
+    if (!conn) return false;
+
+    std::string query = "SELECT id, password_hash, email FROM im_user WHERE username = '" +
+                       conn->Escape(username) + "'";
+    auto result = conn->Query(query);
+    MYSQL_ROW row = result ? mysql_fetch_row(result.get()) : nullptr;
+
+    if (!row && mysql_pool_->HasReplicas()) {
+        conn.Release();
+        conn = mysql_pool_->GetConnection(QueryIntent::kWrite);
+        if (!conn) return false;
+
+        result = conn->Query(query);
+        row = result ? mysql_fetch_row(result.get()) : nullptr;
+    }
+
+    if (!result) return false;
+    if (!row) return true;
+
+    out->id = std::stoll(row[0]);
+    out->username = username;
+    out->password_hash = row[1] ? row[1] : "";
+    out->email = row[2] ? row[2] : "";
+    *found = true;
+    return true;
+}
+
+bool MySQLUserStore::UpdatePasswordHash(int64_t user_id, const std::string& old_hash,
+                                        const std::string& new_hash) {
+    auto conn = mysql_pool_->GetConnection();
+    if (!conn) return false;
+
+    std::string query = "UPDATE im_user SET password_hash = '" + conn->Escape(new_hash) +
+                       "', update_time = " + std::to_string(TimeUtil::GetCurrentTimestamp()) +
+                       " WHERE id = " + std::to_string(user_id) +
+                       " AND password_hash = '" + conn->Escape(old_hash) + "'";
+    return conn->Execute(query);
+}
+
+} // namespace ourchat
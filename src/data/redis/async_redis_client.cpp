@@ -0,0 +1,422 @@
+#include "../../../include/data/async_redis_client.h"
+#include "../../../include/common/logger.h"
+#include <algorithm>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace ourchat {
+
+RedisValue RedisValue::From(const redisReply* reply) {
+    if (!reply) return Error("no reply from Redis");
+
+    RedisValue value;
+    value.type = reply->type;
+    value.integer = reply->integer;
+    if (reply->str) {
+        value.str.assign(reply->str, reply->len);
+    }
+    value.elements.reserve(reply->elements);
+    for (size_t i = 0; i < reply->elements; i++) {
+        value.elements.push_back(From(reply->element[i]));
+    }
+    return value;
+}
+
+RedisValue RedisValue::Error(const std::string& message) {
+    RedisValue value;
+    value.type = REDIS_REPLY_ERROR;
+    value.str = message;
+    return value;
+}
+
+std::shared_ptr<AsyncRedisClient> AsyncRedisClient::Instance() {
+    static std::shared_ptr<AsyncRedisClient> instance(new AsyncRedisClient());
+    return instance;
+}
+
+AsyncRedisClient::~AsyncRedisClient() {
+    Stop();
+}
+
+bool AsyncRedisClient::Start(const RedisConfig& config) {
+    if (running_) return true;
+    config_ = config;
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || event_fd_ < 0) {
+        LOG_ERROR("Failed to create the async Redis event loop");
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (event_fd_ >= 0) close(event_fd_);
+        epoll_fd_ = event_fd_ = -1;
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &event);
+
+    connections_.clear();
+    for (int i = 0; i < std::max(config.async_connections, 1); i++) {
+        auto connection = std::make_unique<Connection>();
+        connection->owner = this;
+        connection->backoff = kMinBackoff;
+        connections_.push_back(std::move(connection));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        accepting_ = true;
+    }
+
+    running_ = true;
+    loop_thread_ = std::thread(&AsyncRedisClient::Loop, this);
+
+    LOG_INFO("Async Redis client started with " + std::to_string(connections_.size()) + " connections");
+    return true;
+}
+
+bool AsyncRedisClient::Drain(std::chrono::milliseconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    while (running_ && Pending() > 0) {
+        if (Clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void AsyncRedisClient::Stop() {
+    if (!running_.exchange(false)) return;
+
+    Wake();
+    if (loop_thread_.joinable()) {
+        loop_thread_.join();
+    }
+
+    close(epoll_fd_);
+    close(event_fd_);
+    epoll_fd_ = event_fd_ = -1;
+}
+
+bool AsyncRedisClient::Execute(std::vector<std::string> args, Callback callback) {
+    if (args.empty()) return false;
+
+    if (pending_.fetch_add(1) >= static_cast<size_t>(std::max(config_.async_max_pending, 1))) {
+        pending_.fetch_sub(1);
+        return false;
+    }
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (!accepting_) {
+            pending_.fetch_sub(1);
+            return false;
+        }
+        queue_.push_back(Request{std::move(args), std::move(callback)});
+        // The loop drains the whole queue per wakeup, so only the first
+        // command of a batch needs to signal it.
+        wake = queue_.size() == 1;
+    }
+
+    if (wake) Wake();
+    return true;
+}
+
+std::future<RedisValue> AsyncRedisClient::Execute(std::vector<std::string> args) {
+    auto promise = std::make_shared<std::promise<RedisValue>>();
+    auto future = promise->get_future();
+
+    bool queued = Execute(std::move(args), [promise](const redisReply* reply) {
+        promise->set_value(RedisValue::From(reply));
+    });
+    if (!queued) {
+        promise->set_value(RedisValue::Error("async Redis client is stopped or overloaded"));
+    }
+    return future;
+}
+
+bool AsyncRedisClient::EvalScript(const RedisScript& script, const std::vector<std::string>& keys,
+                                  const std::vector<std::string>& args, Callback callback) {
+    auto command = std::make_shared<std::vector<std::string>>();
+    command->reserve(3 + keys.size() + args.size());
+    command->push_back("EVALSHA");
+    command->push_back(script.Sha1());
+    command->push_back(std::to_string(keys.size()));
+    command->insert(command->end(), keys.begin(), keys.end());
+    command->insert(command->end(), args.begin(), args.end());
+
+    auto on_reply = [this, &script, command, callback](const redisReply* reply) {
+        bool noscript = reply && reply->type == REDIS_REPLY_ERROR &&
+                        std::string_view(reply->str, reply->len).rfind("NOSCRIPT", 0) == 0;
+        if (!noscript) {
+            if (callback) callback(reply);
+            return;
+        }
+
+        // The server lost the script (SCRIPT FLUSH, restart, failover);
+        // EVAL caches it again.
+        (*command)[0] = "EVAL";
+        (*command)[1] = script.Source();
+        if (!Execute(std::move(*command), callback) && callback) {
+            callback(nullptr);
+        }
+    };
+    return Execute(*command, std::move(on_reply));
+}
+
+void AsyncRedisClient::Wake() {
+    uint64_t one = 1;
+    ssize_t written = write(event_fd_, &one, sizeof(one));
+    (void)written;
+}
+
+void AsyncRedisClient::Loop() {
+    epoll_event events[64];
+
+    while (running_) {
+        auto now = Clock::now();
+        for (auto& connection : connections_) {
+            if (!connection->context && now >= connection->retry_at) {
+                Connect(connection.get());
+            }
+        }
+
+        int count = epoll_wait(epoll_fd_, events, 64, 100);
+        for (int i = 0; i < count; i++) {
+            auto* connection = static_cast<Connection*>(events[i].data.ptr);
+            if (!connection) {
+                uint64_t value = 0;
+                ssize_t bytes = read(event_fd_, &value, sizeof(value));
+                (void)bytes;
+                continue;
+            }
+
+            // Reading may free the context on EOF, so look it up again
+            // before writing.
+            redisAsyncContext* context = connection->context;
+            if (!context) continue;
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                redisAsyncHandleRead(context);
+            }
+            if ((events[i].events & EPOLLOUT) && connection->context == context) {
+                redisAsyncHandleWrite(context);
+            }
+        }
+
+        Dispatch();
+    }
+
+    // Commands already sent get a null reply from hiredis; queued ones are
+    // failed below.
+    for (auto& connection : connections_) {
+        if (connection->context) {
+            redisAsyncFree(connection->context);
+            connection->context = nullptr;
+        }
+    }
+
+    std::vector<Request> remaining;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        accepting_ = false;
+        remaining.swap(queue_);
+    }
+    for (auto& request : remaining) {
+        Fail(&request);
+    }
+}
+
+void AsyncRedisClient::Dispatch() {
+    std::vector<Request> batch;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        batch.swap(queue_);
+    }
+
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+
+    for (auto& request : batch) {
+        // Prefer connected contexts; one still connecting buffers the
+        // command until the handshake completes.
+        Connection* target = nullptr;
+        for (size_t i = 0; i < connections_.size(); i++) {
+            Connection* candidate = connections_[next_connection_++ % connections_.size()].get();
+            if (candidate->ready) {
+                target = candidate;
+                break;
+            }
+            if (!target && candidate->context) {
+                target = candidate;
+            }
+        }
+
+        if (!target) {
+            Fail(&request);
+            continue;
+        }
+
+        argv.clear();
+        argvlen.clear();
+        for (const auto& arg : request.args) {
+            argv.push_back(arg.data());
+            argvlen.push_back(arg.size());
+        }
+
+        auto* callback = new Callback(std::move(request.callback));
+        if (redisAsyncCommandArgv(target->context, &AsyncRedisClient::OnReply, callback,
+                                  static_cast<int>(argv.size()), argv.data(), argvlen.data()) != REDIS_OK) {
+            request.callback = std::move(*callback);
+            delete callback;
+            Fail(&request);
+        }
+    }
+}
+
+void AsyncRedisClient::Fail(Request* request) {
+    if (request->callback) {
+        request->callback(nullptr);
+    }
+    pending_.fetch_sub(1);
+}
+
+void AsyncRedisClient::Connect(Connection* connection) {
+    redisAsyncContext* context = redisAsyncConnect(config_.host.c_str(), config_.port);
+    if (!context || context->err) {
+        LOG_ERROR("Async Redis connection failed: " +
+                  std::string(context ? context->errstr : "allocation failed"));
+        if (context) redisAsyncFree(context);
+        ScheduleRetry(connection);
+        return;
+    }
+
+    connection->context = context;
+    connection->fd = context->c.fd;
+    connection->events = 0;
+    connection->registered = false;
+    connection->ready = false;
+
+    context->data = connection;
+    context->ev.data = connection;
+    context->ev.addRead = &AsyncRedisClient::AddRead;
+    context->ev.delRead = &AsyncRedisClient::DelRead;
+    context->ev.addWrite = &AsyncRedisClient::AddWrite;
+    context->ev.delWrite = &AsyncRedisClient::DelWrite;
+    context->ev.cleanup = &AsyncRedisClient::Cleanup;
+
+    redisAsyncSetConnectCallback(context, &AsyncRedisClient::OnConnect);
+    redisAsyncSetDisconnectCallback(context, &AsyncRedisClient::OnDisconnect);
+
+    // Queued ahead of every caller's command on this connection.
+    if (!config_.password.empty()) {
+        const char* argv[] = {"AUTH", config_.password.c_str()};
+        size_t argvlen[] = {4, config_.password.size()};
+        redisAsyncCommandArgv(context, nullptr, nullptr, 2, argv, argvlen);
+    }
+    if (config_.db != 0) {
+        std::string db = std::to_string(config_.db);
+        const char* argv[] = {"SELECT", db.c_str()};
+        size_t argvlen[] = {6, db.size()};
+        redisAsyncCommandArgv(context, nullptr, nullptr, 2, argv, argvlen);
+    }
+    for (const RedisScript* script : RedisScript::All()) {
+        const char* argv[] = {"SCRIPT", "LOAD", script->Source().c_str()};
+        size_t argvlen[] = {6, 4, script->Source().size()};
+        redisAsyncCommandArgv(context, nullptr, nullptr, 3, argv, argvlen);
+    }
+
+    // A non-blocking connect completes when the socket turns writable.
+    AddWrite(connection);
+}
+
+void AsyncRedisClient::ScheduleRetry(Connection* connection) {
+    connection->context = nullptr;
+    connection->ready = false;
+    connection->retry_at = Clock::now() + connection->backoff;
+    connection->backoff = std::min(connection->backoff * 2, kMaxBackoff);
+}
+
+void AsyncRedisClient::OnConnect(const redisAsyncContext* context, int status) {
+    auto* connection = static_cast<Connection*>(context->data);
+    if (status != REDIS_OK) {
+        // hiredis frees the context after this callback returns.
+        LOG_WARN("Async Redis connect failed: " + std::string(context->errstr ? context->errstr : ""));
+        connection->owner->ScheduleRetry(connection);
+        return;
+    }
+
+    connection->ready = true;
+    connection->backoff = kMinBackoff;
+    LOG_INFO("Async Redis connected to " + connection->owner->config_.host + ":" +
+             std::to_string(connection->owner->config_.port));
+}
+
+void AsyncRedisClient::OnDisconnect(const redisAsyncContext* context, int status) {
+    auto* connection = static_cast<Connection*>(context->data);
+    if (connection->owner->running_ && status != REDIS_OK) {
+        LOG_WARN("Async Redis connection lost: " + std::string(context->errstr ? context->errstr : ""));
+    }
+    connection->owner->ScheduleRetry(connection);
+}
+
+void AsyncRedisClient::OnReply(redisAsyncContext* context, void* reply, void* privdata) {
+    auto* connection = static_cast<Connection*>(context->data);
+    std::unique_ptr<Callback> callback(static_cast<Callback*>(privdata));
+
+    if (*callback) {
+        (*callback)(static_cast<const redisReply*>(reply));
+    }
+    connection->owner->pending_.fetch_sub(1);
+}
+
+void AsyncRedisClient::AddRead(void* privdata) {
+    auto* connection = static_cast<Connection*>(privdata);
+    connection->owner->UpdateEvents(connection, connection->events | EPOLLIN);
+}
+
+void AsyncRedisClient::DelRead(void* privdata) {
+    auto* connection = static_cast<Connection*>(privdata);
+    connection->owner->UpdateEvents(connection, connection->events & ~EPOLLIN);
+}
+
+void AsyncRedisClient::AddWrite(void* privdata) {
+    auto* connection = static_cast<Connection*>(privdata);
+    connection->owner->UpdateEvents(connection, connection->events | EPOLLOUT);
+}
+
+void AsyncRedisClient::DelWrite(void* privdata) {
+    auto* connection = static_cast<Connection*>(privdata);
+    connection->owner->UpdateEvents(connection, connection->events & ~EPOLLOUT);
+}
+
+void AsyncRedisClient::Cleanup(void* privdata) {
+    auto* connection = static_cast<Connection*>(privdata);
+    connection->owner->UpdateEvents(connection, 0);
+}
+
+void AsyncRedisClient::UpdateEvents(Connection* connection, uint32_t events) {
+    if (events == connection->events && connection->registered == (events != 0)) return;
+
+    epoll_event event{};
+    event.events = events;
+    event.data.ptr = connection;
+
+    if (events == 0) {
+        if (connection->registered) {
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection->fd, &event);
+        }
+        connection->registered = false;
+    } else if (connection->registered) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection->fd, &event);
+    } else {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, connection->fd, &event);
+        connection->registered = true;
+    }
+    connection->events = events;
+}
+
+} // namespace ourchat
@@ -0,0 +1,268 @@
+#include "../../../include/data/near_cache.h"
+#include "../../../include/data/redis_pool.h"
+#include "../../../include/common/logger.h"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace ourchat {
+
+namespace {
+
+const char kInvalidationChannel[] = "__redis__:invalidate";
+
+// List node, index slot and string headers, on top of key and value bytes.
+constexpr size_t kEntryOverhead = 128;
+
+constexpr int kMinBackoffMs = 100;
+constexpr int kMaxBackoffMs = 5000;
+
+// Tracking belongs to the tracker connection; it is pinged so a dead one is
+// noticed even while no invalidations arrive.
+constexpr std::chrono::seconds kPingInterval{5};
+
+size_t EntrySize(const std::string& key, const std::string& value) {
+    return key.size() + value.size() + kEntryOverhead;
+}
+
+} // namespace
+
+std::shared_ptr<NearCache> NearCache::Instance() {
+    static std::shared_ptr<NearCache> instance(new NearCache());
+    return instance;
+}
+
+NearCache::~NearCache() {
+    Stop();
+}
+
+bool NearCache::Start(const RedisConfig& redis_config, const NearCacheConfig& config) {
+    if (redis_config.cluster) {
+        // Invalidations are per node; tracking a cluster would need a
+        // subscriber on every master.
+        LOG_WARN("Near cache is not supported with Redis Cluster, disabled");
+        return false;
+    }
+    if (running_.exchange(true)) return true;
+
+    redis_config_ = redis_config;
+    config_ = config;
+    shard_max_entries_ = std::max<size_t>(static_cast<size_t>(std::max(config.max_entries, 0)) / kShardCount, 1);
+    shard_max_bytes_ = static_cast<size_t>(std::max(config.max_memory_mb, 1)) * 1024 * 1024 / kShardCount;
+
+    tracking_thread_ = std::thread([this]() { Run(); });
+    return true;
+}
+
+void NearCache::Stop() {
+    if (!running_.exchange(false)) return;
+
+    wait_cv_.notify_all();
+    if (tracking_thread_.joinable()) {
+        tracking_thread_.join();
+    }
+}
+
+NearCache::Shard& NearCache::GetShard(std::string_view key) {
+    return shards_[std::hash<std::string_view>()(key) % kShardCount];
+}
+
+bool NearCache::Tracked(std::string_view key) const {
+    if (config_.prefixes.empty()) return true;
+    for (const auto& prefix : config_.prefixes) {
+        if (key.rfind(prefix, 0) == 0) return true;
+    }
+    return false;
+}
+
+bool NearCache::Get(const std::string& key, std::string* value) {
+    bool cacheable = tracking_.load() && Tracked(key);
+    Shard& shard = GetShard(key);
+    uint64_t epoch = 0;
+
+    if (cacheable) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            auto entry = it->second;
+            if (Clock::now() < entry->expires) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                if (entry->exists) *value = entry->value;
+                return entry->exists;
+            }
+            Erase(shard, entry);
+        }
+        epoch = shard.epoch;
+        misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto redis_conn = RedisPool::Instance()->GetConnection(key);
+    if (!redis_conn) return false;
+
+    auto reply = redis_conn->Command({"GET", key});
+    redis_conn.Release();
+    if (!reply || (reply->type != REDIS_REPLY_STRING && reply->type != REDIS_REPLY_NIL)) {
+        return false;
+    }
+
+    bool exists = reply->type == REDIS_REPLY_STRING;
+    std::string fetched = exists ? std::string(reply->str, reply->len) : std::string();
+    if (cacheable) {
+        Insert(shard, epoch, key, fetched, exists);
+    }
+    if (exists) *value = std::move(fetched);
+    return exists;
+}
+
+void NearCache::Insert(Shard& shard, uint64_t epoch, const std::string& key, const std::string& value, bool exists) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // An invalidation (or a tracking reset) since the fetch started means
+    // the value may already be stale.
+    if (shard.epoch != epoch) return;
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        Erase(shard, it->second);
+    }
+
+    auto expires = Clock::now() + std::chrono::milliseconds(config_.ttl_ms);
+    shard.lru.push_front(Entry{key, value, exists, expires});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    shard.bytes += EntrySize(key, value);
+
+    while (!shard.lru.empty() &&
+           (shard.lru.size() > shard_max_entries_ || shard.bytes > shard_max_bytes_)) {
+        Erase(shard, std::prev(shard.lru.end()));
+    }
+}
+
+void NearCache::Erase(Shard& shard, std::list<Entry>::iterator it) {
+    shard.bytes -= EntrySize(it->key, it->value);
+    shard.index.erase(it->key);
+    shard.lru.erase(it);
+}
+
+void NearCache::Invalidate(std::string_view key) {
+    // Nothing is cached while tracking is down, and losing it clears the
+    // cache, so writes skip the shard lock.
+    if (!tracking_.load()) return;
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    shard.epoch++;
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        Erase(shard, it->second);
+    }
+}
+
+void NearCache::Clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.epoch++;
+        shard.index.clear();
+        shard.lru.clear();
+        shard.bytes = 0;
+    }
+}
+
+bool NearCache::Track(RedisClient* subscriber, RedisClient* tracker) {
+    if (!subscriber->Connect(redis_config_.host, redis_config_.port, redis_config_.password, redis_config_.db) ||
+        !tracker->Connect(redis_config_.host, redis_config_.port, redis_config_.password, redis_config_.db)) {
+        return false;
+    }
+
+    auto id = subscriber->Command({"CLIENT", "ID"});
+    if (!id || id->type != REDIS_REPLY_INTEGER || !subscriber->Subscribe(kInvalidationChannel)) {
+        return false;
+    }
+
+    // Broadcast mode: the server keeps no per-key state for this client and
+    // reports every write to a key under one of the prefixes.
+    std::vector<std::string> args = {"CLIENT", "TRACKING", "ON", "REDIRECT", std::to_string(id->integer), "BCAST"};
+    for (const auto& prefix : config_.prefixes) {
+        args.push_back("PREFIX");
+        args.push_back(prefix);
+    }
+
+    auto reply = tracker->Command(std::vector<std::string_view>(args.begin(), args.end()));
+    if (!reply || reply->type != REDIS_REPLY_STATUS) {
+        if (reply && reply->type == REDIS_REPLY_ERROR) {
+            LOG_ERROR("CLIENT TRACKING failed: " + std::string(reply->str, reply->len));
+        }
+        return false;
+    }
+    return true;
+}
+
+void NearCache::HandleInvalidation(const redisReply* reply) {
+    // ["message", "__redis__:invalidate", [key, ...]]; a nil payload means
+    // the whole dataset was flushed.
+    if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 3) return;
+
+    const redisReply* kind = reply->element[0];
+    if (kind->type != REDIS_REPLY_STRING || std::string_view(kind->str, kind->len) != "message") return;
+
+    const redisReply* keys = reply->element[2];
+    if (keys->type == REDIS_REPLY_ARRAY) {
+        for (size_t i = 0; i < keys->elements; i++) {
+            const redisReply* key = keys->element[i];
+            if (key->type == REDIS_REPLY_STRING) {
+                Invalidate(std::string_view(key->str, key->len));
+            }
+        }
+    } else if (keys->type == REDIS_REPLY_STRING) {
+        Invalidate(std::string_view(keys->str, keys->len));
+    } else {
+        Clear();
+    }
+}
+
+void NearCache::Backoff(int* delay_ms) {
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    wait_cv_.wait_for(lock, std::chrono::milliseconds(*delay_ms), [this]() { return !running_; });
+    *delay_ms = std::min(*delay_ms * 2, kMaxBackoffMs);
+}
+
+void NearCache::Run() {
+    int delay_ms = kMinBackoffMs;
+
+    while (running_) {
+        RedisClient subscriber;
+        RedisClient tracker;
+        if (!Track(&subscriber, &tracker)) {
+            LOG_WARN("Near cache cannot enable Redis tracking, retrying in " +
+                     std::to_string(delay_ms) + "ms");
+            Backoff(&delay_ms);
+            continue;
+        }
+        delay_ms = kMinBackoffMs;
+
+        tracking_ = true;
+        LOG_INFO("Near cache tracking " + std::to_string(config_.prefixes.size()) + " key prefixes");
+
+        auto next_ping = Clock::now() + kPingInterval;
+        while (running_) {
+            RedisReplyPtr reply;
+            int result = subscriber.WaitReply(500, &reply);
+            if (result < 0) break;
+            if (result > 0) HandleInvalidation(reply.get());
+
+            if (Clock::now() >= next_ping) {
+                if (!tracker.Ping()) break;
+                next_ping = Clock::now() + kPingInterval;
+            }
+        }
+
+        // Without invalidations nothing cached can be trusted.
+        tracking_ = false;
+        Clear();
+        if (running_) {
+            LOG_WARN("Near cache lost its invalidation stream, serving from Redis until it reconnects");
+        }
+    }
+}
+
+} // namespace ourchat
@@ -1,10 +1,46 @@
 #include "../../../include/data/redis_client.h"
 #include "../../../include/common/logger.h"
-#include <sstream>
+#include "../../../include/common/tracing.h"
+#include <cstdio>
 #include <cstring>
+#include <poll.h>
 
 namespace ourchat {
 
+namespace {
+
+std::string ToString(const redisReply* reply) {
+    return reply->str ? std::string(reply->str, reply->len) : std::string();
+}
+
+bool IsStatusOk(const RedisReplyPtr& reply) {
+    return reply && reply->type == REDIS_REPLY_STATUS && std::string_view(reply->str, reply->len) == "OK";
+}
+
+int64_t IntegerOr(const RedisReplyPtr& reply, int64_t fallback) {
+    return reply && reply->type == REDIS_REPLY_INTEGER ? reply->integer : fallback;
+}
+
+std::vector<std::string> ToStrings(const RedisReplyPtr& reply) {
+    std::vector<std::string> result;
+    if (!reply || reply->type != REDIS_REPLY_ARRAY) return result;
+    
+    result.reserve(reply->elements);
+    for (size_t i = 0; i < reply->elements; i++) {
+        result.push_back(ToString(reply->element[i]));
+    }
+    return result;
+}
+
+// Shortest round-trip text for a score; "inf"/"-inf" are valid ranges.
+std::string FormatScore(double score) {
+    char buffer[32];
+    int len = std::snprintf(buffer, sizeof(buffer), "%.17g", score);
+    return std::string(buffer, len);
+}
+
+} // namespace
+
 RedisClient::RedisClient() : context_(nullptr), connected_(false) {
 }
 
@@ -20,29 +56,23 @@ bool RedisClient::Connect(const std::string& host, int port, const std::string&
         if (context_) {
             LOG_ERROR("Redis connection error: " + std::string(context_->errstr));
             redisFree(context_);
+            context_ = nullptr;
         } else {
             LOG_ERROR("Redis connection failed: allocation failed");
         }
         return false;
     }
     
+    connected_ = true;
+    
     if (!password.empty()) {
-        auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                          "AUTH %s", password.c_str()));
-        if (reply) {
-            freeReplyObject(reply);
-        }
+        Command({"AUTH", password});
     }
     
     if (db != 0) {
-        auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                          "SELECT %d", db));
-        if (reply) {
-            freeReplyObject(reply);
-        }
+        Command({"SELECT", std::to_string(db)});
     }
     
-    connected_ = true;
     LOG_INFO("Connected to Redis at " + host + ":" + std::to_string(port));
     return true;
 }
@@ -59,354 +89,384 @@ bool RedisClient::IsConnected() {
     return connected_ && context_ && context_->err == 0;
 }
 
-bool RedisClient::Set(const std::string& key, const std::string& value) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "SET %s %s", key.c_str(), value.c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_STATUS && 
-                   strcmp(reply->str, "OK") == 0);
-    freeReplyObject(reply);
-    return success;
+bool RedisClient::Ping() {
+    auto reply = Command({"PING"});
+    return reply && reply->type == REDIS_REPLY_STATUS &&
+           std::string_view(reply->str, reply->len) == "PONG";
 }
 
-bool RedisClient::Setex(const std::string& key, int seconds, const std::string& value) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "SETEX %s %d %s", 
-                                                      key.c_str(), seconds, value.c_str()));
-    if (!reply) return false;
+RedisReplyPtr RedisClient::Command(std::initializer_list<std::string_view> args) {
+    constexpr size_t kStackArgs = 16;
+    if (args.size() > kStackArgs) {
+        return Command(std::vector<std::string_view>(args));
+    }
     
-    bool success = (reply->type == REDIS_REPLY_STATUS && 
-                   strcmp(reply->str, "OK") == 0);
-    freeReplyObject(reply);
-    return success;
+    const char* argv[kStackArgs];
+    size_t argvlen[kStackArgs];
+    int argc = 0;
+    for (std::string_view arg : args) {
+        argv[argc] = arg.data();
+        argvlen[argc] = arg.size();
+        argc++;
+    }
+    return CommandArgv(argc, argv, argvlen);
 }
 
-bool RedisClient::Setnx(const std::string& key, const std::string& value) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "SETNX %s %s", key.c_str(), value.c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER && reply->integer == 1);
-    freeReplyObject(reply);
-    return success;
+RedisReplyPtr RedisClient::Command(const std::vector<std::string_view>& args) {
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+    argv.reserve(args.size());
+    argvlen.reserve(args.size());
+    for (std::string_view arg : args) {
+        argv.push_back(arg.data());
+        argvlen.push_back(arg.size());
+    }
+    return CommandArgv(static_cast<int>(args.size()), argv.data(), argvlen.data());
 }
 
-std::string RedisClient::Get(const std::string& key) {
-    if (!IsConnected()) return "";
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "GET %s", key.c_str()));
-    if (!reply) return "";
-    
-    std::string result;
-    if (reply->type == REDIS_REPLY_STRING) {
-        result = reply->str;
+bool RedisClient::LoadScript(const RedisScript& script) {
+    auto reply = Command({"SCRIPT", "LOAD", script.Source()});
+    return reply && reply->type == REDIS_REPLY_STRING &&
+           std::string_view(reply->str, reply->len) == script.Sha1();
+}
+
+size_t RedisClient::LoadScripts() {
+    size_t loaded = 0;
+    for (const RedisScript* script : RedisScript::All()) {
+        if (LoadScript(*script)) loaded++;
     }
-    freeReplyObject(reply);
-    return result;
+    return loaded;
 }
 
-bool RedisClient::Del(const std::string& key) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "DEL %s", key.c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER);
-    freeReplyObject(reply);
-    return success;
+RedisReplyPtr RedisClient::EvalScript(const RedisScript& script,
+                                      const std::vector<std::string_view>& keys,
+                                      const std::vector<std::string_view>& args) {
+    std::string numkeys = std::to_string(keys.size());
+    std::vector<std::string_view> command;
+    command.reserve(3 + keys.size() + args.size());
+    command.push_back("EVALSHA");
+    command.push_back(script.Sha1());
+    command.push_back(numkeys);
+    command.insert(command.end(), keys.begin(), keys.end());
+    command.insert(command.end(), args.begin(), args.end());
+    
+    auto reply = Command(command);
+    if (reply && reply->type == REDIS_REPLY_ERROR &&
+        std::string_view(reply->str, reply->len).rfind("NOSCRIPT", 0) == 0) {
+        // EVAL also caches the script, so the next EVALSHA hits.
+        command[0] = "EVAL";
+        command[1] = script.Source();
+        reply = Command(command);
+    }
+    return reply;
 }
 
-bool RedisClient::Del(const std::vector<std::string>& keys) {
-    if (!IsConnected()) return false;
+RedisReplyPtr RedisClient::CommandArgv(int argc, const char** argv, const size_t* argvlen) {
+    if (!IsConnected() || argc == 0) return nullptr;
     
-    std::stringstream ss;
-    ss << "DEL";
-    for (const auto& key : keys) {
-        ss << " " << key;
+    Span span("redis.command", SpanKind::kClient);
+    if (span.Recording()) {
+        span.SetAttribute("db.system", "redis");
+        span.SetAttribute("db.operation", std::string_view(argv[0], argvlen[0]));
     }
     
-    auto reply = static_cast<redisReply*>(redisCommand(context_, ss.str().c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER);
-    freeReplyObject(reply);
-    return success;
+    RedisReplyPtr reply(static_cast<redisReply*>(redisCommandArgv(context_, argc, argv, argvlen)));
+    if (!reply) {
+        span.SetError(context_->errstr);
+    } else if (reply->type == REDIS_REPLY_ERROR) {
+        span.SetError(std::string_view(reply->str, reply->len));
+    }
+    if (redirect_handler_ && reply && reply->type == REDIS_REPLY_ERROR) {
+        std::string_view error(reply->str, reply->len);
+        if (error.rfind("MOVED ", 0) == 0 || error.rfind("ASK ", 0) == 0) {
+            std::vector<std::string_view> args;
+            args.reserve(argc);
+            for (int i = 0; i < argc; i++) {
+                args.emplace_back(argv[i], argvlen[i]);
+            }
+            return redirect_handler_(error, args);
+        }
+    }
+    return reply;
 }
 
-bool RedisClient::Exists(const std::string& key) {
-    if (!IsConnected()) return false;
+bool RedisClient::Append(const std::vector<std::string>& args) {
+    if (!IsConnected() || args.empty()) return false;
     
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "EXISTS %s", key.c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER && reply->integer == 1);
-    freeReplyObject(reply);
-    return success;
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+    argv.reserve(args.size());
+    argvlen.reserve(args.size());
+    for (const auto& arg : args) {
+        argv.push_back(arg.data());
+        argvlen.push_back(arg.size());
+    }
+    return redisAppendCommandArgv(context_, static_cast<int>(args.size()),
+                                  argv.data(), argvlen.data()) == REDIS_OK;
 }
 
-bool RedisClient::HSet(const std::string& key, const std::string& field, const std::string& value) {
+bool RedisClient::Flush() {
     if (!IsConnected()) return false;
     
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "HSET %s %s %s", 
-                                                      key.c_str(), field.c_str(), value.c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER);
-    freeReplyObject(reply);
-    return success;
+    int done = 0;
+    while (!done) {
+        if (redisBufferWrite(context_, &done) != REDIS_OK) return false;
+    }
+    return true;
 }
 
-bool RedisClient::HDel(const std::string& key, const std::string& field) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "HDEL %s %s", key.c_str(), field.c_str()));
-    if (!reply) return false;
+RedisReplyPtr RedisClient::GetReply() {
+    if (!context_) return nullptr;
     
-    bool success = (reply->type == REDIS_REPLY_INTEGER);
-    freeReplyObject(reply);
-    return success;
+    void* reply = nullptr;
+    if (redisGetReply(context_, &reply) != REDIS_OK) return nullptr;
+    return RedisReplyPtr(static_cast<redisReply*>(reply));
 }
 
-std::string RedisClient::HGet(const std::string& key, const std::string& field) {
-    if (!IsConnected()) return "";
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "HGET %s %s", key.c_str(), field.c_str()));
-    if (!reply) return "";
-    
-    std::string result;
-    if (reply->type == REDIS_REPLY_STRING) {
-        result = reply->str;
-    }
-    freeReplyObject(reply);
-    return result;
+void RedisClient::SetRedirectHandler(RedirectHandler handler) {
+    redirect_handler_ = std::move(handler);
 }
 
-std::map<std::string, std::string> RedisClient::HGetAll(const std::string& key) {
-    std::map<std::string, std::string> result;
-    
-    if (!IsConnected()) return result;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "HGETALL %s", key.c_str()));
-    if (!reply) return result;
-    
-    if (reply->type == REDIS_REPLY_ARRAY) {
-        for (size_t i = 0; i < reply->elements; i += 2) {
-            if (i + 1 < reply->elements) {
-                result[reply->element[i]->str] = reply->element[i + 1]->str;
-            }
-        }
-    }
+bool RedisClient::Set(std::string_view key, std::string_view value) {
+    return IsStatusOk(Command({"SET", key, value}));
+}
+
+bool RedisClient::Setex(std::string_view key, int seconds, std::string_view value) {
+    return IsStatusOk(Command({"SETEX", key, std::to_string(seconds), value}));
+}
+
+bool RedisClient::Setnx(std::string_view key, std::string_view value) {
+    return IntegerOr(Command({"SETNX", key, value}), 0) == 1;
+}
+
+bool RedisClient::SetNxEx(std::string_view key, int seconds, std::string_view value) {
+    return IsStatusOk(Command({"SET", key, value, "NX", "EX", std::to_string(seconds)}));
+}
+
+std::string RedisClient::Get(std::string_view key) {
+    std::string value;
+    Get(key, &value);
+    return value;
+}
+
+bool RedisClient::Get(std::string_view key, std::string* value) {
+    auto reply = Command({"GET", key});
+    if (!reply || reply->type != REDIS_REPLY_STRING) return false;
     
-    freeReplyObject(reply);
-    return result;
+    value->assign(reply->str, reply->len);
+    return true;
 }
 
-std::vector<std::string> RedisClient::SMembers(const std::string& key) {
-    std::vector<std::string> result;
+std::vector<std::optional<std::string>> RedisClient::MGet(const std::vector<std::string>& keys) {
+    std::vector<std::optional<std::string>> result(keys.size());
+    if (keys.empty()) return result;
     
-    if (!IsConnected()) return result;
+    std::vector<std::string_view> args;
+    args.reserve(keys.size() + 1);
+    args.push_back("MGET");
+    args.insert(args.end(), keys.begin(), keys.end());
     
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "SMEMBERS %s", key.c_str()));
-    if (!reply) return result;
+    auto reply = Command(args);
+    if (!reply || reply->type != REDIS_REPLY_ARRAY) return result;
     
-    if (reply->type == REDIS_REPLY_ARRAY) {
-        for (size_t i = 0; i < reply->elements; i++) {
-            result.push_back(reply->element[i]->str);
+    for (size_t i = 0; i < reply->elements && i < result.size(); i++) {
+        if (reply->element[i]->type == REDIS_REPLY_STRING) {
+            result[i] = ToString(reply->element[i]);
         }
     }
-    
-    freeReplyObject(reply);
     return result;
 }
 
-bool RedisClient::SIsMember(const std::string& key, const std::string& member) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "SISMEMBER %s %s", 
-                                                      key.c_str(), member.c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER && reply->integer == 1);
-    freeReplyObject(reply);
-    return success;
+bool RedisClient::Del(std::string_view key) {
+    return IntegerOr(Command({"DEL", key}), -1) >= 0;
 }
 
-bool RedisClient::SAdd(const std::string& key, const std::string& member) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "SADD %s %s", key.c_str(), member.c_str()));
-    if (!reply) return false;
+bool RedisClient::Del(const std::vector<std::string>& keys) {
+    if (keys.empty()) return true;
     
-    bool success = (reply->type == REDIS_REPLY_INTEGER);
-    freeReplyObject(reply);
-    return success;
+    std::vector<std::string_view> args;
+    args.reserve(keys.size() + 1);
+    args.push_back("DEL");
+    args.insert(args.end(), keys.begin(), keys.end());
+    return IntegerOr(Command(args), -1) >= 0;
 }
 
-bool RedisClient::SRem(const std::string& key, const std::string& member) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "SREM %s %s", key.c_str(), member.c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER);
-    freeReplyObject(reply);
-    return success;
+bool RedisClient::Exists(std::string_view key) {
+    return IntegerOr(Command({"EXISTS", key}), 0) == 1;
 }
 
-int RedisClient::SCard(const std::string& key) {
-    if (!IsConnected()) return 0;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "SCARD %s", key.c_str()));
-    if (!reply) return 0;
-    
-    int count = (reply->type == REDIS_REPLY_INTEGER) ? reply->integer : 0;
-    freeReplyObject(reply);
-    return count;
+bool RedisClient::HSet(std::string_view key, std::string_view field, std::string_view value) {
+    return IntegerOr(Command({"HSET", key, field, value}), -1) >= 0;
 }
 
-bool RedisClient::ZAdd(const std::string& key, double score, const std::string& member) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "ZADD %s %f %s", 
-                                                      key.c_str(), score, member.c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER);
-    freeReplyObject(reply);
-    return success;
+bool RedisClient::HDel(std::string_view key, std::string_view field) {
+    return IntegerOr(Command({"HDEL", key, field}), -1) >= 0;
 }
 
-bool RedisClient::ZRem(const std::string& key, const std::string& member) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "ZREM %s %s", key.c_str(), member.c_str()));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER);
-    freeReplyObject(reply);
-    return success;
+std::string RedisClient::HGet(std::string_view key, std::string_view field) {
+    std::string value;
+    HGet(key, field, &value);
+    return value;
 }
 
-std::vector<std::string> RedisClient::ZRange(const std::string& key, int start, int stop) {
-    std::vector<std::string> result;
+bool RedisClient::HGet(std::string_view key, std::string_view field, std::string* value) {
+    auto reply = Command({"HGET", key, field});
+    if (!reply || reply->type != REDIS_REPLY_STRING) return false;
     
-    if (!IsConnected()) return result;
+    value->assign(reply->str, reply->len);
+    return true;
+}
+
+int64_t RedisClient::HIncrBy(std::string_view key, std::string_view field, int64_t increment) {
+    return IntegerOr(Command({"HINCRBY", key, field, std::to_string(increment)}), 0);
+}
+
+std::map<std::string, std::string> RedisClient::HGetAll(std::string_view key) {
+    std::map<std::string, std::string> result;
     
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "ZRANGE %s %d %d", 
-                                                      key.c_str(), start, stop));
-    if (!reply) return result;
+    auto reply = Command({"HGETALL", key});
+    if (!reply || reply->type != REDIS_REPLY_ARRAY) return result;
     
-    if (reply->type == REDIS_REPLY_ARRAY) {
-        for (size_t i = 0; i < reply->elements; i++) {
-            result.push_back(reply->element[i]->str);
-        }
+    for (size_t i = 0; i + 1 < reply->elements; i += 2) {
+        result[ToString(reply->element[i])] = ToString(reply->element[i + 1]);
     }
-    
-    freeReplyObject(reply);
     return result;
 }
 
-std::vector<std::string> RedisClient::ZRevRange(const std::string& key, int start, int stop) {
-    std::vector<std::string> result;
+std::vector<std::string> RedisClient::HMGet(std::string_view key, const std::vector<std::string>& fields) {
+    std::vector<std::string> result(fields.size());
+    if (fields.empty()) return result;
     
-    if (!IsConnected()) return result;
+    std::vector<std::string_view> args;
+    args.reserve(fields.size() + 2);
+    args.push_back("HMGET");
+    args.push_back(key);
+    args.insert(args.end(), fields.begin(), fields.end());
     
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "ZREVRANGE %s %d %d", 
-                                                      key.c_str(), start, stop));
-    if (!reply) return result;
+    auto reply = Command(args);
+    if (!reply || reply->type != REDIS_REPLY_ARRAY) return result;
     
-    if (reply->type == REDIS_REPLY_ARRAY) {
-        for (size_t i = 0; i < reply->elements; i++) {
-            result.push_back(reply->element[i]->str);
-        }
+    for (size_t i = 0; i < reply->elements && i < result.size(); i++) {
+        result[i] = ToString(reply->element[i]);
     }
-    
-    freeReplyObject(reply);
     return result;
 }
 
-int64_t RedisClient::Incr(const std::string& key) {
-    if (!IsConnected()) return 0;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "INCR %s", key.c_str()));
-    if (!reply) return 0;
-    
-    int64_t value = (reply->type == REDIS_REPLY_INTEGER) ? reply->integer : 0;
-    freeReplyObject(reply);
-    return value;
+std::vector<std::string> RedisClient::SMembers(std::string_view key) {
+    return ToStrings(Command({"SMEMBERS", key}));
 }
 
-int64_t RedisClient::IncrBy(const std::string& key, int64_t increment) {
-    if (!IsConnected()) return 0;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "INCRBY %s %lld", 
-                                                      key.c_str(), increment));
-    if (!reply) return 0;
-    
-    int64_t value = (reply->type == REDIS_REPLY_INTEGER) ? reply->integer : 0;
-    freeReplyObject(reply);
-    return value;
+bool RedisClient::SIsMember(std::string_view key, std::string_view member) {
+    return IntegerOr(Command({"SISMEMBER", key, member}), 0) == 1;
 }
 
-int64_t RedisClient::Decr(const std::string& key) {
-    if (!IsConnected()) return 0;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "DECR %s", key.c_str()));
-    if (!reply) return 0;
-    
-    int64_t value = (reply->type == REDIS_REPLY_INTEGER) ? reply->integer : 0;
-    freeReplyObject(reply);
-    return value;
+bool RedisClient::SAdd(std::string_view key, std::string_view member) {
+    return IntegerOr(Command({"SADD", key, member}), -1) >= 0;
 }
 
-bool RedisClient::Expire(const std::string& key, int seconds) {
-    if (!IsConnected()) return false;
-    
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "EXPIRE %s %d", key.c_str(), seconds));
-    if (!reply) return false;
-    
-    bool success = (reply->type == REDIS_REPLY_INTEGER && reply->integer == 1);
-    freeReplyObject(reply);
-    return success;
+bool RedisClient::SRem(std::string_view key, std::string_view member) {
+    return IntegerOr(Command({"SREM", key, member}), -1) >= 0;
+}
+
+int RedisClient::SCard(std::string_view key) {
+    return static_cast<int>(IntegerOr(Command({"SCARD", key}), 0));
+}
+
+bool RedisClient::ZAdd(std::string_view key, double score, std::string_view member) {
+    return IntegerOr(Command({"ZADD", key, FormatScore(score), member}), -1) >= 0;
+}
+
+bool RedisClient::ZRem(std::string_view key, std::string_view member) {
+    return IntegerOr(Command({"ZREM", key, member}), -1) >= 0;
+}
+
+std::vector<std::string> RedisClient::ZRange(std::string_view key, int start, int stop) {
+    return ToStrings(Command({"ZRANGE", key, std::to_string(start), std::to_string(stop)}));
+}
+
+std::vector<std::string> RedisClient::ZRevRange(std::string_view key, int start, int stop) {
+    return ToStrings(Command({"ZREVRANGE", key, std::to_string(start), std::to_string(stop)}));
+}
+
+std::vector<std::string> RedisClient::ZRangeByScore(std::string_view key, double min, double max) {
+    return ToStrings(Command({"ZRANGEBYSCORE", key, FormatScore(min), FormatScore(max)}));
+}
+
+std::vector<std::string> RedisClient::ZRevRangeByScore(std::string_view key, double min, double max) {
+    // ZREVRANGEBYSCORE takes the bounds high to low.
+    return ToStrings(Command({"ZREVRANGEBYSCORE", key, FormatScore(max), FormatScore(min)}));
+}
+
+int RedisClient::ZCard(std::string_view key) {
+    return static_cast<int>(IntegerOr(Command({"ZCARD", key}), 0));
+}
+
+int64_t RedisClient::Incr(std::string_view key) {
+    return IntegerOr(Command({"INCR", key}), 0);
+}
+
+int64_t RedisClient::IncrBy(std::string_view key, int64_t increment) {
+    return IntegerOr(Command({"INCRBY", key, std::to_string(increment)}), 0);
+}
+
+int64_t RedisClient::Decr(std::string_view key) {
+    return IntegerOr(Command({"DECR", key}), 0);
 }
 
-int64_t RedisClient::TTL(const std::string& key) {
+int64_t RedisClient::Publish(std::string_view channel, std::string_view message) {
+    return IntegerOr(Command({"PUBLISH", channel, message}), 0);
+}
+
+bool RedisClient::Subscribe(std::string_view channel) {
+    auto reply = Command({"SUBSCRIBE", channel});
+    return reply && reply->type == REDIS_REPLY_ARRAY && reply->elements == 3;
+}
+
+int RedisClient::WaitReply(int timeout_ms, RedisReplyPtr* reply) {
     if (!IsConnected()) return -1;
     
-    auto reply = static_cast<redisReply*>(redisCommand(context_, 
-                                                      "TTL %s", key.c_str()));
-    if (!reply) return -1;
-    
-    int64_t ttl = (reply->type == REDIS_REPLY_INTEGER) ? reply->integer : -1;
-    freeReplyObject(reply);
-    return ttl;
+    while (true) {
+        void* raw = nullptr;
+        if (redisGetReplyFromReader(context_, &raw) != REDIS_OK) return -1;
+        
+        if (raw) {
+            reply->reset(static_cast<redisReply*>(raw));
+            return 1;
+        }
+        
+        // Nothing buffered: wait for the socket rather than blocking in
+        // hiredis, whose read timeout would break the connection.
+        struct pollfd pfd = {context_->fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready == 0) return 0;
+        if (ready < 0 || redisBufferRead(context_) != REDIS_OK) return -1;
+    }
+}
+
+int RedisClient::WaitMessage(int timeout_ms, std::string* channel, std::string* message) {
+    while (true) {
+        RedisReplyPtr reply;
+        int result = WaitReply(timeout_ms, &reply);
+        if (result <= 0) return result;
+        
+        bool is_message = reply->type == REDIS_REPLY_ARRAY && reply->elements == 3 &&
+                          reply->element[0]->type == REDIS_REPLY_STRING &&
+                          strcmp(reply->element[0]->str, "message") == 0 &&
+                          reply->element[2]->type == REDIS_REPLY_STRING;
+        if (is_message) {
+            channel->assign(reply->element[1]->str, reply->element[1]->len);
+            message->assign(reply->element[2]->str, reply->element[2]->len);
+            return 1;
+        }
+    }
+}
+
+bool RedisClient::Expire(std::string_view key, int seconds) {
+    return IntegerOr(Command({"EXPIRE", key, std::to_string(seconds)}), 0) == 1;
+}
+
+int64_t RedisClient::TTL(std::string_view key) {
+    return IntegerOr(Command({"TTL", key}), -1);
 }
 
 redisContext* RedisClient::GetRawContext() {
@@ -0,0 +1,387 @@
+#include "../../../include/data/redis_cluster.h"
+#include "../../../include/common/logger.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+
+namespace ourchat {
+
+namespace {
+
+constexpr std::array<uint16_t, 256> MakeCrc16Table() {
+    std::array<uint16_t, 256> table{};
+    for (int i = 0; i < 256; i++) {
+        uint16_t crc = static_cast<uint16_t>(i << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint16_t, 256> kCrc16Table = MakeCrc16Table();
+
+// Idle connections older than this are pinged before being handed out.
+constexpr std::chrono::seconds kValidateAfterIdle{30};
+
+bool IsRedirect(const redisReply* reply) {
+    if (!reply || reply->type != REDIS_REPLY_ERROR || !reply->str) return false;
+    std::string_view error(reply->str, reply->len);
+    return error.rfind("MOVED ", 0) == 0 || error.rfind("ASK ", 0) == 0;
+}
+
+} // namespace
+
+std::shared_ptr<RedisCluster> RedisCluster::Instance() {
+    static std::shared_ptr<RedisCluster> instance(new RedisCluster());
+    return instance;
+}
+
+RedisCluster::~RedisCluster() {
+    Close();
+}
+
+int RedisCluster::KeySlot(std::string_view key) {
+    size_t open = key.find('{');
+    if (open != std::string_view::npos) {
+        size_t close = key.find('}', open + 1);
+        if (close != std::string_view::npos && close > open + 1) {
+            key = key.substr(open + 1, close - open - 1);
+        }
+    }
+
+    uint16_t crc = 0;
+    for (unsigned char c : key) {
+        crc = static_cast<uint16_t>((crc << 8) ^ kCrc16Table[((crc >> 8) ^ c) & 0xff]);
+    }
+    return crc & (kSlotCount - 1);
+}
+
+bool RedisCluster::Init(const RedisConfig& config) {
+    config_ = config;
+
+    std::vector<RedisNode> seeds;
+    seeds.push_back(RedisNode{config.host, config.port});
+    seeds.insert(seeds.end(), config.cluster_nodes.begin(), config.cluster_nodes.end());
+
+    for (const auto& seed : seeds) {
+        auto connection = GetNodePool(seed.host, seed.port)->Borrow(false);
+        if (connection && LoadSlots(connection.get(), seed.host)) {
+            last_refresh_ = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(nodes_mutex_);
+            LOG_INFO("Redis cluster slot map loaded, " + std::to_string(nodes_.size()) + " nodes");
+            return true;
+        }
+    }
+
+    LOG_ERROR("Failed to load the Redis cluster slot map from any seed node");
+    return false;
+}
+
+void RedisCluster::Close() {
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    for (auto& node : nodes_) {
+        node.second->Close();
+    }
+}
+
+RedisCluster::NodePool* RedisCluster::Owner(std::string_view key) {
+    auto slots = std::atomic_load(&slots_);
+    if (!slots) return nullptr;
+
+    if (key.empty()) {
+        size_t slot = next_node_.fetch_add(4099, std::memory_order_relaxed) % kSlotCount;
+        return slots->owners[slot];
+    }
+    return slots->owners[KeySlot(key)];
+}
+
+ConnectionPool<RedisClient>::Lease RedisCluster::GetConnection(std::string_view key) {
+    NodePool* pool = Owner(key);
+    if (!pool) return NodePool::Lease();
+    return pool->Borrow();
+}
+
+std::vector<RedisReplyPtr> RedisCluster::Pipeline(const std::vector<std::vector<std::string>>& commands) {
+    std::vector<RedisReplyPtr> replies(commands.size());
+
+    struct Batch {
+        NodePool* pool = nullptr;
+        NodePool::Lease connection;
+        std::vector<size_t> indexes;
+        size_t sent = 0;
+    };
+    std::vector<Batch> batches;
+
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (commands[i].empty()) continue;
+
+        NodePool* pool = Owner(commands[i].size() > 1 ? std::string_view(commands[i][1]) : std::string_view());
+        if (!pool) continue;
+
+        auto it = std::find_if(batches.begin(), batches.end(),
+                               [pool](const Batch& batch) { return batch.pool == pool; });
+        if (it == batches.end()) {
+            batches.emplace_back();
+            batches.back().pool = pool;
+            it = batches.end() - 1;
+        }
+        it->indexes.push_back(i);
+    }
+
+    auto send = [&commands](Batch& batch) {
+        for (size_t index : batch.indexes) {
+            if (!batch.connection->Append(commands[index])) break;
+            batch.sent++;
+        }
+        if (!batch.connection->Flush()) {
+            batch.sent = 0;
+        }
+    };
+    auto receive = [&replies](Batch& batch) {
+        for (size_t i = 0; i < batch.sent; i++) {
+            replies[batch.indexes[i]] = batch.connection->GetReply();
+        }
+        batch.connection.Release();
+    };
+
+    // Write every node's batch before reading any reply, so the nodes work
+    // on their parts concurrently. Only idle connections are taken here:
+    // waiting for one node while holding another could deadlock against a
+    // concurrent batch doing the reverse.
+    std::vector<Batch*> deferred;
+    for (auto& batch : batches) {
+        batch.connection = batch.pool->Borrow(false);
+        if (batch.connection) {
+            send(batch);
+        } else {
+            deferred.push_back(&batch);
+        }
+    }
+    for (auto& batch : batches) {
+        if (batch.connection) receive(batch);
+    }
+
+    for (Batch* batch : deferred) {
+        batch->connection = batch->pool->Borrow();
+        if (!batch->connection) continue;
+        send(*batch);
+        receive(*batch);
+    }
+
+    // Slots that moved while the batch was routed are retried one by one.
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (!IsRedirect(replies[i].get())) continue;
+
+        std::vector<std::string_view> args(commands[i].begin(), commands[i].end());
+        auto redirected = Redirect(std::string_view(replies[i]->str, replies[i]->len), args);
+        replies[i] = std::move(redirected);
+    }
+
+    return replies;
+}
+
+RedisReplyPtr RedisCluster::Redirect(std::string_view error, const std::vector<std::string_view>& args) {
+    thread_local int depth = 0;
+    if (depth >= kMaxRedirects) {
+        LOG_WARN("Too many Redis cluster redirects: " + std::string(error));
+        return nullptr;
+    }
+
+    // "MOVED <slot> <host>:<port>" or "ASK <slot> <host>:<port>"
+    bool ask = error.rfind("ASK ", 0) == 0;
+    size_t space = error.rfind(' ');
+    size_t colon = error.rfind(':');
+    if (space == std::string_view::npos || colon == std::string_view::npos || colon < space) {
+        return nullptr;
+    }
+
+    std::string host(error.substr(space + 1, colon - space - 1));
+    if (host.empty()) host = config_.host;
+    int port = 0;
+    std::from_chars(error.data() + colon + 1, error.data() + error.size(), port);
+
+    NodePool* pool = GetNodePool(host, port);
+    if (!ask) {
+        // The command goes straight to the new owner; the rest of the map
+        // is reloaded so the next commands route there directly.
+        RefreshSlots();
+    }
+
+    // This runs inside the command that was redirected, so the caller still
+    // holds its connection. Waiting here for another node could deadlock
+    // against a caller redirected the other way; fail the command instead.
+    auto connection = pool->Borrow(false);
+    if (!connection) {
+        LOG_WARN("No free connection for Redis cluster redirect to " + host + ":" +
+                 std::to_string(port));
+        return nullptr;
+    }
+
+    depth++;
+    if (ask) {
+        connection->Command({"ASKING"});
+    }
+    auto reply = connection->Command(args);
+    depth--;
+    return reply;
+}
+
+bool RedisCluster::RefreshSlots() {
+    std::unique_lock<std::mutex> refresh_lock(refresh_mutex_, std::try_to_lock);
+    if (!refresh_lock) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_refresh_ < kMinRefreshInterval) return false;
+    last_refresh_ = now;
+
+    std::vector<std::pair<std::string, NodePool*>> pools;
+    {
+        std::lock_guard<std::mutex> lock(nodes_mutex_);
+        for (auto& node : nodes_) {
+            pools.emplace_back(node.first, node.second.get());
+        }
+    }
+
+    for (auto& node : pools) {
+        auto connection = node.second->Borrow(false);
+        if (!connection) continue;
+
+        std::string host = node.first.substr(0, node.first.rfind(':'));
+        if (LoadSlots(connection.get(), host)) return true;
+    }
+
+    LOG_WARN("Failed to refresh the Redis cluster slot map");
+    return false;
+}
+
+bool RedisCluster::LoadSlots(RedisClient* client, const std::string& fallback_host) {
+    auto reply = client->Command({"CLUSTER", "SLOTS"});
+    if (!reply || reply->type != REDIS_REPLY_ARRAY || reply->elements == 0) return false;
+
+    auto slots = std::make_shared<SlotMap>();
+    for (size_t i = 0; i < reply->elements; i++) {
+        // [start, end, [host, port, id], replicas...]
+        const redisReply* range = reply->element[i];
+        if (range->type != REDIS_REPLY_ARRAY || range->elements < 3) continue;
+
+        const redisReply* master = range->element[2];
+        if (master->type != REDIS_REPLY_ARRAY || master->elements < 2) continue;
+
+        std::string host = master->element[0]->str
+                               ? std::string(master->element[0]->str, master->element[0]->len)
+                               : std::string();
+        if (host.empty() || host == "?") host = fallback_host;
+        NodePool* pool = GetNodePool(host, static_cast<int>(master->element[1]->integer));
+
+        long long start = std::max(range->element[0]->integer, 0LL);
+        long long end = std::min(range->element[1]->integer, static_cast<long long>(kSlotCount - 1));
+        for (long long slot = start; slot <= end; slot++) {
+            slots->owners[slot] = pool;
+        }
+    }
+
+    std::atomic_store(&slots_, std::shared_ptr<const SlotMap>(slots));
+    return true;
+}
+
+RedisCluster::NodePool* RedisCluster::GetNodePool(const std::string& host, int port) {
+    std::string address = host + ":" + std::to_string(port);
+
+    int pool_size = 0;
+    {
+        std::lock_guard<std::mutex> lock(nodes_mutex_);
+        auto it = nodes_.find(address);
+        if (it != nodes_.end()) return it->second.get();
+        pool_size = config_.pool_size;
+    }
+
+    NodePool::Options options;
+    options.size = static_cast<size_t>(std::max(pool_size, 1));
+    options.validate_after = kValidateAfterIdle;
+    options.is_usable = [](RedisClient& connection) { return connection.IsConnected(); };
+    options.validate = [](RedisClient& connection) { return connection.Ping(); };
+
+    auto pool = std::make_unique<NodePool>(
+        "redis " + address,
+        [this, host, port]() { return CreateConnection(host, port); },
+        options);
+    // Connecting takes round trips; other slot lookups must not wait on it.
+    pool->Init();
+
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    // Another thread may have added the node meanwhile; its pool wins and
+    // ours closes as it goes out of scope.
+    auto inserted = nodes_.emplace(address, std::move(pool));
+    return inserted.first->second.get();
+}
+
+std::unique_ptr<RedisClient> RedisCluster::CreateConnection(const std::string& host, int port) {
+    auto connection = std::make_unique<RedisClient>();
+    // Cluster nodes only have database 0.
+    if (!connection->Connect(host, port, config_.password, 0)) {
+        LOG_ERROR("Failed to connect to Redis cluster node " + host + ":" + std::to_string(port));
+        return nullptr;
+    }
+
+    if (connection->LoadScripts() < RedisScript::All().size()) {
+        LOG_WARN("Failed to load Redis scripts on " + host + ":" + std::to_string(port));
+    }
+
+    connection->SetRedirectHandler([this](std::string_view error, const std::vector<std::string_view>& args) {
+        return Redirect(error, args);
+    });
+    return connection;
+}
+
+void RedisCluster::Maintain() {
+    std::vector<NodePool*> pools;
+    {
+        std::lock_guard<std::mutex> lock(nodes_mutex_);
+        for (auto& node : nodes_) {
+            pools.push_back(node.second.get());
+        }
+    }
+
+    for (NodePool* pool : pools) {
+        pool->Maintain();
+    }
+}
+
+void RedisCluster::Resize(int pool_size) {
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    config_.pool_size = pool_size;
+    for (auto& node : nodes_) {
+        node.second->Resize(static_cast<size_t>(std::max(pool_size, 1)));
+    }
+}
+
+int RedisCluster::GetPoolSize() {
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    size_t total = 0;
+    for (auto& node : nodes_) {
+        total += node.second->Live();
+    }
+    return static_cast<int>(total);
+}
+
+int RedisCluster::GetActiveConnections() {
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    size_t total = 0;
+    for (auto& node : nodes_) {
+        total += node.second->InUse();
+    }
+    return static_cast<int>(total);
+}
+
+int RedisCluster::GetIdleConnections() {
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    size_t total = 0;
+    for (auto& node : nodes_) {
+        total += node.second->Idle();
+    }
+    return static_cast<int>(total);
+}
+
+} // namespace ourchat
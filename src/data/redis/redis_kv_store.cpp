@@ -0,0 +1,124 @@
+#include "../../../include/data/redis_kv_store.h"
+#include "../../../include/data/redis_cluster.h"
+
+namespace ourchat {
+
+RedisKVStore::RedisKVStore()
+    : redis_pool_(RedisPool::Instance()), async_redis_(AsyncRedisClient::Instance()),
+      near_cache_(NearCache::Instance()) {}
+
+std::string RedisKVStore::Get(const std::string& key) {
+    std::string value;
+    near_cache_->Get(key, &value);
+    return value;
+}
+
+bool RedisKVStore::SetEx(const std::string& key, int seconds, const std::string& value) {
+    auto conn = redis_pool_->GetConnection(key);
+    bool ok = conn && conn->Setex(key, seconds, value);
+    // Tracking invalidates every node, this one included, but only after a
+    // round trip; dropping the key now lets this node read its own write.
+    near_cache_->Invalidate(key);
+    return ok;
+}
+
+bool RedisKVStore::SetNxEx(const std::string& key, int seconds, const std::string& value) {
+    auto conn = redis_pool_->GetConnection(key);
+    bool ok = conn && conn->SetNxEx(key, seconds, value);
+    near_cache_->Invalidate(key);
+    return ok;
+}
+
+bool RedisKVStore::SetExMany(const std::vector<std::pair<std::string, std::string>>& entries,
+                             int seconds) {
+    bool ok = WriteMany(entries, seconds);
+    for (const auto& entry : entries) {
+        near_cache_->Invalidate(entry.first);
+    }
+    return ok;
+}
+
+bool RedisKVStore::WriteMany(const std::vector<std::pair<std::string, std::string>>& entries,
+                             int seconds) {
+    if (entries.empty()) return true;
+
+    std::string ttl = std::to_string(seconds);
+
+    // A script is atomic, but all its keys must live on one node: always
+    // true standalone, and under Cluster when the keys share a slot.
+    bool one_slot = true;
+    if (redis_pool_->IsCluster()) {
+        int slot = RedisCluster::KeySlot(entries[0].first);
+        for (const auto& entry : entries) {
+            one_slot = one_slot && RedisCluster::KeySlot(entry.first) == slot;
+        }
+    }
+
+    if (one_slot) {
+        std::vector<std::string_view> keys;
+        std::vector<std::string_view> args;
+        keys.reserve(entries.size());
+        args.reserve(entries.size() + 1);
+        args.push_back(ttl);
+        for (const auto& entry : entries) {
+            keys.push_back(entry.first);
+            args.push_back(entry.second);
+        }
+
+        auto conn = redis_pool_->GetConnection(entries[0].first);
+        if (!conn) return false;
+
+        auto reply = conn->EvalScript(RedisScript::SetExMany(), keys, args);
+        return reply && reply->type != REDIS_REPLY_ERROR;
+    }
+
+    // Keys in different slots cannot share a script; Pipeline sends each to
+    // its node in one round trip, so each key is written independently.
+    std::vector<std::vector<std::string>> commands;
+    commands.reserve(entries.size());
+    for (const auto& entry : entries) {
+        commands.push_back({"SETEX", entry.first, ttl, entry.second});
+    }
+
+    bool ok = true;
+    for (const auto& reply : redis_pool_->Pipeline(commands)) {
+        ok = ok && reply && reply->type != REDIS_REPLY_ERROR;
+    }
+    return ok;
+}
+
+bool RedisKVStore::Del(const std::string& key) {
+    auto conn = redis_pool_->GetConnection(key);
+    bool ok = conn && conn->Del(key);
+    near_cache_->Invalidate(key);
+    return ok;
+}
+
+bool RedisKVStore::Expire(const std::string& key, int seconds) {
+    auto conn = redis_pool_->GetConnection(key);
+    return conn && conn->Expire(key, seconds);
+}
+
+std::string RedisKVStore::HGet(const std::string& key, const std::string& field) {
+    auto conn = redis_pool_->GetConnection(key);
+    if (!conn) return std::string();
+    return conn->HGet(key, field);
+}
+
+int64_t RedisKVStore::HIncrBy(const std::string& key, const std::string& field, int64_t increment) {
+    auto conn = redis_pool_->GetConnection(key);
+    if (!conn) return 0;
+    return conn->HIncrBy(key, field, increment);
+}
+
+std::map<std::string, std::string> RedisKVStore::HGetAll(const std::string& key) {
+    auto conn = redis_pool_->GetConnection(key);
+    if (!conn) return {};
+    return conn->HGetAll(key);
+}
+
+void RedisKVStore::Publish(const std::string& channel, const std::string& message) {
+    async_redis_->Execute({"PUBLISH", channel, message}, AsyncRedisClient::Callback());
+}
+
+} // namespace ourchat
@@ -1,10 +1,12 @@
 #include "../../../include/data/redis_pool.h"
 #include "../../../include/common/logger.h"
+#include "../../../include/common/tracing.h"
+#include <algorithm>
 
 namespace ourchat {
 
 std::shared_ptr<RedisPool> RedisPool::Instance() {
-    static std::shared_ptr<RedisPool> instance = std::make_shared<RedisPool>();
+    static std::shared_ptr<RedisPool> instance(new RedisPool());
     return instance;
 }
 
@@ -12,10 +14,35 @@ bool RedisPool::Init(const RedisConfig& config) {
     config_ = config;
     running_ = true;
     
-    for (int i = 0; i < config.pool_size; i++) {
-        CreateConnection();
+    if (config.cluster) {
+        cluster_ = RedisCluster::Instance();
+        if (!cluster_->Init(config)) {
+            running_ = false;
+            return false;
+        }
+        monitor_thread_ = std::thread(&RedisPool::MonitorLoop, this);
+        return true;
     }
     
+    ConnectionPool<RedisClient>::Options options;
+    options.size = static_cast<size_t>(std::max(config.pool_size, 1));
+    options.validate_after = kValidateAfterIdle;
+    options.is_usable = [](RedisClient& connection) { return connection.IsConnected(); };
+    options.validate = [](RedisClient& connection) { return connection.Ping(); };
+    
+    pool_ = std::make_unique<ConnectionPool<RedisClient>>(
+        "redis " + config.host + ":" + std::to_string(config.port),
+        [this]() { return CreateConnection(); },
+        options);
+    
+    size_t created = pool_->Init();
+    if (created < pool_->Capacity()) {
+        LOG_ERROR("Redis pool opened " + std::to_string(created) + " of " +
+                  std::to_string(pool_->Capacity()) + " connections");
+    }
+    
+    monitor_thread_ = std::thread(&RedisPool::MonitorLoop, this);
+    
     LOG_INFO("Redis pool initialized with " + std::to_string(config_.pool_size) + " connections");
     return true;
 }
@@ -24,68 +51,126 @@ RedisPool::~RedisPool() {
     Close();
 }
 
-std::unique_ptr<RedisClient> RedisPool::GetConnection() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    
-    cv_.wait(lock, [this]() {
-        return !connections_.empty() || !running_;
-    });
+RedisLease RedisPool::GetConnection(std::string_view key) {
+    if (!running_) return RedisLease();
+    if (cluster_) return cluster_->GetConnection(key);
+    if (!pool_) return RedisLease();
+    return pool_->Borrow();
+}
+
+std::vector<RedisReplyPtr> RedisPool::Pipeline(const std::vector<std::vector<std::string>>& commands) {
+    Span span("redis.pipeline", SpanKind::kClient);
+    span.SetAttribute("redis.commands", static_cast<int64_t>(commands.size()));
     
-    if (!running_) return nullptr;
+    if (cluster_) return cluster_->Pipeline(commands);
     
-    auto connection = std::move(connections_.front());
-    connections_.pop();
-    active_count_++;
+    std::vector<RedisReplyPtr> replies(commands.size());
+    auto connection = GetConnection();
+    if (!connection) return replies;
     
-    return connection;
+    size_t sent = 0;
+    for (const auto& command : commands) {
+        if (!connection->Append(command)) break;
+        sent++;
+    }
+    for (size_t i = 0; i < sent; i++) {
+        replies[i] = connection->GetReply();
+    }
+    if (sent < commands.size()) span.SetError("pipeline aborted");
+    return replies;
 }
 
-void RedisPool::ReturnConnection(std::unique_ptr<RedisClient> connection) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (connection->IsConnected()) {
-        connections_.push(std::move(connection));
+void RedisPool::Resize(int pool_size) {
+    if (cluster_) {
+        cluster_->Resize(pool_size);
+    } else if (pool_) {
+        pool_->Resize(static_cast<size_t>(std::max(pool_size, 1)));
     }
-    
-    active_count_--;
-    cv_.notify_one();
 }
 
 void RedisPool::Close() {
     running_ = false;
-    cv_.notify_all();
+    if (pool_) {
+        pool_->Close();
+    }
+    if (cluster_) {
+        cluster_->Close();
+    }
     
-    std::lock_guard<std::mutex> lock(mutex_);
+    if (monitor_thread_.joinable()) {
+        monitor_thread_.join();
+    }
+}
+
+void RedisPool::MonitorLoop() {
+    if (cluster_) {
+        int ticks = 0;
+        while (running_) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (!running_) break;
+            
+            cluster_->Maintain();
+            // Failovers and resharding also show up as redirects, which
+            // refresh the map on demand; this catches quiet slots.
+            if (++ticks % 30 == 0) {
+                cluster_->RefreshSlots();
+            }
+        }
+        return;
+    }
+    
+    bool healthy = pool_->Live() > 0;
     
-    while (!connections_.empty()) {
-        connections_.pop();
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (!running_) break;
+        
+        // Pings only connections idle past kValidateAfterIdle and reconnects
+        // with backoff, all without blocking borrowers.
+        pool_->Maintain();
+        
+        bool now_healthy = pool_->Live() > 0;
+        if (now_healthy != healthy) {
+            if (now_healthy) {
+                LOG_INFO("Redis at " + config_.host + ":" + std::to_string(config_.port) + " is reachable again");
+            } else {
+                LOG_WARN("Redis at " + config_.host + ":" + std::to_string(config_.port) + " has no live connections");
+            }
+            healthy = now_healthy;
+        }
     }
 }
 
-void RedisPool::CreateConnection() {
+std::unique_ptr<RedisClient> RedisPool::CreateConnection() {
     auto connection = std::make_unique<RedisClient>();
     
-    if (connection->Connect(config_.host, config_.port, 
-                           config_.password, config_.db)) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        connections_.push(std::move(connection));
-    } else {
+    if (!connection->Connect(config_.host, config_.port, 
+                            config_.password, config_.db)) {
         LOG_ERROR("Failed to create Redis connection");
+        return nullptr;
     }
+    
+    // Cheap and idempotent; keeps EVALSHA from missing after a restart or
+    // SCRIPT FLUSH on the server.
+    if (connection->LoadScripts() < RedisScript::All().size()) {
+        LOG_WARN("Failed to load Redis scripts, falling back to EVAL");
+    }
+    return connection;
 }
 
 int RedisPool::GetPoolSize() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return connections_.size() + active_count_;
+    if (cluster_) return cluster_->GetPoolSize();
+    return pool_ ? static_cast<int>(pool_->Live()) : 0;
 }
 
 int RedisPool::GetActiveConnections() {
-    return active_count_;
+    if (cluster_) return cluster_->GetActiveConnections();
+    return pool_ ? static_cast<int>(pool_->InUse()) : 0;
 }
 
 int RedisPool::GetIdleConnections() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return connections_.size();
+    if (cluster_) return cluster_->GetIdleConnections();
+    return pool_ ? static_cast<int>(pool_->Idle()) : 0;
 }
 
 } // namespace ourchat
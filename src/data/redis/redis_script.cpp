@@ -0,0 +1,68 @@
+#include "../../../include/data/redis_script.h"
+#include <openssl/sha.h>
+
+namespace ourchat {
+
+namespace {
+
+std::string Sha1Hex(const std::string& data) {
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    SHA1(reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest);
+
+    static const char kHex[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(SHA_DIGEST_LENGTH * 2);
+    for (unsigned char byte : digest) {
+        hex.push_back(kHex[byte >> 4]);
+        hex.push_back(kHex[byte & 0x0f]);
+    }
+    return hex;
+}
+
+const char kSetExManySource[] = R"lua(
+for i, key in ipairs(KEYS) do
+    redis.call('SET', key, ARGV[i + 1], 'EX', ARGV[1])
+end
+return #KEYS
+)lua";
+
+const char kSlidingWindowSource[] = R"lua(
+local now = tonumber(ARGV[1])
+local window = tonumber(ARGV[2])
+redis.call('ZREMRANGEBYSCORE', KEYS[1], '-inf', now - window)
+if redis.call('ZCARD', KEYS[1]) >= tonumber(ARGV[3]) then
+    local oldest = redis.call('ZRANGE', KEYS[1], 0, 0, 'WITHSCORES')
+    if oldest[2] == nil then
+        return window
+    end
+    return math.max(tonumber(oldest[2]) + window - now, 1)
+end
+redis.call('ZADD', KEYS[1], now, ARGV[4])
+redis.call('PEXPIRE', KEYS[1], window)
+return 0
+)lua";
+
+} // namespace
+
+RedisScript::RedisScript(const char* name, const char* source)
+    : name_(name), source_(source), sha1_(Sha1Hex(source_)) {}
+
+const RedisScript& RedisScript::SetExMany() {
+    static const RedisScript script("set_ex_many", kSetExManySource);
+    return script;
+}
+
+const RedisScript& RedisScript::SlidingWindow() {
+    static const RedisScript script("sliding_window", kSlidingWindowSource);
+    return script;
+}
+
+const std::vector<const RedisScript*>& RedisScript::All() {
+    static const std::vector<const RedisScript*> scripts = {
+        &SetExMany(),
+        &SlidingWindow(),
+    };
+    return scripts;
+}
+
+} // namespace ourchat
@@ -0,0 +1,47 @@
+#include "../../include/data/storage.h"
+#include "../../include/data/memory_store.h"
+#include "../../include/data/mysql_message_store.h"
+#include "../../include/data/mysql_user_store.h"
+#include "../../include/data/redis_kv_store.h"
+#include "../../include/common/logger.h"
+
+namespace ourchat {
+
+std::shared_ptr<Storage> Storage::Instance() {
+    static std::shared_ptr<Storage> instance(new Storage());
+    return instance;
+}
+
+bool Storage::Init(const StorageConfig& config, const MessageStoreConfig& message_store_config) {
+    if (config.backend == "memory") {
+        SimulatedLatency latency(config.latency_us, config.latency_jitter_us);
+        users_ = std::make_shared<MemoryUserStore>(latency);
+        messages_ = std::make_shared<MemoryMessageStore>(latency);
+        kv_ = std::make_shared<MemoryKVStore>(latency);
+        in_memory_ = true;
+
+        LOG_WARN("Using in-memory storage, nothing is persisted (simulated latency " +
+                 std::to_string(config.latency_us) + "us + up to " +
+                 std::to_string(config.latency_jitter_us) + "us)");
+        return true;
+    }
+
+    if (config.backend != "mysql") {
+        LOG_ERROR("Unknown storage backend: " + config.backend);
+        return false;
+    }
+
+    auto messages = std::make_shared<MySQLMessageStore>();
+    if (!messages->Init(message_store_config)) {
+        LOG_ERROR("Failed to initialize message store");
+        return false;
+    }
+
+    users_ = std::make_shared<MySQLUserStore>();
+    messages_ = messages;
+    kv_ = std::make_shared<RedisKVStore>();
+    in_memory_ = false;
+    return true;
+}
+
+} // namespace ourchat
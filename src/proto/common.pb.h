@@ -9,7 +9,7 @@ class RepeatedPtrField {
 public:
     std::vector<T>& mutable_vector() { return items_; }
     const std::vector<T>& items() const { return items_; }
-    void Add() { items_.emplace_back(); }
+    T* Add() { items_.emplace_back(); return &items_.back(); }
     void Add(const T& item) { items_.push_back(item); }
     size_t size() const { return items_.size(); }
     
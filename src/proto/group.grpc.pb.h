@@ -15,6 +15,10 @@ public:
     virtual grpc::Status GetGroupInfo(grpc::ServerContext* context,
                                       const GetGroupInfoRequest* request,
                                       GetGroupInfoResponse* response) = 0;
+
+    virtual grpc::Status SendGroupMessage(grpc::ServerContext* context,
+                                          const SendGroupMessageRequest* request,
+                                          SendGroupMessageResponse* response) = 0;
 };
 
 } // namespace im
@@ -72,4 +72,41 @@ public:
     GroupInfo group_info_;
 };
 
+class SendGroupMessageRequest {
+public:
+    int64_t group_id() const { return group_id_; }
+    void set_group_id(int64_t value) { group_id_ = value; }
+    int64_t sender_id() const { return sender_id_; }
+    void set_sender_id(int64_t value) { sender_id_ = value; }
+    int message_type() const { return message_type_; }
+    void set_message_type(int value) { message_type_ = value; }
+    const std::string& content() const { return content_; }
+    void set_content(const std::string& value) { content_ = value; }
+    int64_t client_message_id() const { return client_message_id_; }
+    void set_client_message_id(int64_t value) { client_message_id_ = value; }
+    
+    int64_t group_id_ = 0;
+    int64_t sender_id_ = 0;
+    int message_type_ = 0;
+    std::string content_;
+    int64_t client_message_id_ = 0;
+};
+
+class SendGroupMessageResponse {
+public:
+    bool success() const { return success_; }
+    void set_success(bool value) { success_ = value; }
+    const std::string& message() const { return message_; }
+    void set_message(const std::string& value) { message_ = value; }
+    int64_t server_message_id() const { return server_message_id_; }
+    void set_server_message_id(int64_t value) { server_message_id_ = value; }
+    int64_t timestamp() const { return timestamp_; }
+    void set_timestamp(int64_t value) { timestamp_ = value; }
+    
+    bool success_ = false;
+    std::string message_;
+    int64_t server_message_id_ = 0;
+    int64_t timestamp_ = 0;
+};
+
 } // namespace im
@@ -15,6 +15,10 @@ public:
     virtual grpc::Status GetMessages(grpc::ServerContext* context,
                                      const GetMessagesRequest* request,
                                      GetMessagesResponse* response) = 0;
+
+    virtual grpc::Status MarkMessageRead(grpc::ServerContext* context,
+                                         const MarkMessageReadRequest* request,
+                                         MarkMessageReadResponse* response) = 0;
 };
 
 } // namespace im
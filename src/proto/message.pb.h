@@ -7,8 +7,10 @@ namespace im {
 
 class Message {
 public:
-    int64_t message_id() const { return message_id_; }
-    void set_message_id(int64_t value) { message_id_ = value; }
+    int64_t id() const { return id_; }
+    void set_id(int64_t value) { id_ = value; }
+    int64_t conversation_id() const { return conversation_id_; }
+    void set_conversation_id(int64_t value) { conversation_id_ = value; }
     int64_t sender_id() const { return sender_id_; }
     void set_sender_id(int64_t value) { sender_id_ = value; }
     int64_t receiver_id() const { return receiver_id_; }
@@ -19,13 +21,17 @@ public:
     void set_content(const std::string& value) { content_ = value; }
     int64_t timestamp() const { return timestamp_; }
     void set_timestamp(int64_t value) { timestamp_ = value; }
+    int32_t status() const { return status_; }
+    void set_status(int32_t value) { status_ = value; }
     
-    int64_t message_id_ = 0;
+    int64_t id_ = 0;
+    int64_t conversation_id_ = 0;
     int64_t sender_id_ = 0;
     int64_t receiver_id_ = 0;
     int message_type_ = 0;
     std::string content_;
     int64_t timestamp_ = 0;
+    int32_t status_ = 0;
 };
 
 class SendMessageRequest {
@@ -38,24 +44,30 @@ public:
     void set_message_type(int value) { message_type_ = value; }
     const std::string& content() const { return content_; }
     void set_content(const std::string& value) { content_ = value; }
+    int64_t client_message_id() const { return client_message_id_; }
+    void set_client_message_id(int64_t value) { client_message_id_ = value; }
     
     int64_t sender_id_ = 0;
     int64_t receiver_id_ = 0;
     int message_type_ = 0;
     std::string content_;
+    int64_t client_message_id_ = 0;
 };
 
 class SendMessageResponse {
 public:
     bool success() const { return success_; }
     void set_success(bool value) { success_ = value; }
-    int64_t message_id() const { return message_id_; }
-    void set_message_id(int64_t value) { message_id_ = value; }
+    int64_t server_message_id() const { return server_message_id_; }
+    void set_server_message_id(int64_t value) { server_message_id_ = value; }
+    int64_t timestamp() const { return timestamp_; }
+    void set_timestamp(int64_t value) { timestamp_ = value; }
     const std::string& message() const { return message_; }
     void set_message(const std::string& value) { message_ = value; }
     
     bool success_ = false;
-    int64_t message_id_ = 0;
+    int64_t server_message_id_ = 0;
+    int64_t timestamp_ = 0;
     std::string message_;
 };
 
@@ -65,26 +77,58 @@ public:
     void set_user_id(int64_t value) { user_id_ = value; }
     int64_t peer_id() const { return peer_id_; }
     void set_peer_id(int64_t value) { peer_id_ = value; }
-    int64_t timestamp() const { return timestamp_; }
-    void set_timestamp(int64_t value) { timestamp_ = value; }
+    int64_t start_time() const { return start_time_; }
+    void set_start_time(int64_t value) { start_time_ = value; }
     int32_t limit() const { return limit_; }
     void set_limit(int32_t value) { limit_ = value; }
+    int64_t before_message_id() const { return before_message_id_; }
+    void set_before_message_id(int64_t value) { before_message_id_ = value; }
     
     int64_t user_id_ = 0;
     int64_t peer_id_ = 0;
-    int64_t timestamp_ = 0;
+    int64_t start_time_ = 0;
     int32_t limit_ = 20;
+    int64_t before_message_id_ = 0;
 };
 
 class GetMessagesResponse {
 public:
     bool success() const { return success_; }
     void set_success(bool value) { success_ = value; }
+    const std::string& message() const { return message_; }
+    void set_message(const std::string& value) { message_ = value; }
+    Message* add_messages() { return messages_.Add(); }
     RepeatedPtrField<Message>* mutable_messages() { return &messages_; }
     const RepeatedPtrField<Message>& messages() const { return messages_; }
     
     bool success_ = false;
+    std::string message_;
     RepeatedPtrField<Message> messages_;
 };
 
+class MarkMessageReadRequest {
+public:
+    int64_t user_id() const { return user_id_; }
+    void set_user_id(int64_t value) { user_id_ = value; }
+    int64_t peer_id() const { return peer_id_; }
+    void set_peer_id(int64_t value) { peer_id_ = value; }
+    int64_t last_read_message_id() const { return last_read_message_id_; }
+    void set_last_read_message_id(int64_t value) { last_read_message_id_ = value; }
+    
+    int64_t user_id_ = 0;
+    int64_t peer_id_ = 0;
+    int64_t last_read_message_id_ = 0;
+};
+
+class MarkMessageReadResponse {
+public:
+    bool success() const { return success_; }
+    void set_success(bool value) { success_ = value; }
+    const std::string& message() const { return message_; }
+    void set_message(const std::string& value) { message_ = value; }
+    
+    bool success_ = false;
+    std::string message_;
+};
+
 } // namespace im
@@ -1,29 +1,163 @@
+#include <algorithm>
 #include <iostream>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <thread>
+#include <cerrno>
 #include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/health_check_service_interface.h>
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
+#include <grpcpp/resource_quota.h>
 
 #include "common/logger.h"
 #include "common/config_manager.h"
 #include "data/mysql_pool.h"
 #include "data/redis_pool.h"
+#include "data/async_redis_client.h"
+#include "data/near_cache.h"
+#include "data/storage.h"
+#include "common/id_generator.h"
+#include "common/tracing.h"
+#include "services/read_receipt_aggregator.h"
+#include "services/send_deduplicator.h"
+#include "common/jwt_keyring.h"
+#include "services/token_revocation_list.h"
+#include "services/auth_interceptor.h"
+#include "services/rate_limit_interceptor.h"
+#include "services/tracing_interceptor.h"
+#include "services/auth_service_impl.h"
+#include "services/message_service_impl.h"
+#include "services/group_service_impl.h"
+#include "services/session_service_impl.h"
+#include "services/presence_service_impl.h"
 
-std::unique_ptr<grpc::Server> g_server;
+namespace {
 
-void ShutdownHandler(int) {
-    LOG_INFO("Shutting down server...");
-    if (g_server) {
-        g_server->Shutdown();
+// Every signal is taken synchronously here with sigwait, so nothing runs in
+// signal context. SIGHUP reloads the config (the file watcher normally does
+// this already); the first SIGINT/SIGTERM wakes main through shutdown_fd to
+// drain, and a second one exits at once.
+void HandleSignals(sigset_t signals, int shutdown_fd) {
+    bool shutting_down = false;
+    int signal_number = 0;
+    while (sigwait(&signals, &signal_number) == 0) {
+        if (signal_number == SIGHUP) {
+            LOG_INFO("SIGHUP received, reloading config");
+            ourchat::ConfigManager::Instance().Reload();
+            continue;
+        }
+
+        if (shutting_down) {
+            LOG_WARN("Second shutdown signal, exiting without draining");
+            std::_Exit(1);
+        }
+        shutting_down = true;
+        LOG_INFO(std::string(strsignal(signal_number)) + " received, shutting down");
+
+        uint64_t one = 1;
+        ssize_t bytes = write(shutdown_fd, &one, sizeof(one));
+        (void)bytes;
+    }
+}
+
+constexpr int kMaxMessageBytes = 10 * 1024 * 1024;
+
+// Maps the server section onto the builder. The server is synchronous: each
+// completion queue has its own polling threads, and a call runs on a thread
+// of the pool those pollers grow, up to max_threads in total.
+void ApplyServerConfig(const ourchat::ServerConfig& server_config, grpc::ResourceQuota* quota,
+                       grpc::ServerBuilder* builder) {
+    builder->SetSyncServerOption(grpc::ServerBuilder::NUM_CQS, std::max(server_config.worker_threads, 1));
+
+    // Past max_threads, new calls fail with RESOURCE_EXHAUSTED instead of
+    // queueing behind blocked handlers.
+    if (server_config.max_threads > 0) {
+        quota->SetMaxThreads(server_config.max_threads);
+    }
+    if (server_config.memory_quota_mb > 0) {
+        quota->Resize(static_cast<size_t>(server_config.memory_quota_mb) * 1024 * 1024);
+    }
+    builder->SetResourceQuota(*quota);
+
+#ifdef GRPC_ARG_MAX_ALLOWED_INCOMING_CONNECTIONS
+    builder->AddChannelArgument(GRPC_ARG_MAX_ALLOWED_INCOMING_CONNECTIONS, server_config.max_connection);
+#else
+    // This gRPC has no connection limit; memory_quota_mb is what bounds
+    // the cost of idle connections.
+    LOG_WARN("server.max_connection is not enforced by this gRPC version");
+#endif
+    builder->AddChannelArgument(GRPC_ARG_MAX_CONCURRENT_STREAMS, server_config.max_concurrent_streams);
+
+    // Server-initiated pings detect dead clients; accepting client pings
+    // at the same interval, even between calls, keeps idle mobile
+    // connections from being closed with too_many_pings.
+    builder->AddChannelArgument(GRPC_ARG_KEEPALIVE_TIME_MS, server_config.keepalive_time * 1000);
+    builder->AddChannelArgument(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, server_config.keepalive_timeout * 1000);
+    builder->AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+    builder->AddChannelArgument(GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS,
+                                server_config.keepalive_time * 1000);
+    builder->AddChannelArgument(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+
+    builder->SetMaxReceiveMessageSize(kMaxMessageBytes);
+    builder->SetMaxSendMessageSize(kMaxMessageBytes);
+}
+
+// previous is null at startup. The file is only reopened when it changes.
+void ApplyLoggingConfig(const ourchat::LoggingConfig& logging, const ourchat::LoggingConfig* previous) {
+    auto logger = ourchat::Logger::GetInstance();
+    logger->SetLogLevel(ourchat::Logger::StringToLevel(logging.level));
+    logger->SetConsoleOutput(logging.console_output);
+    if (logging.file_output &&
+        (!previous || !previous->file_output || previous->log_file != logging.log_file)) {
+        logger->SetOutputFile(logging.log_file);
+    } else if (!logging.file_output && previous && previous->file_output) {
+        logger->CloseOutputFile();
     }
 }
 
+// Settings that change without a restart: log level and outputs, JWT
+// keys, rate limit rules and connection pool sizes. Everything else is
+// read once at startup.
+void ApplyConfigChanges(const ourchat::Config& previous, const ourchat::Config& current,
+                        bool in_memory) {
+    ApplyLoggingConfig(current.logging, &previous.logging);
+    ourchat::JWTKeyring::Instance()->Load(current.jwt);
+    ourchat::RateLimiter::Instance()->UpdateRules(current.rate_limit);
+    if (!in_memory) {
+        ourchat::MySQLPool::Instance()->Resize(current.mysql.pool_size, current.mysql.replica_pool_size);
+        ourchat::RedisPool::Instance()->Resize(current.redis.pool_size);
+    }
+}
+
+void WaitForShutdown(int shutdown_fd) {
+    uint64_t value = 0;
+    while (read(shutdown_fd, &value, sizeof(value)) < 0 && errno == EINTR) {
+    }
+}
+
+} // namespace
+
 int main(int argc, char** argv) {
-    signal(SIGINT, ShutdownHandler);
-    signal(SIGTERM, ShutdownHandler);
+    // Block the handled signals before any thread starts so every thread
+    // inherits the mask and only the signal thread receives them.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    int shutdown_fd = eventfd(0, EFD_CLOEXEC);
+    if (shutdown_fd < 0) {
+        std::cerr << "Failed to create shutdown eventfd: " << strerror(errno) << std::endl;
+        return 1;
+    }
 
     std::string config_path = "config/server.yaml";
 
@@ -37,35 +171,158 @@ int main(int argc, char** argv) {
     }
 
     auto& config = ourchat::ConfigManager::Instance();
+    ApplyLoggingConfig(config.GetLoggingConfig(), nullptr);
 
     LOG_INFO("Initializing OurChat Server...");
 
-    auto mysql_config = config.GetDatabaseConfig();
-    if (!ourchat::MySQLPool::Instance()->Init(mysql_config)) {
-        LOG_ERROR("Failed to initialize MySQL pool");
+    if (!ourchat::JWTKeyring::Instance()->Load(config.GetJWTConfig())) {
+        LOG_ERROR("Failed to load JWT keys");
         return 1;
     }
 
+    std::thread(HandleSignals, signals, shutdown_fd).detach();
+
+    ourchat::IdGenerator::Instance().Init(config.GetServerConfig().node_id);
+
+    if (!ourchat::Tracer::Instance()->Start(config.GetTracingConfig(),
+                                            config.GetServerConfig().service_name)) {
+        LOG_ERROR("Failed to start tracing");
+        return 1;
+    }
+
+    // The in-memory backend stands in for MySQL and Redis entirely.
+    auto storage_config = config.GetStorageConfig();
+    bool in_memory = storage_config.backend == "memory";
     auto redis_config = config.GetRedisConfig();
-    if (!ourchat::RedisPool::Instance()->Init(redis_config)) {
-        LOG_ERROR("Failed to initialize Redis pool");
+
+    if (!in_memory) {
+        if (!ourchat::MySQLPool::Instance()->Init(config.GetDatabaseConfig())) {
+            LOG_ERROR("Failed to initialize MySQL pool");
+            return 1;
+        }
+
+        if (!ourchat::RedisPool::Instance()->Init(redis_config)) {
+            LOG_ERROR("Failed to initialize Redis pool");
+            return 1;
+        }
+
+        if (!ourchat::AsyncRedisClient::Instance()->Start(redis_config)) {
+            LOG_ERROR("Failed to start async Redis client");
+            return 1;
+        }
+
+        auto near_cache_config = config.GetNearCacheConfig();
+        if (near_cache_config.enabled) {
+            ourchat::NearCache::Instance()->Start(redis_config, near_cache_config);
+        }
+    }
+
+    if (!ourchat::Storage::Instance()->Init(storage_config, config.GetMessageStoreConfig())) {
+        LOG_ERROR("Failed to initialize storage");
         return 1;
     }
 
+    if (!in_memory) {
+        ourchat::TokenRevocationList::Instance()->Start(redis_config);
+    }
+
+    ourchat::SendDeduplicator::Instance()->Init(config.GetSendDedupConfig());
+    ourchat::ReadReceiptAggregator::Instance()->Start();
+    ourchat::RateLimiter::Instance()->Init(config.GetRateLimitConfig());
+
+    config.Subscribe([in_memory](const ourchat::Config& previous, const ourchat::Config& current) {
+        ApplyConfigChanges(previous, current, in_memory);
+    });
+    if (!config.StartWatching()) {
+        LOG_WARN("Config file changes will only be picked up on SIGHUP");
+    }
+
     auto server_config = config.GetServerConfig();
     LOG_INFO("Server configuration loaded: " + server_config.service_name);
 
     std::string server_address = server_config.host + ":" + std::to_string(server_config.port);
 
+    // Health checks report NOT_SERVING during the lame-duck period.
+    grpc::EnableDefaultHealthCheckService(true);
+
     grpc::ServerBuilder builder;
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+    // A replacement process binds the same port while this one drains.
+    builder.AddChannelArgument(GRPC_ARG_ALLOW_REUSEPORT, 1);
+
+    grpc::ResourceQuota quota(server_config.service_name);
+    ApplyServerConfig(server_config, &quota, &builder);
 
-    g_server = builder.BuildAndStart();
+    ourchat::AuthServiceImpl auth_service;
+    ourchat::MessageServiceImpl message_service;
+    ourchat::GroupServiceImpl group_service;
+    ourchat::SessionServiceImpl session_service;
+    ourchat::PresenceServiceImpl presence_service;
 
-    LOG_INFO("Server listening on " + server_address);
+    builder.RegisterService(&auth_service);
+    builder.RegisterService(&message_service);
+    builder.RegisterService(&group_service);
+    builder.RegisterService(&session_service);
+    builder.RegisterService(&presence_service);
+
+    // Tracing wraps everything else; authentication runs next so the rate
+    // limiter sees validated user ids.
+    std::vector<std::unique_ptr<grpc::experimental::ServerInterceptorFactoryInterface>> interceptors;
+    if (ourchat::Tracer::Instance()->Enabled()) {
+        interceptors.push_back(std::make_unique<ourchat::TracingInterceptorFactory>());
+    }
+    interceptors.push_back(std::make_unique<ourchat::AuthInterceptorFactory>());
+    if (ourchat::RateLimiter::Instance()->Enabled()) {
+        interceptors.push_back(std::make_unique<ourchat::RateLimitInterceptorFactory>());
+    }
+    builder.experimental().SetInterceptorCreators(std::move(interceptors));
+
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    if (!server) {
+        LOG_ERROR("Failed to start server on " + server_address);
+        return 1;
+    }
+
+    LOG_INFO("Server listening on " + server_address + " (" +
+             std::to_string(server_config.worker_threads) + " completion queues, max threads " +
+             (server_config.max_threads > 0 ? std::to_string(server_config.max_threads) : "unlimited") + ")");
     LOG_INFO("OurChat Server started successfully");
 
-    g_server->Wait();
+    WaitForShutdown(shutdown_fd);
+
+    // Load balancers see NOT_SERVING and move new calls away while this
+    // process still answers them.
+    server->GetHealthCheckService()->SetServingStatus(false);
+    if (server_config.lame_duck_ms > 0) {
+        LOG_INFO("Lame duck for " + std::to_string(server_config.lame_duck_ms) + "ms");
+        std::this_thread::sleep_for(std::chrono::milliseconds(server_config.lame_duck_ms));
+    }
+
+    // Closes the listener, sends GOAWAY and lets in-flight calls finish;
+    // whatever is still running at the deadline is cancelled.
+    LOG_INFO("Draining calls for up to " + std::to_string(server_config.shutdown_grace_ms) + "ms");
+    server->Shutdown(std::chrono::system_clock::now() +
+                     std::chrono::milliseconds(server_config.shutdown_grace_ms));
+    server->Wait();
+
+    // No handler runs past this point: write out what they left behind,
+    // then close the backends.
+    config.StopWatching();
+    ourchat::ReadReceiptAggregator::Instance()->Stop();
+    ourchat::TokenRevocationList::Instance()->Stop();
+    ourchat::NearCache::Instance()->Stop();
+    if (!ourchat::AsyncRedisClient::Instance()->Drain(std::chrono::seconds(2))) {
+        LOG_WARN("Async Redis commands still pending at shutdown: " +
+                 std::to_string(ourchat::AsyncRedisClient::Instance()->Pending()));
+    }
+    ourchat::AsyncRedisClient::Instance()->Stop();
+    if (!in_memory) {
+        ourchat::RedisPool::Instance()->Close();
+        ourchat::MySQLPool::Instance()->Close();
+    }
+    ourchat::Tracer::Instance()->Stop();
 
+    LOG_INFO("Server stopped");
+    close(shutdown_fd);
     return 0;
 }
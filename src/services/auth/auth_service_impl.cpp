@@ -1,53 +1,90 @@
 #include "services/auth_service_impl.h"
 #include "common/logger.h"
 #include "common/crypto_util.h"
-#include "common/time_util.h"
-#include "common/jwt_util.h"
-#include "data/mysql_pool.h"
-#include "data/redis_pool.h"
+#include "common/jwt_keyring.h"
+#include "data/storage.h"
+#include "services/call_context.h"
+#include <future>
 
 namespace ourchat {
 
 AuthServiceImpl::AuthServiceImpl() {
-    mysql_pool_ = MySQLPool::Instance();
-    redis_pool_ = RedisPool::Instance();
+    users_ = Storage::Instance()->Users();
+    kv_ = Storage::Instance()->KV();
+    keyring_ = JWTKeyring::Instance();
+    revocations_ = TokenRevocationList::Instance();
     
     jwt_config_ = ConfigManager::Instance().GetJWTConfig();
+    password_config_ = ConfigManager::Instance().GetPasswordHashConfig();
+    dummy_hash_ = CryptoUtil::HashPassword(CryptoUtil::GenerateToken(),
+                                           password_config_.bcrypt_cost);
+    if (dummy_hash_.empty()) {
+        LOG_ERROR("Failed to prepare the bcrypt hash for unknown-user logins");
+    }
+    
+    hash_pool_ = std::make_unique<BoundedWorkerPool>("password_hash",
+                                                     password_config_.worker_threads,
+                                                     password_config_.max_queue,
+                                                     password_config_.pin_threads);
+}
+
+AuthServiceImpl::~AuthServiceImpl() {
+    hash_pool_->Stop();
+}
+
+bool AuthServiceImpl::RunOnHashPool(const std::function<void()>& task) {
+    // The task captures the caller's locals by reference; that is safe
+    // because the caller waits for it below.
+    auto done = std::make_shared<std::promise<void>>();
+    auto future = done->get_future();
+    if (!hash_pool_->TrySubmit([&task, done]() {
+            task();
+            done->set_value();
+        })) {
+        LOG_WARN("Password hash queue full, rejecting request");
+        return false;
+    }
+    
+    future.wait();
+    return true;
 }
 
 grpc::Status AuthServiceImpl::Register(grpc::ServerContext* context,
                                        const im::RegisterRequest* request,
                                        im::RegisterResponse* response) {
+    grpc::Status status = CallContext::Admit(context);
+    if (!status.ok()) return status;
+    
     LOG_INFO("Register request for user: " + request->username());
     
-    auto conn = mysql_pool_->GetConnection();
-    if (!conn) {
+    std::string password_hash;
+    if (!RunOnHashPool([&]() {
+            password_hash = CryptoUtil::HashPassword(request->password(),
+                                                     password_config_.bcrypt_cost);
+        })) {
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Server busy, retry later");
+    }
+    
+    if (password_hash.empty()) {
         response->set_success(false);
-        response->set_message("Database connection failed");
+        response->set_message("Failed to hash password");
         return grpc::Status::OK;
     }
     
-    std::string password_hash = CryptoUtil::HashPassword(request->password());
-    
-    std::string query = "INSERT INTO im_user (username, password_hash, email, create_time, update_time) "
-                       "VALUES ('" + request->username() + "', '" + password_hash + "', '" +
-                       request->email() + "', " + std::to_string(TimeUtil::GetCurrentTimestamp()) + 
-                       ", " + std::to_string(TimeUtil::GetCurrentTimestamp()) + ")";
-    
-    int64_t insert_id = 0;
-    if (!conn->Execute(query, insert_id)) {
+    UserRecord user;
+    user.username = request->username();
+    user.password_hash = password_hash;
+    user.email = request->email();
+    if (!users_->Create(&user)) {
         response->set_success(false);
         response->set_message("Username already exists or database error");
-        mysql_pool_->ReturnConnection(std::move(conn));
         return grpc::Status::OK;
     }
     
-    mysql_pool_->ReturnConnection(std::move(conn));
-    
     response->set_success(true);
-    response->set_user_id(insert_id);
+    response->set_user_id(user.id);
     
-    LOG_INFO("User registered successfully: " + request->username() + ", id: " + std::to_string(insert_id));
+    LOG_INFO("User registered successfully: " + request->username() + ", id: " + std::to_string(user.id));
     
     return grpc::Status::OK;
 }
@@ -55,54 +92,50 @@ grpc::Status AuthServiceImpl::Register(grpc::ServerContext* context,
 grpc::Status AuthServiceImpl::Login(grpc::ServerContext* context,
                                     const im::LoginRequest* request,
                                     im::LoginResponse* response) {
+    grpc::Status status = CallContext::Admit(context);
+    if (!status.ok()) return status;
+    
     LOG_INFO("Login request for user: " + request->username());
     
-    auto conn = mysql_pool_->GetConnection();
-    if (!conn) {
+    UserRecord user;
+    bool found = false;
+    if (!users_->FindByUsername(request->username(), &user, &found)) {
         response->set_success(false);
         response->set_message("Database connection failed");
         return grpc::Status::OK;
     }
     
-    std::string query = "SELECT id, password_hash FROM im_user WHERE username = '" + request->username() + "'";
-    auto result = conn->Query(query);
-    
-    if (!result) {
-        response->set_success(false);
-        response->set_message("User not found");
-        mysql_pool_->ReturnConnection(std::move(conn));
-        return grpc::Status::OK;
+    // An unknown user still pays for one bcrypt verification, so response
+    // times do not reveal which usernames exist.
+    int64_t user_id = user.id;
+    const std::string& stored_hash = found ? user.password_hash : dummy_hash_;
+    
+    bool valid = false;
+    std::string new_hash;
+    if (!RunOnHashPool([&]() {
+            valid = CryptoUtil::ValidatePassword(request->password(), stored_hash) && found;
+            if (valid && CryptoUtil::NeedsRehash(stored_hash, password_config_.bcrypt_cost)) {
+                new_hash = CryptoUtil::HashPassword(request->password(),
+                                                    password_config_.bcrypt_cost);
+            }
+        })) {
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Server busy, retry later");
     }
     
-    auto row = mysql_fetch_row(result.get());
-    if (!row) {
+    if (!valid) {
         response->set_success(false);
         response->set_message("Invalid credentials");
-        mysql_pool_->ReturnConnection(std::move(conn));
         return grpc::Status::OK;
     }
     
-    int64_t user_id = std::stoll(row[0]);
-    std::string stored_hash = row[1];
-    
-    mysql_pool_->ReturnConnection(std::move(conn));
-    
-    if (!CryptoUtil::ValidatePassword(request->password(), stored_hash)) {
-        response->set_success(false);
-        response->set_message("Invalid credentials");
-        return grpc::Status::OK;
+    if (!new_hash.empty()) {
+        UpdatePasswordHash(user_id, stored_hash, new_hash);
     }
     
-    auto token = JWTUtil::GenerateToken(user_id, jwt_config_.secret, jwt_config_.expire_seconds);
+    auto token = keyring_->Sign(user_id, jwt_config_.expire_seconds,
+                                revocations_->VersionForNewToken(user_id));
     
-    auto redis_conn = redis_pool_->GetConnection();
-    if (redis_conn) {
-        redis_conn->Setex("token:" + token, jwt_config_.expire_seconds, 
-                         std::to_string(user_id));
-        redis_conn->Setex("user_token:" + std::to_string(user_id), 
-                         jwt_config_.expire_seconds, token);
-        redis_pool_->ReturnConnection(std::move(redis_conn));
-    }
+    StoreToken(user_id, token);
     
     response->set_success(true);
     response->set_user_id(user_id);
@@ -113,15 +146,36 @@ grpc::Status AuthServiceImpl::Login(grpc::ServerContext* context,
     return grpc::Status::OK;
 }
 
+void AuthServiceImpl::UpdatePasswordHash(int64_t user_id, const std::string& old_hash,
+                                         const std::string& new_hash) {
+    if (users_->UpdatePasswordHash(user_id, old_hash, new_hash)) {
+        LOG_INFO("Password hash upgraded for user: " + std::to_string(user_id));
+    } else {
+        LOG_WARN("Failed to upgrade password hash for user: " + std::to_string(user_id));
+    }
+}
+
+void AuthServiceImpl::StoreToken(int64_t user_id, const std::string& token) {
+    std::string user = std::to_string(user_id);
+    if (!kv_->SetExMany({{"token:" + token, user}, {"user_token:" + user, token}},
+                        jwt_config_.expire_seconds)) {
+        LOG_WARN("Failed to store token for user: " + user);
+    }
+}
+
 grpc::Status AuthServiceImpl::Logout(grpc::ServerContext* context,
                                      const im::LogoutRequest* request,
                                      im::LogoutResponse* response) {
+    grpc::Status status = CallContext::Authorize(context, request->user_id());
+    if (!status.ok()) return status;
+    
     LOG_INFO("Logout request for user: " + std::to_string(request->user_id()));
     
-    auto redis_conn = redis_pool_->GetConnection();
-    if (redis_conn) {
-        redis_conn->Del("user_token:" + std::to_string(request->user_id()));
-        redis_pool_->ReturnConnection(std::move(redis_conn));
+    kv_->Del("user_token:" + std::to_string(request->user_id()));
+    
+    if (!revocations_->Revoke(request->user_id())) {
+        LOG_WARN("Token revocation for user " + std::to_string(request->user_id()) +
+                 " only applied locally");
     }
     
     response->set_success(true);
@@ -132,25 +186,23 @@ grpc::Status AuthServiceImpl::Logout(grpc::ServerContext* context,
 grpc::Status AuthServiceImpl::RefreshToken(grpc::ServerContext* context,
                                            const im::RefreshTokenRequest* request,
                                            im::RefreshTokenResponse* response) {
+    grpc::Status status = CallContext::Admit(context);
+    if (!status.ok()) return status;
+    
     LOG_INFO("Token refresh request");
     
-    int64_t user_id = 0;
-    if (!JWTUtil::ValidateToken(request->token(), user_id, jwt_config_.secret)) {
+    JWTClaims claims;
+    if (!keyring_->Verify(request->token(), &claims) ||
+        revocations_->IsRevoked(claims.user_id, claims.version)) {
         response->set_success(false);
         response->set_message("Invalid token");
         return grpc::Status::OK;
     }
     
-    auto new_token = JWTUtil::GenerateToken(user_id, jwt_config_.secret, jwt_config_.expire_seconds);
+    int64_t user_id = claims.user_id;
+    auto new_token = keyring_->Sign(user_id, jwt_config_.expire_seconds, claims.version);
     
-    auto redis_conn = redis_pool_->GetConnection();
-    if (redis_conn) {
-        redis_conn->Setex("token:" + new_token, jwt_config_.expire_seconds, 
-                         std::to_string(user_id));
-        redis_conn->Setex("user_token:" + std::to_string(user_id), 
-                         jwt_config_.expire_seconds, new_token);
-        redis_pool_->ReturnConnection(std::move(redis_conn));
-    }
+    StoreToken(user_id, new_token);
     
     response->set_success(true);
     response->set_token(new_token);
@@ -161,10 +213,14 @@ grpc::Status AuthServiceImpl::RefreshToken(grpc::ServerContext* context,
 grpc::Status AuthServiceImpl::ValidateToken(grpc::ServerContext* context,
                                             const im::ValidateTokenRequest* request,
                                             im::ValidateTokenResponse* response) {
-    int64_t user_id = 0;
-    if (JWTUtil::ValidateToken(request->token(), user_id, jwt_config_.secret)) {
+    grpc::Status status = CallContext::Admit(context);
+    if (!status.ok()) return status;
+    
+    JWTClaims claims;
+    if (keyring_->Verify(request->token(), &claims) &&
+        !revocations_->IsRevoked(claims.user_id, claims.version)) {
         response->set_success(true);
-        response->set_user_id(user_id);
+        response->set_user_id(claims.user_id);
     } else {
         response->set_success(false);
     }
@@ -0,0 +1,205 @@
+#include "services/token_revocation_list.h"
+#include "common/config_manager.h"
+#include "common/logger.h"
+#include "data/redis_client.h"
+#include "data/storage.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+namespace ourchat {
+
+namespace {
+
+const char kVersionsKeyPrefix[] = "token_versions:";
+const char kChannel[] = "token_revocations";
+
+constexpr int64_t kDaySeconds = 86400;
+
+constexpr int kMinBackoffMs = 100;
+constexpr int kMaxBackoffMs = 5000;
+
+int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// The hash holding revocations made during the given UTC day.
+std::string BucketKey(int64_t day) {
+    return kVersionsKeyPrefix + std::to_string(day);
+}
+
+int64_t ParseVersion(const std::string& value) {
+    return value.empty() ? 0 : std::strtoll(value.c_str(), nullptr, 10);
+}
+
+} // namespace
+
+std::shared_ptr<TokenRevocationList> TokenRevocationList::Instance() {
+    static std::shared_ptr<TokenRevocationList> instance(new TokenRevocationList());
+    return instance;
+}
+
+TokenRevocationList::TokenRevocationList() {
+    JWTConfig jwt_config = ConfigManager::Instance().GetJWTConfig();
+    retention_seconds_ = std::max(jwt_config.expire_seconds, jwt_config.refresh_expire_seconds);
+}
+
+TokenRevocationList::~TokenRevocationList() {
+    Stop();
+}
+
+void TokenRevocationList::Start(const RedisConfig& config) {
+    if (running_.exchange(true)) return;
+
+    config_ = config;
+    subscriber_thread_ = std::thread([this]() { Run(); });
+}
+
+void TokenRevocationList::Stop() {
+    if (!running_.exchange(false)) return;
+
+    wait_cv_.notify_all();
+    if (subscriber_thread_.joinable()) {
+        subscriber_thread_.join();
+    }
+}
+
+TokenRevocationList::Shard& TokenRevocationList::GetShard(int64_t user_id) {
+    return shards_[static_cast<uint64_t>(user_id) % kShardCount];
+}
+
+int64_t TokenRevocationList::LocalVersion(int64_t user_id) {
+    Shard& shard = GetShard(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.versions.find(user_id);
+    return it == shard.versions.end() ? 0 : it->second;
+}
+
+void TokenRevocationList::Apply(int64_t user_id, int64_t version) {
+    Shard& shard = GetShard(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (++shard.writes % kPruneInterval == 0) {
+        PruneLocked(shard);
+    }
+
+    int64_t& current = shard.versions[user_id];
+    current = std::max(current, version);
+}
+
+void TokenRevocationList::PruneLocked(Shard& shard) {
+    // A day of slack covers clocks that disagree between nodes.
+    int64_t cutoff = NowMs() - (retention_seconds_ + kDaySeconds) * 1000;
+    for (auto it = shard.versions.begin(); it != shard.versions.end();) {
+        it = it->second < cutoff ? shard.versions.erase(it) : std::next(it);
+    }
+}
+
+bool TokenRevocationList::IsRevoked(int64_t user_id, int64_t token_version) {
+    return token_version < LocalVersion(user_id);
+}
+
+int64_t TokenRevocationList::VersionForNewToken(int64_t user_id) {
+    int64_t version = LocalVersion(user_id);
+
+    // Anything older than yesterday has long since been published.
+    auto kv = Storage::Instance()->KV();
+    std::string field = std::to_string(user_id);
+    int64_t today = NowMs() / 1000 / kDaySeconds;
+    int64_t remote = std::max(ParseVersion(kv->HGet(BucketKey(today), field)),
+                              ParseVersion(kv->HGet(BucketKey(today - 1), field)));
+
+    if (remote > version) {
+        Apply(user_id, remote);
+        version = remote;
+    }
+    return version;
+}
+
+bool TokenRevocationList::Revoke(int64_t user_id) {
+    int64_t now_ms = NowMs();
+    auto kv = Storage::Instance()->KV();
+    std::string bucket = BucketKey(now_ms / 1000 / kDaySeconds);
+    std::string field = std::to_string(user_id);
+
+    // Above every version handed out so far, whether it came from this
+    // node, today's bucket or an earlier one.
+    int64_t stored = ParseVersion(kv->HGet(bucket, field));
+    int64_t target = std::max({now_ms, LocalVersion(user_id) + 1, stored + 1});
+
+    // Apply locally first so this node rejects old tokens even if Redis is down.
+    Apply(user_id, target);
+
+    // An increment rather than a set, so concurrent revocations only ever
+    // raise the stored version.
+    int64_t version = kv->HIncrBy(bucket, field, target - stored);
+    if (version > 0) {
+        kv->Expire(bucket, static_cast<int>(retention_seconds_ + kDaySeconds));
+        Apply(user_id, version);
+        kv->Publish(kChannel, field + ":" + std::to_string(version));
+    }
+
+    return version > 0;
+}
+
+void TokenRevocationList::Resync() {
+    auto kv = Storage::Instance()->KV();
+    int64_t today = NowMs() / 1000 / kDaySeconds;
+    int64_t days = (retention_seconds_ + kDaySeconds - 1) / kDaySeconds + 1;
+
+    size_t count = 0;
+    for (int64_t day = today - days; day <= today; day++) {
+        auto versions = kv->HGetAll(BucketKey(day));
+        for (const auto& entry : versions) {
+            Apply(std::strtoll(entry.first.c_str(), nullptr, 10), ParseVersion(entry.second));
+        }
+        count += versions.size();
+    }
+
+    LOG_INFO("Token revocation list synced, " + std::to_string(count) + " revocations");
+}
+
+void TokenRevocationList::Backoff(int* delay_ms) {
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    wait_cv_.wait_for(lock, std::chrono::milliseconds(*delay_ms), [this]() { return !running_; });
+    *delay_ms = std::min(*delay_ms * 2, kMaxBackoffMs);
+}
+
+void TokenRevocationList::Run() {
+    int delay_ms = kMinBackoffMs;
+
+    while (running_) {
+        RedisClient client;
+        if (!client.Connect(config_.host, config_.port, config_.password, config_.db) ||
+            !client.Subscribe(kChannel)) {
+            LOG_WARN("Token revocation subscriber cannot reach Redis, retrying in " +
+                     std::to_string(delay_ms) + "ms");
+            Backoff(&delay_ms);
+            continue;
+        }
+        delay_ms = kMinBackoffMs;
+
+        // Subscribed first, so nothing published during the reload is missed.
+        Resync();
+
+        std::string channel;
+        std::string message;
+        while (running_) {
+            int result = client.WaitMessage(500, &channel, &message);
+            if (result < 0) {
+                LOG_WARN("Token revocation subscription lost, reconnecting");
+                break;
+            }
+            if (result == 0) continue;
+
+            size_t colon = message.find(':');
+            if (colon == std::string::npos) continue;
+            Apply(std::strtoll(message.c_str(), nullptr, 10),
+                  std::strtoll(message.c_str() + colon + 1, nullptr, 10));
+        }
+    }
+}
+
+} // namespace ourchat
@@ -1,11 +1,21 @@
 #include "services/group_service_impl.h"
 #include "common/logger.h"
+#include "data/storage.h"
+#include "services/call_context.h"
 
 namespace ourchat {
 
+GroupServiceImpl::GroupServiceImpl() {
+    message_store_ = Storage::Instance()->Messages();
+    deduplicator_ = SendDeduplicator::Instance();
+}
+
 grpc::Status GroupServiceImpl::CreateGroup(grpc::ServerContext* context,
                                             const im::CreateGroupRequest* request,
                                             im::CreateGroupResponse* response) {
+    grpc::Status status = CallContext::Authorize(context, request->owner_id());
+    if (!status.ok()) return status;
+    
     LOG_INFO("CreateGroup: name=" + request->group_name());
     response->set_success(true);
     response->set_group_id(1001);
@@ -15,8 +25,75 @@ grpc::Status GroupServiceImpl::CreateGroup(grpc::ServerContext* context,
 grpc::Status GroupServiceImpl::GetGroupInfo(grpc::ServerContext* context,
                                              const im::GetGroupInfoRequest* request,
                                              im::GetGroupInfoResponse* response) {
+    grpc::Status status = CallContext::Admit(context);
+    if (!status.ok()) return status;
+    
     LOG_INFO("GetGroupInfo: group_id=" + std::to_string(request->group_id()));
     return grpc::Status::OK;
 }
 
+grpc::Status GroupServiceImpl::SendGroupMessage(grpc::ServerContext* context,
+                                                 const im::SendGroupMessageRequest* request,
+                                                 im::SendGroupMessageResponse* response) {
+    grpc::Status status = CallContext::Authorize(context, request->sender_id());
+    if (!status.ok()) return status;
+    
+    LOG_INFO("SendGroupMessage: from=" + std::to_string(request->sender_id()) +
+             " group=" + std::to_string(request->group_id()));
+    
+    if (request->sender_id() <= 0 || request->group_id() <= 0) {
+        response->set_success(false);
+        response->set_message("Invalid sender or group");
+        return grpc::Status::OK;
+    }
+    
+    bool member = false;
+    if (!message_store_->IsGroupMember(request->group_id(), request->sender_id(), &member)) {
+        response->set_success(false);
+        response->set_message("Failed to check group membership");
+        return grpc::Status::OK;
+    }
+    if (!member) {
+        return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Not a member of this group");
+    }
+    
+    SendDeduplicator::Result original;
+    auto claim = deduplicator_->Begin(SendDeduplicator::Scope::kGroup, request->sender_id(),
+                                      request->client_message_id(), &original);
+    if (claim == SendDeduplicator::Claim::kDuplicate) {
+        response->set_success(true);
+        response->set_server_message_id(original.server_message_id);
+        response->set_timestamp(original.timestamp);
+        return grpc::Status::OK;
+    }
+    if (claim == SendDeduplicator::Claim::kInFlight) {
+        response->set_success(false);
+        response->set_message("Message is still being sent, retry later");
+        return grpc::Status::OK;
+    }
+    
+    GroupMessageRecord record;
+    record.group_id = request->group_id();
+    record.sender_id = request->sender_id();
+    record.message_type = request->message_type();
+    record.content = request->content();
+    
+    if (!message_store_->InsertGroup(&record)) {
+        deduplicator_->Abort(SendDeduplicator::Scope::kGroup, request->sender_id(),
+                             request->client_message_id());
+        response->set_success(false);
+        response->set_message("Failed to store message");
+        return grpc::Status::OK;
+    }
+    
+    deduplicator_->Complete(SendDeduplicator::Scope::kGroup, request->sender_id(),
+                            request->client_message_id(), {record.id, record.create_time});
+    
+    response->set_success(true);
+    response->set_server_message_id(record.id);
+    response->set_timestamp(record.create_time);
+    
+    return grpc::Status::OK;
+}
+
 }
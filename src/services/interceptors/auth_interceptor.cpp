@@ -0,0 +1,115 @@
+#include "services/auth_interceptor.h"
+#include "common/time_util.h"
+#include <algorithm>
+#include <functional>
+
+namespace ourchat {
+
+namespace {
+
+const char kAuthorizationKey[] = "authorization";
+
+const char* const kPublicMethods[] = {
+    "/im.AuthService/Register",
+    "/im.AuthService/Login",
+    "/im.AuthService/RefreshToken",
+    "/im.AuthService/ValidateToken",
+};
+
+std::string_view BearerToken(const std::multimap<grpc::string_ref, grpc::string_ref>* metadata) {
+    auto it = metadata->find(kAuthorizationKey);
+    if (it == metadata->end()) return std::string_view();
+
+    std::string_view value(it->second.data(), it->second.size());
+    if (value.size() < 7) return std::string_view();
+    std::string_view scheme = value.substr(0, 7);
+    if (scheme != "Bearer " && scheme != "bearer ") return std::string_view();
+    return value.substr(7);
+}
+
+} // namespace
+
+AuthInterceptor::AuthInterceptor(grpc::experimental::ServerRpcInfo* info,
+                                 AuthInterceptorFactory* factory)
+    : info_(info), factory_(factory) {}
+
+void AuthInterceptor::Intercept(grpc::experimental::InterceptorBatchMethods* methods) {
+    using grpc::experimental::InterceptionHookPoints;
+    const grpc::ServerContextBase* context = info_->server_context();
+
+    if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::POST_RECV_INITIAL_METADATA)) {
+        CallContext::Begin(context);
+
+        auto* metadata = methods->GetRecvInitialMetadata();
+        metadata->erase(kUserIdMetadataKey);
+
+        if (!AuthInterceptorFactory::IsPublic(info_->method())) {
+            std::string_view token = BearerToken(metadata);
+            int64_t user_id = token.empty() ? 0 : factory_->Authenticate(token);
+            if (user_id == 0) {
+                rejected_ = true;
+                CallContext::Reject(context, grpc::Status(grpc::StatusCode::UNAUTHENTICATED,
+                                                          "Invalid or missing token"));
+            } else {
+                user_id_ = std::to_string(user_id);
+                metadata->emplace(grpc::string_ref(kUserIdMetadataKey), grpc::string_ref(user_id_));
+            }
+        }
+    }
+
+    if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_STATUS) && rejected_) {
+        methods->ModifySendStatus(grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Invalid or missing token"));
+        CallContext::Finish(context);
+    }
+
+    methods->Proceed();
+}
+
+AuthInterceptorFactory::AuthInterceptorFactory()
+    : keyring_(JWTKeyring::Instance()), revocations_(TokenRevocationList::Instance()) {}
+
+grpc::experimental::Interceptor* AuthInterceptorFactory::CreateServerInterceptor(
+    grpc::experimental::ServerRpcInfo* info) {
+    return new AuthInterceptor(info, this);
+}
+
+bool AuthInterceptorFactory::IsPublic(std::string_view method) {
+    // Health checks and reflection need no identity either.
+    if (method.rfind("/grpc.", 0) == 0) return true;
+    return std::find(std::begin(kPublicMethods), std::end(kPublicMethods), method) != std::end(kPublicMethods);
+}
+
+int64_t AuthInterceptorFactory::Authenticate(std::string_view token) {
+    int64_t now = TimeUtil::GetCurrentTimestamp();
+    uint64_t hash = std::hash<std::string_view>()(token);
+    Shard& shard = shards_[hash % kShardCount];
+
+    int64_t user_id = 0;
+    int64_t version = 0;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.tokens.find(hash);
+        if (it != shard.tokens.end() && it->second.token == token && it->second.expires_at > now) {
+            user_id = it->second.user_id;
+            version = it->second.version;
+        }
+    }
+
+    if (user_id == 0) {
+        JWTClaims claims;
+        if (!keyring_->Verify(token, &claims)) return 0;
+        user_id = claims.user_id;
+        version = claims.version;
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.tokens.size() >= kShardCapacity) {
+            shard.tokens.clear();
+        }
+        shard.tokens[hash] = CachedToken{std::string(token), user_id, version,
+                                         std::min(claims.exp, now + kCacheSeconds)};
+    }
+
+    return revocations_->IsRevoked(user_id, version) ? 0 : user_id;
+}
+
+} // namespace ourchat
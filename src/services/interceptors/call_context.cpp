@@ -0,0 +1,70 @@
+#include "services/call_context.h"
+#include <cstdlib>
+#include <string>
+
+namespace ourchat {
+
+namespace {
+
+// The synchronous server runs a call's receive interceptors and then its
+// handler on the same thread, so the handler finds its own rejection here.
+struct Rejection {
+    const grpc::ServerContextBase* context = nullptr;
+    grpc::Status status;
+};
+
+thread_local Rejection rejection;
+
+} // namespace
+
+int64_t CallContext::UserId(const grpc::ServerContext* context) {
+    const auto& metadata = context->client_metadata();
+    auto it = metadata.find(kUserIdMetadataKey);
+    if (it == metadata.end()) return 0;
+
+    std::string value(it->second.data(), it->second.size());
+    return std::strtoll(value.c_str(), nullptr, 10);
+}
+
+grpc::Status CallContext::Admit(const grpc::ServerContext* context) {
+    grpc::Status status;
+    if (Rejected(context, &status)) return status;
+    return grpc::Status::OK;
+}
+
+grpc::Status CallContext::Authorize(const grpc::ServerContext* context, int64_t claimed_user_id) {
+    grpc::Status status = Admit(context);
+    if (!status.ok()) return status;
+
+    if (claimed_user_id == 0) {
+        return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Request has no user id");
+    }
+    if (claimed_user_id != UserId(context)) {
+        return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "User id does not match the token");
+    }
+    return grpc::Status::OK;
+}
+
+void CallContext::Begin(const grpc::ServerContextBase* context) {
+    rejection.context = nullptr;
+}
+
+void CallContext::Reject(const grpc::ServerContextBase* context, const grpc::Status& status) {
+    if (rejection.context == context) return;
+    rejection.context = context;
+    rejection.status = status;
+}
+
+bool CallContext::Rejected(const grpc::ServerContextBase* context, grpc::Status* status) {
+    if (rejection.context != context) return false;
+    if (status) *status = rejection.status;
+    return true;
+}
+
+void CallContext::Finish(const grpc::ServerContextBase* context) {
+    if (rejection.context == context) {
+        rejection.context = nullptr;
+    }
+}
+
+} // namespace ourchat
@@ -0,0 +1,52 @@
+#include "services/rate_limit_interceptor.h"
+#include <cstdlib>
+#include <string>
+
+namespace ourchat {
+
+namespace {
+
+int64_t UserIdFromMetadata(const std::multimap<grpc::string_ref, grpc::string_ref>* metadata) {
+    if (!metadata) return 0;
+    auto it = metadata->find(kUserIdMetadataKey);
+    if (it == metadata->end()) return 0;
+
+    std::string value(it->second.data(), it->second.size());
+    return std::strtoll(value.c_str(), nullptr, 10);
+}
+
+} // namespace
+
+RateLimitInterceptor::RateLimitInterceptor(grpc::experimental::ServerRpcInfo* info)
+    : info_(info), limiter_(RateLimiter::Instance()) {}
+
+void RateLimitInterceptor::Intercept(grpc::experimental::InterceptorBatchMethods* methods) {
+    using grpc::experimental::InterceptionHookPoints;
+    const grpc::ServerContextBase* context = info_->server_context();
+
+    if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::POST_RECV_INITIAL_METADATA)) {
+        // Calls already rejected still spend their IP token, so floods of
+        // bad tokens are limited too.
+        int64_t user_id = UserIdFromMetadata(methods->GetRecvInitialMetadata());
+        bool admitted = limiter_->Admit(info_->method(), context->peer(), user_id);
+        if (!admitted && !CallContext::Rejected(context)) {
+            rejected_ = true;
+            CallContext::Reject(context, grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                                      "Rate limit exceeded"));
+        }
+    }
+
+    if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_STATUS) && rejected_) {
+        methods->ModifySendStatus(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Rate limit exceeded"));
+        CallContext::Finish(context);
+    }
+
+    methods->Proceed();
+}
+
+grpc::experimental::Interceptor* RateLimitInterceptorFactory::CreateServerInterceptor(
+    grpc::experimental::ServerRpcInfo* info) {
+    return new RateLimitInterceptor(info);
+}
+
+} // namespace ourchat
@@ -0,0 +1,192 @@
+#include "services/rate_limiter.h"
+#include "common/logger.h"
+#include "data/async_redis_client.h"
+#include "data/redis_pool.h"
+#include <algorithm>
+#include <functional>
+#include <random>
+
+namespace ourchat {
+
+namespace {
+
+// A bucket word is (time_ms << 24) | millitokens; zero means never used.
+constexpr int kTokenBits = 24;
+constexpr uint64_t kTokenMask = (1ULL << kTokenBits) - 1;
+constexpr uint64_t kTokenScale = 1000;
+constexpr int kMaxBurst = static_cast<int>(kTokenMask / kTokenScale);
+
+uint64_t MixHash(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// "ipv4:10.0.0.1:5412" -> "10.0.0.1", "ipv6:[::1]:5412" -> "[::1]".
+std::string_view PeerAddress(std::string_view peer) {
+    size_t scheme = peer.find(':');
+    if (scheme == std::string_view::npos) return peer;
+    std::string_view scheme_name = peer.substr(0, scheme);
+    if (scheme_name != "ipv4" && scheme_name != "ipv6") return peer;
+
+    std::string_view address = peer.substr(scheme + 1);
+    if (!address.empty() && address.front() == '[') {
+        size_t close = address.find(']');
+        return close == std::string_view::npos ? address : address.substr(0, close + 1);
+    }
+    size_t port = address.rfind(':');
+    return port == std::string_view::npos ? address : address.substr(0, port);
+}
+
+} // namespace
+
+std::shared_ptr<RateLimiter> RateLimiter::Instance() {
+    static std::shared_ptr<RateLimiter> instance(new RateLimiter());
+    return instance;
+}
+
+void RateLimiter::BucketTable::Init(size_t size) {
+    size_t capacity = 1;
+    while (capacity < size) capacity <<= 1;
+
+    buckets_.reset(new std::atomic<uint64_t>[capacity]);
+    for (size_t i = 0; i < capacity; i++) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+    mask_ = capacity - 1;
+}
+
+bool RateLimiter::BucketTable::Take(uint64_t key_hash, const RateLimitRule& rule, uint64_t now_ms) {
+    std::atomic<uint64_t>& bucket = buckets_[key_hash & mask_];
+    uint64_t capacity = static_cast<uint64_t>(std::min(std::max(rule.burst, 1), kMaxBurst)) * kTokenScale;
+
+    uint64_t state = bucket.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t tokens = capacity;
+        uint64_t stamp = now_ms;
+        if (state != 0) {
+            uint64_t last = state >> kTokenBits;
+            tokens = std::min(state & kTokenMask, capacity);
+            // Rate is tokens per second, i.e. millitokens per millisecond.
+            double refill = now_ms > last ? static_cast<double>(now_ms - last) * rule.rate : 0;
+            if (refill >= 1) {
+                tokens = static_cast<uint64_t>(std::min(static_cast<double>(tokens) + refill,
+                                                        static_cast<double>(capacity)));
+            } else {
+                // Keep the old stamp so sub-millitoken refills accumulate.
+                stamp = last;
+            }
+        }
+
+        if (tokens < kTokenScale) return false;
+
+        uint64_t next = (stamp << kTokenBits) | (tokens - kTokenScale);
+        if (bucket.compare_exchange_weak(state, next, std::memory_order_relaxed)) return true;
+    }
+}
+
+void RateLimiter::Init(const RateLimitConfig& config) {
+    config_ = config;
+    std::atomic_store(&rules_, std::make_shared<const RateLimitConfig>(config));
+    start_ = std::chrono::steady_clock::now();
+    window_seed_ = (static_cast<uint64_t>(std::random_device()()) << 32) | std::random_device()();
+    if (!config_.enabled) return;
+
+    size_t size = static_cast<size_t>(std::max(config_.table_size, 1));
+    ip_buckets_.Init(size);
+    user_buckets_.Init(size);
+    method_buckets_.Init(size);
+    global_blocks_.Init(size);
+
+    LOG_INFO("Rate limiter enabled: per_ip=" + std::to_string(config_.per_ip.rate) +
+             "/s per_user=" + std::to_string(config_.per_user.rate) + "/s" +
+             (config_.distributed ? ", distributed" : ""));
+}
+
+void RateLimiter::UpdateRules(const RateLimitConfig& config) {
+    if (config.enabled != config_.enabled || config.table_size != config_.table_size) {
+        LOG_WARN("rate_limit.enabled and rate_limit.table_size take effect after a restart");
+    }
+    if (!config_.enabled) return;
+
+    std::atomic_store(&rules_, std::make_shared<const RateLimitConfig>(config));
+    LOG_INFO("Rate limits updated: per_ip=" + std::to_string(config.per_ip.rate) +
+             "/s per_user=" + std::to_string(config.per_user.rate) + "/s" +
+             (config.distributed ? ", distributed" : ""));
+}
+
+uint64_t RateLimiter::NowMs() const {
+    // Offset by one so a stamp is never zero.
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start_).count()) + 1;
+}
+
+bool RateLimiter::Admit(std::string_view method, std::string_view peer, int64_t user_id) {
+    if (!config_.enabled) return true;
+
+    std::shared_ptr<const RateLimitConfig> rules = std::atomic_load(&rules_);
+    uint64_t now = NowMs();
+    std::string_view address = PeerAddress(peer);
+    uint64_t address_hash = std::hash<std::string_view>()(address);
+
+    bool admitted = ip_buckets_.Take(address_hash, rules->per_ip, now);
+
+    if (admitted && !rules->methods.empty()) {
+        auto it = rules->methods.find(method);
+        if (it != rules->methods.end()) {
+            uint64_t method_hash = MixHash(std::hash<std::string_view>()(method) ^ address_hash);
+            admitted = method_buckets_.Take(method_hash, it->second, now);
+        }
+    }
+
+    if (admitted && user_id > 0) {
+        admitted = user_buckets_.Take(MixHash(static_cast<uint64_t>(user_id)), rules->per_user, now);
+        if (admitted && rules->distributed) {
+            admitted = AdmitGlobal(user_id, *rules, now);
+        }
+    }
+
+    if (!admitted) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return admitted;
+}
+
+bool RateLimiter::AdmitGlobal(int64_t user_id, const RateLimitConfig& rules, uint64_t now) {
+    std::atomic<uint64_t>& blocked_until = global_blocks_.At(MixHash(~static_cast<uint64_t>(user_id)));
+    if (blocked_until.load(std::memory_order_relaxed) > now) return false;
+
+    std::string key = "rate:{" + std::to_string(user_id) + "}";
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // Unique across calls in the same millisecond, here and on other nodes.
+    std::string member = std::to_string(now_ms) + ":" + std::to_string(
+        MixHash(window_seed_ + window_sequence_.fetch_add(1, std::memory_order_relaxed)));
+    std::vector<std::string> args = {std::to_string(now_ms), std::to_string(rules.window_ms),
+                                     std::to_string(rules.window_limit), member};
+
+    auto redis_pool = RedisPool::Instance();
+    if (!redis_pool->IsCluster()) {
+        auto on_reply = [this, &blocked_until](const redisReply* reply) {
+            if (reply && reply->type == REDIS_REPLY_INTEGER && reply->integer > 0) {
+                blocked_until.store(NowMs() + static_cast<uint64_t>(reply->integer),
+                                    std::memory_order_relaxed);
+            }
+        };
+        AsyncRedisClient::Instance()->EvalScript(RedisScript::SlidingWindow(), {key}, args, on_reply);
+        return true;
+    }
+
+    auto redis_conn = redis_pool->GetConnection(key);
+    if (!redis_conn) return true;
+
+    auto reply = redis_conn->EvalScript(RedisScript::SlidingWindow(), {key},
+                                        {args.begin(), args.end()});
+    if (!reply || reply->type != REDIS_REPLY_INTEGER || reply->integer <= 0) return true;
+
+    blocked_until.store(now + static_cast<uint64_t>(reply->integer), std::memory_order_relaxed);
+    return false;
+}
+
+} // namespace ourchat
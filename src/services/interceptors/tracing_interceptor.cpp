@@ -0,0 +1,51 @@
+#include "services/tracing_interceptor.h"
+#include <string_view>
+
+namespace ourchat {
+
+namespace {
+
+const char kTraceparentKey[] = "traceparent";
+
+} // namespace
+
+TracingInterceptor::TracingInterceptor(grpc::experimental::ServerRpcInfo* info)
+    : info_(info) {}
+
+void TracingInterceptor::Intercept(grpc::experimental::InterceptorBatchMethods* methods) {
+    using grpc::experimental::InterceptionHookPoints;
+
+    if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::POST_RECV_INITIAL_METADATA)) {
+        auto* metadata = methods->GetRecvInitialMetadata();
+        std::string_view traceparent;
+        auto it = metadata->find(kTraceparentKey);
+        if (it != metadata->end()) {
+            traceparent = std::string_view(it->second.data(), it->second.size());
+        }
+
+        span_ = Span::StartServer(info_->method(), traceparent);
+        if (span_) {
+            span_->SetAttribute("rpc.system", "grpc");
+            span_->SetAttribute("rpc.method", info_->method());
+            span_->SetAttribute("net.peer", info_->server_context()->peer());
+        }
+    }
+
+    if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_STATUS) && span_) {
+        grpc::Status status = methods->GetSendStatus();
+        span_->SetAttribute("rpc.grpc.status_code", static_cast<int64_t>(status.error_code()));
+        if (!status.ok()) {
+            span_->SetError(status.error_message());
+        }
+        span_->End();
+    }
+
+    methods->Proceed();
+}
+
+grpc::experimental::Interceptor* TracingInterceptorFactory::CreateServerInterceptor(
+    grpc::experimental::ServerRpcInfo* info) {
+    return new TracingInterceptor(info);
+}
+
+} // namespace ourchat
@@ -1,16 +1,107 @@
 #include "services/message_service_impl.h"
+#include "common/config_manager.h"
 #include "common/logger.h"
+#include "data/storage.h"
+#include "services/call_context.h"
+#include <algorithm>
 
 namespace ourchat {
 
+namespace {
+
+constexpr int kDefaultPageSize = 20;
+constexpr int kMaxPageSize = 100;
+
+// Largest user id that still packs into a conversation id with bit 63 clear.
+constexpr uint64_t kMaxPackedUserId = 0x7fffffffULL;
+
+uint64_t Mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+MessageServiceImpl::MessageServiceImpl() {
+    message_store_ = Storage::Instance()->Messages();
+    read_receipts_ = ReadReceiptAggregator::Instance();
+    deduplicator_ = SendDeduplicator::Instance();
+    tail_cache_enabled_ = ConfigManager::Instance().GetMessageStoreConfig().tail_cache;
+}
+
+int64_t MessageServiceImpl::ConversationId(int64_t user_a, int64_t user_b) {
+    uint64_t lo = static_cast<uint64_t>(std::min(user_a, user_b));
+    uint64_t hi = static_cast<uint64_t>(std::max(user_a, user_b));
+    if (lo <= kMaxPackedUserId && hi <= kMaxPackedUserId) {
+        return static_cast<int64_t>((lo << 32) | hi);
+    }
+    // Packed ids never have bit 63 set, so hashed ids cannot collide with them.
+    uint64_t h = Mix(Mix(lo) ^ (hi * 0x9E3779B97F4A7C15ULL));
+    return static_cast<int64_t>(h | (1ULL << 63));
+}
+
 grpc::Status MessageServiceImpl::SendMessage(grpc::ServerContext* context,
                                               const im::SendMessageRequest* request,
                                               im::SendMessageResponse* response) {
+    grpc::Status status = CallContext::Authorize(context, request->sender_id());
+    if (!status.ok()) return status;
+    
     LOG_INFO("SendMessage: from=" + std::to_string(request->sender_id()) + 
              " to=" + std::to_string(request->receiver_id()));
     
+    if (request->sender_id() <= 0 || request->receiver_id() <= 0) {
+        response->set_success(false);
+        response->set_message("Invalid sender or receiver");
+        return grpc::Status::OK;
+    }
+    
+    SendDeduplicator::Result original;
+    auto claim = deduplicator_->Begin(SendDeduplicator::Scope::kSingle, request->sender_id(),
+                                      request->client_message_id(), &original);
+    if (claim == SendDeduplicator::Claim::kDuplicate) {
+        response->set_success(true);
+        response->set_server_message_id(original.server_message_id);
+        response->set_timestamp(original.timestamp);
+        return grpc::Status::OK;
+    }
+    if (claim == SendDeduplicator::Claim::kInFlight) {
+        response->set_success(false);
+        response->set_message("Message is still being sent, retry later");
+        return grpc::Status::OK;
+    }
+    
+    MessageRecord record;
+    record.conversation_id = ConversationId(request->sender_id(), request->receiver_id());
+    record.sender_id = request->sender_id();
+    record.receiver_id = request->receiver_id();
+    record.message_type = request->message_type();
+    record.content = request->content();
+    record.status = 1;
+    
+    if (!message_store_->InsertSingle(&record)) {
+        deduplicator_->Abort(SendDeduplicator::Scope::kSingle, request->sender_id(),
+                             request->client_message_id());
+        response->set_success(false);
+        response->set_message("Failed to store message");
+        return grpc::Status::OK;
+    }
+    
+    deduplicator_->Complete(SendDeduplicator::Scope::kSingle, request->sender_id(),
+                            request->client_message_id(), {record.id, record.create_time});
+    
+    if (tail_cache_enabled_) {
+        im::Message message;
+        ToMessage(record, &message);
+        tail_cache_.Append(message);
+    }
+    
     response->set_success(true);
-    response->set_message_id(1001);
+    response->set_server_message_id(record.id);
+    response->set_timestamp(record.create_time);
     
     return grpc::Status::OK;
 }
@@ -18,9 +109,84 @@ grpc::Status MessageServiceImpl::SendMessage(grpc::ServerContext* context,
 grpc::Status MessageServiceImpl::GetMessages(grpc::ServerContext* context,
                                               const im::GetMessagesRequest* request,
                                               im::GetMessagesResponse* response) {
-    LOG_INFO("GetMessages: user_id=" + std::to_string(request->user_id()));
+    grpc::Status status = CallContext::Authorize(context, request->user_id());
+    if (!status.ok()) return status;
     
+    LOG_INFO("GetMessages: user_id=" + std::to_string(request->user_id()) +
+             " peer_id=" + std::to_string(request->peer_id()));
+    
+    int limit = request->limit() > 0 ? std::min(request->limit(), kMaxPageSize) : kDefaultPageSize;
+    int64_t conversation_id = ConversationId(request->user_id(), request->peer_id());
+    int64_t before_id = request->before_message_id();
+    
+    // start_time is only honoured for the first page of legacy clients; the
+    // tail cache is keyed purely on message ids.
+    int64_t start_time = before_id > 0 ? 0 : request->start_time();
+    
+    std::vector<im::Message> messages;
+    bool cached = tail_cache_enabled_ && start_time == 0 &&
+                  tail_cache_.GetPage(conversation_id, before_id, limit, &messages);
+    
+    if (!cached) {
+        std::vector<MessageRecord> records;
+        bool current = false;
+        if (!message_store_->QuerySingle(request->user_id(), conversation_id, before_id,
+                                          start_time, limit, &records, &current)) {
+            response->set_success(false);
+            response->set_message("Failed to load messages");
+            return grpc::Status::OK;
+        }
+        
+        messages.resize(records.size());
+        for (size_t i = 0; i < records.size(); i++) {
+            ToMessage(records[i], &messages[i]);
+        }
+        
+        // A page from a lagging replica may miss the newest messages, and
+        // once cached it would be served long after the replica catches up.
+        if (tail_cache_enabled_ && current && before_id == 0 && start_time == 0) {
+            tail_cache_.Fill(conversation_id, messages,
+                             messages.size() < static_cast<size_t>(limit));
+        }
+    }
+    
+    for (auto& message : messages) {
+        *response->add_messages() = std::move(message);
+    }
+    response->set_success(true);
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MessageServiceImpl::MarkMessageRead(grpc::ServerContext* context,
+                                                  const im::MarkMessageReadRequest* request,
+                                                  im::MarkMessageReadResponse* response) {
+    grpc::Status status = CallContext::Authorize(context, request->user_id());
+    if (!status.ok()) return status;
+    
+    if (request->user_id() <= 0 || request->peer_id() <= 0 ||
+        request->last_read_message_id() <= 0) {
+        response->set_success(false);
+        response->set_message("Invalid read receipt");
+        return grpc::Status::OK;
+    }
+    
+    read_receipts_->Record(request->user_id(), request->peer_id(),
+                           request->last_read_message_id());
+    
+    response->set_success(true);
     return grpc::Status::OK;
 }
 
+void MessageServiceImpl::ToMessage(const MessageRecord& record, im::Message* message) {
+    message->set_id(record.id);
+    message->set_conversation_id(record.conversation_id);
+    message->set_sender_id(record.sender_id);
+    message->set_receiver_id(record.receiver_id);
+    message->set_message_type(record.message_type);
+    message->set_content(record.content);
+    message->set_status(record.status);
+    message->set_timestamp(record.create_time);
+}
+
 }
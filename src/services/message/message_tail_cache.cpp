@@ -0,0 +1,110 @@
+#include "services/message_tail_cache.h"
+#include <algorithm>
+
+namespace ourchat {
+
+MessageTailCache::MessageTailCache(size_t tail_size, size_t max_conversations)
+    : tail_size_(std::max<size_t>(tail_size, 1)),
+      max_per_shard_(std::max<size_t>(max_conversations / kShardCount, 1)) {
+}
+
+MessageTailCache::Shard& MessageTailCache::GetShard(int64_t conversation_id) {
+    uint64_t h = static_cast<uint64_t>(conversation_id) * 0x9E3779B97F4A7C15ULL;
+    return shards_[(h >> 32) % kShardCount];
+}
+
+MessageTailCache::Tail& MessageTailCache::Touch(Shard& shard, int64_t conversation_id) {
+    auto it = shard.tails.find(conversation_id);
+    if (it != shard.tails.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_pos);
+        return it->second;
+    }
+
+    if (shard.tails.size() >= max_per_shard_) {
+        shard.tails.erase(shard.lru.back());
+        shard.lru.pop_back();
+    }
+
+    shard.lru.push_front(conversation_id);
+    Tail& tail = shard.tails[conversation_id];
+    tail.lru_pos = shard.lru.begin();
+    return tail;
+}
+
+void MessageTailCache::Insert(Tail& tail, const im::Message& message) {
+    auto pos = std::lower_bound(tail.messages.begin(), tail.messages.end(), message.id(),
+                                [](const im::Message& m, int64_t id) { return m.id() < id; });
+    if (pos != tail.messages.end() && pos->id() == message.id()) {
+        return;
+    }
+    tail.messages.insert(pos, message);
+
+    while (tail.messages.size() > tail_size_) {
+        tail.messages.pop_front();
+        tail.complete = false;
+    }
+}
+
+bool MessageTailCache::GetPage(int64_t conversation_id, int64_t before_id, int limit,
+                               std::vector<im::Message>* out) {
+    Shard& shard = GetShard(conversation_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.tails.find(conversation_id);
+    if (it == shard.tails.end()) return false;
+
+    const Tail& tail = it->second;
+    auto end = tail.messages.end();
+    if (before_id > 0) {
+        end = std::lower_bound(tail.messages.begin(), tail.messages.end(), before_id,
+                               [](const im::Message& m, int64_t id) { return m.id() < id; });
+    }
+
+    // A partial tail only answers pages that fit entirely inside it.
+    size_t available = end - tail.messages.begin();
+    if (available < static_cast<size_t>(limit) && !tail.complete) return false;
+
+    size_t count = std::min(available, static_cast<size_t>(limit));
+    out->clear();
+    out->reserve(count);
+    for (auto rit = std::make_reverse_iterator(end); count > 0; ++rit, --count) {
+        out->push_back(*rit);
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_pos);
+    return true;
+}
+
+void MessageTailCache::Append(const im::Message& message) {
+    Shard& shard = GetShard(message.conversation_id());
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    Insert(Touch(shard, message.conversation_id()), message);
+}
+
+void MessageTailCache::Fill(int64_t conversation_id, const std::vector<im::Message>& newest_first,
+                            bool complete) {
+    Shard& shard = GetShard(conversation_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    Tail& tail = Touch(shard, conversation_id);
+    if (complete) {
+        tail.complete = true;
+    }
+    for (auto it = newest_first.rbegin(); it != newest_first.rend(); ++it) {
+        Insert(tail, *it);
+    }
+}
+
+void MessageTailCache::Erase(int64_t conversation_id) {
+    Shard& shard = GetShard(conversation_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.tails.find(conversation_id);
+    if (it == shard.tails.end()) return;
+
+    shard.lru.erase(it->second.lru_pos);
+    shard.tails.erase(it);
+}
+
+} // namespace ourchat
@@ -0,0 +1,107 @@
+#include "services/read_receipt_aggregator.h"
+#include "common/logger.h"
+#include "common/time_util.h"
+#include "data/storage.h"
+#include <algorithm>
+
+namespace ourchat {
+
+std::shared_ptr<ReadReceiptAggregator> ReadReceiptAggregator::Instance() {
+    static std::shared_ptr<ReadReceiptAggregator> instance(new ReadReceiptAggregator());
+    return instance;
+}
+
+ReadReceiptAggregator::~ReadReceiptAggregator() {
+    Stop();
+}
+
+void ReadReceiptAggregator::Start(int flush_interval_ms) {
+    if (running_.exchange(true)) return;
+
+    flush_thread_ = std::thread([this, flush_interval_ms]() {
+        while (running_) {
+            {
+                std::unique_lock<std::mutex> lock(wait_mutex_);
+                wait_cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms),
+                                  [this]() { return !running_; });
+            }
+            Flush();
+        }
+    });
+
+    LOG_INFO("Read receipt aggregator started, flush interval " +
+             std::to_string(flush_interval_ms) + "ms");
+}
+
+void ReadReceiptAggregator::Stop() {
+    if (!running_.exchange(false)) return;
+
+    wait_cv_.notify_all();
+    if (flush_thread_.joinable()) {
+        flush_thread_.join();
+    }
+
+    // The thread's last Flush may have swapped a shard before receipts
+    // recorded after it; this is the last chance to write them.
+    Flush();
+}
+
+ReadReceiptAggregator::Shard& ReadReceiptAggregator::GetShard(int64_t user_id) {
+    return shards_[static_cast<uint64_t>(user_id) % kShardCount];
+}
+
+void ReadReceiptAggregator::Record(int64_t user_id, int64_t peer_id, int64_t last_read_message_id) {
+    Merge(Receipt{user_id, peer_id, last_read_message_id, TimeUtil::GetCurrentTimestamp()});
+}
+
+void ReadReceiptAggregator::Merge(const Receipt& receipt) {
+    Shard& shard = GetShard(receipt.user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto result = shard.pending.emplace(std::make_pair(receipt.user_id, receipt.peer_id), receipt);
+    if (!result.second && result.first->second.last_read_message_id < receipt.last_read_message_id) {
+        result.first->second = receipt;
+    }
+}
+
+void ReadReceiptAggregator::Flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+
+    std::vector<Receipt> receipts;
+    for (auto& shard : shards_) {
+        PendingMap pending;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            pending.swap(shard.pending);
+        }
+        for (const auto& entry : pending) {
+            receipts.push_back(entry.second);
+        }
+    }
+
+    if (receipts.empty()) return;
+
+    if (!Storage::Instance()->Messages()->SaveReadReceipts(receipts)) {
+        LOG_ERROR("Failed to flush " + std::to_string(receipts.size()) + " read receipts");
+        // Put them back; anything newer recorded meanwhile still wins.
+        for (const auto& receipt : receipts) {
+            Merge(receipt);
+        }
+        return;
+    }
+
+    Publish(receipts);
+}
+
+void ReadReceiptAggregator::Publish(const std::vector<Receipt>& receipts) {
+    // Fire and forget: against Redis the publishes are pipelined on the
+    // shared async connections instead of holding a pooled connection.
+    auto kv = Storage::Instance()->KV();
+    for (const auto& receipt : receipts) {
+        kv->Publish("read_receipt:" + std::to_string(receipt.peer_id),
+                    std::to_string(receipt.user_id) + ":" +
+                        std::to_string(receipt.last_read_message_id));
+    }
+}
+
+} // namespace ourchat
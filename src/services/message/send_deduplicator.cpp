@@ -0,0 +1,141 @@
+#include "services/send_deduplicator.h"
+#include "common/logger.h"
+#include "data/storage.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace ourchat {
+
+std::shared_ptr<SendDeduplicator> SendDeduplicator::Instance() {
+    static std::shared_ptr<SendDeduplicator> instance(new SendDeduplicator());
+    return instance;
+}
+
+SendDeduplicator::SendDeduplicator()
+    : window_seconds_(300), claim_seconds_(15), shard_capacity_(100000 / kShardCount) {
+}
+
+void SendDeduplicator::Init(const SendDedupConfig& config) {
+    window_seconds_ = std::max(config.window_seconds, 1);
+    claim_seconds_ = std::clamp(config.claim_seconds, 1, window_seconds_);
+    shard_capacity_ = std::max<size_t>(config.local_capacity / kShardCount, 1);
+}
+
+SendDeduplicator::Shard& SendDeduplicator::GetShard(const Key& key) {
+    return shards_[KeyHash()(key) % kShardCount];
+}
+
+std::string SendDeduplicator::RedisKey(const Key& key) {
+    return "dedup:" + std::string(1, static_cast<char>(key.scope)) + ":" +
+           std::to_string(key.sender_id) + ":" + std::to_string(key.client_message_id);
+}
+
+SendDeduplicator::Claim SendDeduplicator::Begin(Scope scope, int64_t sender_id,
+                                                int64_t client_message_id, Result* original) {
+    if (client_message_id == 0) return Claim::kNew;
+
+    Key key{scope, sender_id, client_message_id};
+    {
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end() && it->second.expires_at > Clock::now()) {
+            if (it->second.result.server_message_id == 0) {
+                return Claim::kInFlight;
+            }
+            *original = it->second.result;
+            return Claim::kDuplicate;
+        }
+
+        // Claim locally first so concurrent retries on this node never reach Redis.
+        StoreLocked(shard, key, Result(), claim_seconds_);
+    }
+
+    std::string redis_key = RedisKey(key);
+    auto kv = Storage::Instance()->KV();
+    if (kv->SetNxEx(redis_key, claim_seconds_, "0")) {
+        return Claim::kNew;
+    }
+
+    std::string value = kv->Get(redis_key);
+
+    if (value.empty()) {
+        // Expired in between, or Redis is down (only same-node retries are
+        // caught then): let the send through.
+        return Claim::kNew;
+    }
+
+    // Value is "0" while in flight, "<server_message_id>:<timestamp>" once stored.
+    Result stored;
+    char* end = nullptr;
+    stored.server_message_id = std::strtoll(value.c_str(), &end, 10);
+    if (*end == ':') {
+        stored.timestamp = std::strtoll(end + 1, nullptr, 10);
+    }
+
+    if (stored.server_message_id == 0) {
+        Erase(key);
+        return Claim::kInFlight;
+    }
+
+    Store(key, stored, window_seconds_);
+    *original = stored;
+    return Claim::kDuplicate;
+}
+
+void SendDeduplicator::Complete(Scope scope, int64_t sender_id, int64_t client_message_id,
+                                const Result& result) {
+    if (client_message_id == 0) return;
+
+    Key key{scope, sender_id, client_message_id};
+    Store(key, result, window_seconds_);
+
+    if (!Storage::Instance()->KV()->SetEx(RedisKey(key), window_seconds_,
+                                          std::to_string(result.server_message_id) + ":" +
+                                          std::to_string(result.timestamp))) {
+        LOG_WARN("Failed to record send dedup result for sender " + std::to_string(sender_id));
+    }
+}
+
+void SendDeduplicator::Abort(Scope scope, int64_t sender_id, int64_t client_message_id) {
+    if (client_message_id == 0) return;
+
+    Key key{scope, sender_id, client_message_id};
+    Erase(key);
+
+    Storage::Instance()->KV()->Del(RedisKey(key));
+}
+
+void SendDeduplicator::Store(const Key& key, const Result& result, int seconds) {
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    StoreLocked(shard, key, result, seconds);
+}
+
+void SendDeduplicator::StoreLocked(Shard& shard, const Key& key, const Result& result, int seconds) {
+    auto now = Clock::now();
+    auto expires_at = now + std::chrono::seconds(seconds);
+
+    // The order queue may hold superseded copies of a key; only drop the map
+    // entry when the queued expiry is still the live one.
+    while (!shard.order.empty() &&
+           (shard.order.front().second <= now || shard.entries.size() >= shard_capacity_)) {
+        auto it = shard.entries.find(shard.order.front().first);
+        if (it != shard.entries.end() && it->second.expires_at == shard.order.front().second) {
+            shard.entries.erase(it);
+        }
+        shard.order.pop_front();
+    }
+
+    shard.entries[key] = Entry{result, expires_at};
+    shard.order.emplace_back(key, expires_at);
+}
+
+void SendDeduplicator::Erase(const Key& key) {
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.erase(key);
+}
+
+} // namespace ourchat
@@ -1,11 +1,15 @@
 #include "services/presence_service_impl.h"
 #include "common/logger.h"
+#include "services/call_context.h"
 
 namespace ourchat {
 
 grpc::Status PresenceServiceImpl::SetOnline(grpc::ServerContext* context,
                                              const im::SetOnlineRequest* request,
                                              im::SetOnlineResponse* response) {
+    grpc::Status status = CallContext::Authorize(context, request->user_id());
+    if (!status.ok()) return status;
+    
     LOG_INFO("SetOnline: user_id=" + std::to_string(request->user_id()));
     response->set_success(true);
     return grpc::Status::OK;
@@ -14,6 +18,9 @@ grpc::Status PresenceServiceImpl::SetOnline(grpc::ServerContext* context,
 grpc::Status PresenceServiceImpl::GetOnlineStatus(grpc::ServerContext* context,
                                                     const im::GetOnlineStatusRequest* request,
                                                     im::GetOnlineStatusResponse* response) {
+    grpc::Status status = CallContext::Admit(context);
+    if (!status.ok()) return status;
+    
     LOG_INFO("GetOnlineStatus: user_count=" + std::to_string(request->user_ids().size()));
     return grpc::Status::OK;
 }
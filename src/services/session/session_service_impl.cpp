@@ -1,11 +1,15 @@
 #include "services/session_service_impl.h"
 #include "common/logger.h"
+#include "services/call_context.h"
 
 namespace ourchat {
 
 grpc::Status SessionServiceImpl::GetFriends(grpc::ServerContext* context,
                                              const im::GetFriendsRequest* request,
                                              im::GetFriendsResponse* response) {
+    grpc::Status status = CallContext::Authorize(context, request->user_id());
+    if (!status.ok()) return status;
+    
     LOG_INFO("GetFriends: user_id=" + std::to_string(request->user_id()));
     return grpc::Status::OK;
 }
@@ -13,6 +17,9 @@ grpc::Status SessionServiceImpl::GetFriends(grpc::ServerContext* context,
 grpc::Status SessionServiceImpl::AddFriend(grpc::ServerContext* context,
                                             const im::AddFriendRequest* request,
                                             im::AddFriendResponse* response) {
+    grpc::Status status = CallContext::Authorize(context, request->user_id());
+    if (!status.ok()) return status;
+    
     LOG_INFO("AddFriend: user_id=" + std::to_string(request->user_id()));
     response->set_success(true);
     return grpc::Status::OK;